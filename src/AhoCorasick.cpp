@@ -0,0 +1,117 @@
+#include "AhoCorasick.h"
+#include <algorithm>
+
+uint32_t AhoCorasick::TrieChild(uint32_t state, unsigned char c) const {
+    for (const auto& edge : trieEdges[state]) {
+        if (edge.first == c) return edge.second;
+    }
+    return kNoState;
+}
+
+AhoCorasick::PatternId AhoCorasick::AddPattern(std::string_view pattern) {
+    if (pattern.empty()) return kNoPattern;
+    if (trieEdges.empty()) {
+        trieEdges.emplace_back();
+        statePattern.push_back(kNoPattern);
+    }
+    built = false;
+
+    uint32_t state = kRoot;
+    for (unsigned char c : pattern) {
+        uint32_t child = TrieChild(state, c);
+        if (child == kNoState) {
+            child = static_cast<uint32_t>(trieEdges.size());
+            trieEdges.emplace_back();
+            statePattern.push_back(kNoPattern);
+            trieEdges[state].emplace_back(c, child);
+        }
+        state = child;
+    }
+
+    if (statePattern[state] == kNoPattern) {
+        statePattern[state] = static_cast<PatternId>(patternLengths.size());
+        patternLengths.push_back(static_cast<uint32_t>(pattern.size()));
+        maxPatternLength = std::max(maxPatternLength, static_cast<uint32_t>(pattern.size()));
+    }
+    return statePattern[state];
+}
+
+void AhoCorasick::Build() {
+    if (trieEdges.empty()) {
+        trieEdges.emplace_back();
+        statePattern.push_back(kNoPattern);
+    }
+    const uint32_t stateCount = static_cast<uint32_t>(trieEdges.size());
+
+    // Flatten the edge lists, sorted by byte for binary search
+    edgeStart.assign(stateCount, 0);
+    edgeCount.assign(stateCount, 0);
+    edgeBytes.clear();
+    edgeTargets.clear();
+    for (uint32_t state = 0; state < stateCount; state++) {
+        auto& edges = trieEdges[state];
+        std::sort(edges.begin(), edges.end());
+        edgeStart[state] = static_cast<uint32_t>(edgeBytes.size());
+        edgeCount[state] = static_cast<uint32_t>(edges.size());
+        for (const auto& edge : edges) {
+            edgeBytes.push_back(edge.first);
+            edgeTargets.push_back(edge.second);
+        }
+    }
+
+    // Root transitions are dense: a missing edge loops back to the root
+    std::fill(std::begin(rootNext), std::end(rootNext), kRoot);
+    for (const auto& edge : trieEdges[kRoot]) {
+        rootNext[edge.first] = edge.second;
+    }
+
+    // Breadth-first over the trie so that every failure target is final
+    // before the states that depend on it
+    failLink.assign(stateCount, kRoot);
+    outputLink.assign(stateCount, kNoState);
+    std::vector<uint32_t> queue;
+    queue.reserve(stateCount);
+    for (const auto& edge : trieEdges[kRoot]) {
+        queue.push_back(edge.second);
+    }
+    for (size_t head = 0; head < queue.size(); head++) {
+        uint32_t state = queue[head];
+        uint32_t fail = failLink[state];
+        outputLink[state] = statePattern[fail] != kNoPattern ? fail : outputLink[fail];
+
+        for (const auto& edge : trieEdges[state]) {
+            failLink[edge.second] = Next(fail, edge.first);
+            queue.push_back(edge.second);
+        }
+    }
+
+    built = true;
+}
+
+void AhoCorasick::Clear() {
+    trieEdges.clear();
+    edgeStart.clear();
+    edgeCount.clear();
+    edgeBytes.clear();
+    edgeTargets.clear();
+    failLink.clear();
+    outputLink.clear();
+    statePattern.clear();
+    patternLengths.clear();
+    maxPatternLength = 0;
+    built = false;
+}
+
+uint32_t AhoCorasick::FindEdge(uint32_t state, unsigned char c) const {
+    const unsigned char* first = edgeBytes.data() + edgeStart[state];
+    const unsigned char* last = first + edgeCount[state];
+    if (edgeCount[state] <= 8) {
+        for (const unsigned char* p = first; p != last; p++) {
+            if (*p == c) return edgeTargets[p - edgeBytes.data()];
+        }
+        return kNoState;
+    }
+    const unsigned char* p = std::lower_bound(first, last, c);
+    if (p != last && *p == c) return edgeTargets[p - edgeBytes.data()];
+    return kNoState;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Multi-pattern exact string matcher (Aho-Corasick).
+//
+// Patterns are added once, compiled with Build(), and then any number of
+// buffers can be scanned in a single pass each, independent of the number of
+// patterns. The automaton keeps a dense transition table for the root (where a
+// scan over binary data spends nearly all of its time) and sorted sparse edge
+// lists for every other state, plus failure and output links so that every
+// occurrence of every pattern is reported, including overlapping ones.
+class AhoCorasick {
+public:
+    using PatternId = uint32_t;
+
+    // Adding the same text twice returns the id it got the first time.
+    // Empty patterns are ignored and return kNoPattern.
+    PatternId AddPattern(std::string_view pattern);
+    void Build();
+    void Clear();
+
+    size_t PatternCount() const { return patternLengths.size(); }
+    uint32_t PatternLength(PatternId id) const { return patternLengths[id]; }
+    uint32_t MaxPatternLength() const { return maxPatternLength; }
+
+    // Calls onMatch(id, offset) for every occurrence, where offset is the
+    // position of the first byte of the match in data. Matches are reported in
+    // order of their end position; several patterns ending at the same byte
+    // are reported longest first.
+    template <typename Fn>
+    void Scan(const unsigned char* data, size_t size, Fn&& onMatch) const {
+        if (!built || patternLengths.empty()) return;
+        uint32_t state = kRoot;
+        for (size_t i = 0; i < size; i++) {
+            state = Next(state, data[i]);
+            uint32_t out = statePattern[state] != kNoPattern ? state : outputLink[state];
+            for (; out != kNoState; out = outputLink[out]) {
+                PatternId id = statePattern[out];
+                onMatch(id, i + 1 - patternLengths[id]);
+            }
+        }
+    }
+
+    static constexpr PatternId kNoPattern = 0xFFFFFFFF;
+
+private:
+    static constexpr uint32_t kRoot = 0;
+    static constexpr uint32_t kNoState = 0xFFFFFFFF;
+
+    uint32_t Next(uint32_t state, unsigned char c) const {
+        for (;;) {
+            if (state == kRoot) return rootNext[c];
+            uint32_t target = FindEdge(state, c);
+            if (target != kNoState) return target;
+            state = failLink[state];
+        }
+    }
+    uint32_t FindEdge(uint32_t state, unsigned char c) const;
+    uint32_t TrieChild(uint32_t state, unsigned char c) const;
+
+    // Trie under construction: per-state edge lists, flattened by Build()
+    std::vector<std::vector<std::pair<unsigned char, uint32_t>>> trieEdges;
+
+    // Compiled automaton
+    uint32_t rootNext[256];
+    std::vector<uint32_t> edgeStart;        // per state, into edgeBytes/edgeTargets
+    std::vector<uint32_t> edgeCount;
+    std::vector<unsigned char> edgeBytes;   // sorted within each state
+    std::vector<uint32_t> edgeTargets;
+    std::vector<uint32_t> failLink;
+    // Nearest proper suffix state on the failure chain at which a pattern
+    // ends, kNoState if none
+    std::vector<uint32_t> outputLink;
+    std::vector<PatternId> statePattern;    // pattern ending exactly here
+
+    std::vector<uint32_t> patternLengths;
+    uint32_t maxPatternLength = 0;
+    bool built = false;
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+
+// Compact binary export (script.il2b), an alternative to script.json for
+// pipelines that only need the tables.
+//
+// The file is meant to be memory-mapped and read in place:
+//
+//   BinaryExportHeader
+//   BinaryTypeRecord[typeCount]          at typesOffset
+//   BinaryMethodRecord[methodCount]      at methodsOffset
+//   BinaryFieldRecord[fieldCount]        at fieldsOffset
+//   BinaryPropertyRecord[propertyCount]  at propertiesOffset
+//   string blob (stringsSize bytes)      at stringsOffset
+//
+// All integers are little-endian and every section starts on an 8-byte
+// boundary. Record i of a section describes metadata element i of the same
+// table, so metadata indices (methodStart, declaringType, ...) can be used to
+// index the record arrays directly; kBinaryNoIndex marks absent references.
+// Name fields are byte offsets into the string blob, which holds
+// NUL-terminated UTF-8 strings; offset 0 is always the empty string.
+//
+// Readers must check magic and version, and should step through sections by
+// the record sizes in the header so that fields appended by later minor
+// revisions are skipped.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "The binary export is written in host byte order and requires a little-endian host"
+#endif
+
+constexpr char kBinaryExportMagic[4] = {'I', 'L', '2', 'B'};
+constexpr uint16_t kBinaryExportVersion = 1;
+constexpr uint32_t kBinaryNoIndex = 0xFFFFFFFF;
+
+struct BinaryExportHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;
+    int32_t metadataVersion;
+    uint32_t imageCount;
+
+    uint32_t typeCount;
+    uint32_t methodCount;
+    uint32_t fieldCount;
+    uint32_t propertyCount;
+
+    uint32_t typeRecordSize;
+    uint32_t methodRecordSize;
+    uint32_t fieldRecordSize;
+    uint32_t propertyRecordSize;
+
+    uint64_t typesOffset;
+    uint64_t methodsOffset;
+    uint64_t fieldsOffset;
+    uint64_t propertiesOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+struct BinaryTypeRecord {
+    uint32_t token;
+    uint32_t name;
+    uint32_t namespaceName;
+    uint32_t flags;
+    uint32_t imageIndex;
+    uint32_t parentIndex;
+    uint32_t declaringTypeIndex;
+    uint32_t methodStart;
+    uint32_t fieldStart;
+    uint32_t propertyStart;
+    uint16_t methodCount;
+    uint16_t fieldCount;
+    uint16_t propertyCount;
+    uint16_t reserved;
+};
+
+struct BinaryMethodRecord {
+    uint64_t address;       // Code RVA in the library, 0 if unknown
+    uint32_t token;
+    uint32_t name;
+    uint32_t declaringType;
+    uint32_t returnType;
+    uint16_t flags;
+    uint16_t iflags;
+    uint16_t slot;
+    uint16_t parameterCount;
+};
+
+struct BinaryFieldRecord {
+    uint32_t token;
+    uint32_t name;
+    uint32_t declaringType;
+    uint32_t typeIndex;
+};
+
+struct BinaryPropertyRecord {
+    uint32_t token;
+    uint32_t name;
+    uint32_t getMethod;
+    uint32_t setMethod;
+    uint32_t attrs;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(BinaryExportHeader) == 96, "BinaryExportHeader layout changed");
+static_assert(sizeof(BinaryTypeRecord) == 48, "BinaryTypeRecord layout changed");
+static_assert(sizeof(BinaryMethodRecord) == 32, "BinaryMethodRecord layout changed");
+static_assert(sizeof(BinaryFieldRecord) == 16, "BinaryFieldRecord layout changed");
+static_assert(sizeof(BinaryPropertyRecord) == 24, "BinaryPropertyRecord layout changed");
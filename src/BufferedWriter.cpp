@@ -0,0 +1,126 @@
+#include "BufferedWriter.h"
+#include <charconv>
+
+BufferedWriter::BufferedWriter(size_t bufferSize)
+    : buffer(new char[bufferSize < 64 ? 64 : bufferSize]), capacity(bufferSize < 64 ? 64 : bufferSize),
+      used(0), flushedBytes(0), file(nullptr), failed(false) {}
+
+BufferedWriter::~BufferedWriter() {
+    Close();
+}
+
+bool BufferedWriter::Open(const std::string& path) {
+    Close();
+    used = 0;
+    flushedBytes = 0;
+    failed = false;
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        failed = true;
+        return false;
+    }
+    // Everything goes through our own buffer already
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    return true;
+}
+
+bool BufferedWriter::Close() {
+    if (!file) return !failed;
+    Flush();
+    if (std::fclose(file) != 0) {
+        failed = true;
+    }
+    file = nullptr;
+    return !failed;
+}
+
+bool BufferedWriter::Flush() {
+    if (!file || failed) {
+        // Drop the data so callers cannot grow the buffer past its capacity
+        used = 0;
+        return false;
+    }
+    if (used > 0) {
+        if (std::fwrite(buffer.get(), 1, used, file) != used) {
+            failed = true;
+        }
+        flushedBytes += used;
+        used = 0;
+    }
+    return !failed;
+}
+
+bool BufferedWriter::Rewrite(uint64_t offset, const void* data, size_t size) {
+    if (!Flush()) return false;
+    if (offset + size > flushedBytes) {
+        failed = true;
+        return false;
+    }
+#if defined(_WIN32)
+    bool ok = _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0 &&
+              std::fwrite(data, 1, size, file) == size &&
+              _fseeki64(file, 0, SEEK_END) == 0;
+#else
+    bool ok = fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0 &&
+              std::fwrite(data, 1, size, file) == size &&
+              fseeko(file, 0, SEEK_END) == 0;
+#endif
+    if (!ok) failed = true;
+    return ok;
+}
+
+void BufferedWriter::WriteSlow(std::string_view text) {
+    if (!Flush()) return;
+    if (text.size() >= capacity) {
+        // Larger than the whole buffer: write it through directly
+        if (std::fwrite(text.data(), 1, text.size(), file) != text.size()) {
+            failed = true;
+        }
+        flushedBytes += text.size();
+        return;
+    }
+    std::memcpy(buffer.get(), text.data(), text.size());
+    used = text.size();
+}
+
+void BufferedWriter::WriteDec(uint64_t value) {
+    if (!Reserve(20)) return;
+    char* end = std::to_chars(buffer.get() + used, buffer.get() + capacity, value).ptr;
+    used = end - buffer.get();
+}
+
+void BufferedWriter::WriteDec(int64_t value) {
+    if (!Reserve(21)) return;
+    char* end = std::to_chars(buffer.get() + used, buffer.get() + capacity, value).ptr;
+    used = end - buffer.get();
+}
+
+void BufferedWriter::WriteHex(uint64_t value, unsigned minDigits) {
+    if (!Reserve(16)) return;
+    used = FormatHex(buffer.get() + used, value, minDigits) - buffer.get();
+}
+
+char* FormatHex(char* out, uint64_t value, unsigned minDigits) {
+    static const char digits[] = "0123456789abcdef";
+    unsigned count = 1;
+    while (count < 16 && (value >> (count * 4)) != 0) {
+        count++;
+    }
+    if (minDigits > 16) minDigits = 16;
+    if (count < minDigits) count = minDigits;
+    for (unsigned i = count; i-- > 0;) {
+        out[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return out + count;
+}
+
+void TextBuffer::WriteDec(uint64_t value) {
+    char digits[20];
+    data.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+}
+
+void TextBuffer::WriteDec(int64_t value) {
+    char digits[21];
+    data.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr - digits);
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Writes value as lower-case hex (no prefix), zero-padded to at least
+// minDigits, and returns the end of the text. out must hold 16 characters.
+char* FormatHex(char* out, uint64_t value, unsigned minDigits = 1);
+
+// Append-only output file with a large user-space buffer.
+//
+// Text is formatted straight into the buffer (integers without going through
+// iostream state) and handed to the OS in buffer-sized chunks, so memory use
+// stays fixed no matter how much is written. Write errors are sticky: once a
+// write fails every later call is a no-op and Close() returns false.
+class BufferedWriter {
+public:
+    static constexpr size_t kDefaultBufferSize = 4 * 1024 * 1024;
+
+    explicit BufferedWriter(size_t bufferSize = kDefaultBufferSize);
+    ~BufferedWriter();
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool Open(const std::string& path);
+    // Flushes and closes the file; returns false if any write failed
+    bool Close();
+    bool Flush();
+
+    void Write(std::string_view text) {
+        if (text.size() > capacity - used) {
+            WriteSlow(text);
+            return;
+        }
+        std::memcpy(buffer.get() + used, text.data(), text.size());
+        used += text.size();
+    }
+    void WriteRaw(const void* data, size_t size) {
+        Write(std::string_view(static_cast<const char*>(data), size));
+    }
+    void Put(char c) {
+        if (used == capacity && !Flush()) return;
+        buffer[used++] = c;
+    }
+    void WriteDec(uint64_t value);
+    void WriteDec(int64_t value);
+    void WriteDec(uint32_t value) { WriteDec(static_cast<uint64_t>(value)); }
+    void WriteDec(int32_t value) { WriteDec(static_cast<int64_t>(value)); }
+    // Lower-case hex without prefix, zero-padded to at least minDigits
+    void WriteHex(uint64_t value, unsigned minDigits = 1);
+    // Overwrites already written bytes at offset (e.g. a header whose fields
+    // are only known at the end) and continues appending after that
+    bool Rewrite(uint64_t offset, const void* data, size_t size);
+
+    bool IsOpen() const { return file != nullptr; }
+    bool Failed() const { return failed; }
+    uint64_t BytesWritten() const { return flushedBytes + used; }
+
+private:
+    void WriteSlow(std::string_view text);
+    // Makes room for at least count bytes in the buffer
+    bool Reserve(size_t count) { return capacity - used >= count || Flush(); }
+
+    std::unique_ptr<char[]> buffer;
+    size_t capacity;
+    size_t used;
+    uint64_t flushedBytes;
+    std::FILE* file;
+    bool failed;
+};
+
+// Growable in-memory counterpart of BufferedWriter with the same formatting
+// interface, for rendering output on worker threads before it is written out
+// in order. Clear() keeps the allocation for reuse.
+class TextBuffer {
+public:
+    void Write(std::string_view text) { data.append(text.data(), text.size()); }
+    void WriteRaw(const void* data, size_t size) {
+        Write(std::string_view(static_cast<const char*>(data), size));
+    }
+    void Put(char c) { data.push_back(c); }
+    void WriteDec(uint64_t value);
+    void WriteDec(int64_t value);
+    void WriteDec(uint32_t value) { WriteDec(static_cast<uint64_t>(value)); }
+    void WriteDec(int32_t value) { WriteDec(static_cast<int64_t>(value)); }
+    void WriteHex(uint64_t value, unsigned minDigits = 1) {
+        char digits[16];
+        data.append(digits, FormatHex(digits, value, minDigits) - digits);
+    }
+
+    std::string_view View() const { return data; }
+    size_t Size() const { return data.size(); }
+    void Clear() { data.clear(); }
+
+private:
+    std::string data;
+};
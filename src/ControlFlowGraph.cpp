@@ -0,0 +1,239 @@
+#include "ControlFlowGraph.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+
+// Backstop for functions whose end is never found: no function is swept
+// further than this from its start
+constexpr uint64_t kMaxFunctionSize = 1 << 20;
+
+// A function to sweep: where it is and how far it may extend
+struct SweepTarget {
+    uint64_t address;
+    uint64_t offset;
+    uint64_t maxSize;
+};
+
+// Output of one ParallelFor chunk, concatenated in order afterwards
+struct SweepChunk {
+    std::vector<ControlFlowGraph::Function> functions;  // firstBlock relative to blocks
+    std::vector<ControlFlowGraph::Block> blocks;
+    size_t edgeCount = 0;
+};
+
+// Reused per worker so that sweeping does not allocate per function
+struct SweepScratch {
+    std::vector<Instruction> instructions;
+    std::vector<uint32_t> leaders;      // Offsets that start a block
+    std::vector<const Instruction*> terminators;  // Last instruction of each block
+};
+
+uint32_t FindBlock(const std::vector<ControlFlowGraph::Block>& blocks, size_t first, uint32_t offset) {
+    auto begin = blocks.begin() + first;
+    auto it = std::lower_bound(begin, blocks.end(), offset,
+                               [](const ControlFlowGraph::Block& block, uint32_t value) { return block.offset < value; });
+    if (it == blocks.end() || it->offset != offset) return ControlFlowGraph::kNoBlock;
+    return static_cast<uint32_t>(it - begin);
+}
+
+void SweepFunction(const InstructionDecoder& decoder, const unsigned char* code, const SweepTarget& target,
+                   SweepScratch& scratch, SweepChunk& out) {
+    std::vector<Instruction>& instructions = scratch.instructions;
+    std::vector<uint32_t>& leaders = scratch.leaders;
+    instructions.clear();
+    leaders.clear();
+    leaders.push_back(0);
+
+    // Linear sweep. The function ends at the first instruction that ends a
+    // block with no known branch going further; whatever follows (padding,
+    // runtime or native code) belongs to no managed method.
+    const uint64_t maxSize = std::min(target.maxSize, kMaxFunctionSize);
+    uint64_t furthestTarget = 0;
+    uint64_t pos = 0;
+    while (pos < maxSize) {
+        Instruction ins;
+        if (!decoder.Decode(code + pos, maxSize - pos, target.address + pos, ins)) {
+            ins.length = static_cast<uint8_t>(std::min<uint64_t>(decoder.MinLength(), maxSize - pos));
+            ins.flow = InstructionFlow::Invalid;
+        }
+        instructions.push_back(ins);
+        pos += ins.length;
+
+        if (ins.HasTarget() && ins.flow != InstructionFlow::Call &&
+            ins.target >= target.address && ins.target - target.address < maxSize) {
+            uint64_t offset = ins.target - target.address;
+            leaders.push_back(static_cast<uint32_t>(offset));
+            furthestTarget = std::max(furthestTarget, offset);
+        }
+        if (!ins.EndsBlock()) continue;
+        if (furthestTarget < pos) break;
+        leaders.push_back(static_cast<uint32_t>(pos));
+    }
+    std::sort(leaders.begin(), leaders.end());
+    leaders.erase(std::unique(leaders.begin(), leaders.end()), leaders.end());
+
+    // Cut the instruction stream into blocks at leaders and after
+    // block-ending instructions
+    ControlFlowGraph::Function function = {};
+    function.address = target.address;
+    function.firstBlock = static_cast<uint32_t>(out.blocks.size());
+    function.instructionCount = static_cast<uint32_t>(instructions.size());
+    const size_t firstBlock = out.blocks.size();
+    scratch.terminators.clear();
+    size_t nextLeader = 0;
+    for (size_t i = 0; i < instructions.size();) {
+        const uint32_t start = static_cast<uint32_t>(instructions[i].address - target.address);
+        ControlFlowGraph::Block block = {};
+        block.offset = start;
+        block.successors[0] = block.successors[1] = ControlFlowGraph::kNoBlock;
+        uint32_t count = 0;
+        uint32_t end = start;
+        for (; i < instructions.size(); ) {
+            const Instruction& ins = instructions[i];
+            end = static_cast<uint32_t>(ins.address - target.address) + ins.length;
+            count++;
+            i++;
+            if (ins.EndsBlock() || i == instructions.size()) break;
+            const uint32_t next = static_cast<uint32_t>(instructions[i].address - target.address);
+            if (next != end) break;
+            while (nextLeader < leaders.size() && leaders[nextLeader] < next) nextLeader++;
+            if (nextLeader < leaders.size() && leaders[nextLeader] == next) break;
+        }
+        block.size = end - start;
+        block.instructionCount = static_cast<uint16_t>(std::min<uint32_t>(count, 0xFFFF));
+        block.terminator = instructions[i - 1].flow;
+        scratch.terminators.push_back(&instructions[i - 1]);
+        out.blocks.push_back(block);
+        function.size = end;
+    }
+    function.blockCount = static_cast<uint32_t>(out.blocks.size() - firstBlock);
+
+    // Edges: the taken branch first, then the fall-through
+    for (size_t b = firstBlock; b < out.blocks.size(); b++) {
+        ControlFlowGraph::Block& block = out.blocks[b];
+        const Instruction& last = *scratch.terminators[b - firstBlock];
+        if (last.flow == InstructionFlow::Jump || last.flow == InstructionFlow::ConditionalJump) {
+            if (last.target >= target.address && last.target - target.address < function.size) {
+                block.successors[0] = FindBlock(out.blocks, firstBlock, static_cast<uint32_t>(last.target - target.address));
+            } else {
+                block.flags |= ControlFlowGraph::kBlockExternalTarget;
+            }
+        }
+        const bool fallsThrough = last.flow == InstructionFlow::Sequential || last.flow == InstructionFlow::Call ||
+                                  last.flow == InstructionFlow::IndirectCall || last.flow == InstructionFlow::ConditionalJump;
+        if (fallsThrough && b + 1 < out.blocks.size() && out.blocks[b + 1].offset == block.offset + block.size) {
+            block.successors[1] = static_cast<uint32_t>(b + 1 - firstBlock);
+        }
+        if (last.flow == InstructionFlow::Invalid) block.flags |= ControlFlowGraph::kBlockInvalid;
+        for (uint32_t successor : block.successors) {
+            if (successor != ControlFlowGraph::kNoBlock) out.edgeCount++;
+        }
+    }
+    out.functions.push_back(function);
+}
+
+} // namespace
+
+bool ControlFlowGraph::Build(const ElfImage& elf, const char* bytes, std::vector<uint64_t> starts, ThreadPool& pool) {
+    Clear();
+    if (!elf.IsValid() || !InstructionDecoder::IsSupported(elf.GetMachine())) return false;
+    image = &elf;
+    data = bytes;
+    machine = elf.GetMachine();
+
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+    // Each function may run up to the next start, but not out of the
+    // executable range it begins in
+    const std::vector<ElfImage::FileRange>& ranges = elf.GetExecutableRanges();
+    std::vector<SweepTarget> targets;
+    targets.reserve(starts.size());
+    for (size_t i = 0; i < starts.size(); i++) {
+        uint64_t offset;
+        if (starts[i] == 0 || !elf.VaToOffset(starts[i], offset)) continue;
+        auto range = std::upper_bound(ranges.begin(), ranges.end(), offset,
+                                      [](uint64_t value, const ElfImage::FileRange& r) { return value < r.begin; });
+        if (range == ranges.begin() || offset >= (range - 1)->end) continue;
+        uint64_t maxSize = (range - 1)->end - offset;
+        if (i + 1 < starts.size()) maxSize = std::min(maxSize, starts[i + 1] - starts[i]);
+        targets.push_back({starts[i], offset, maxSize});
+    }
+
+    const InstructionDecoder decoder(machine);
+    const unsigned char* code = reinterpret_cast<const unsigned char*>(data);
+    constexpr size_t kFunctionsPerChunk = 256;
+    std::vector<SweepChunk> chunks((targets.size() + kFunctionsPerChunk - 1) / kFunctionsPerChunk);
+    std::vector<SweepScratch> scratch(pool.GetThreadCount());
+    pool.ParallelFor(chunks.size(), 1, [&](size_t first, size_t last, unsigned worker) {
+        for (size_t c = first; c < last; c++) {
+            const size_t end = std::min(targets.size(), (c + 1) * kFunctionsPerChunk);
+            for (size_t t = c * kFunctionsPerChunk; t < end; t++) {
+                SweepFunction(decoder, code + targets[t].offset, targets[t], scratch[worker], chunks[c]);
+            }
+        }
+    });
+
+    // Concatenate in address order
+    size_t functionTotal = 0, blockTotal = 0;
+    for (const SweepChunk& chunk : chunks) {
+        functionTotal += chunk.functions.size();
+        blockTotal += chunk.blocks.size();
+    }
+    functions.reserve(functionTotal);
+    blocks.reserve(blockTotal);
+    for (SweepChunk& chunk : chunks) {
+        const uint32_t base = static_cast<uint32_t>(blocks.size());
+        for (Function function : chunk.functions) {
+            function.firstBlock += base;
+            functions.push_back(function);
+        }
+        blocks.insert(blocks.end(), chunk.blocks.begin(), chunk.blocks.end());
+        edgeCount += chunk.edgeCount;
+        chunk = SweepChunk();
+    }
+    return true;
+}
+
+void ControlFlowGraph::Clear() {
+    image = nullptr;
+    data = nullptr;
+    machine = ElfImage::Machine::Unknown;
+    functions.clear();
+    functions.shrink_to_fit();
+    blocks.clear();
+    blocks.shrink_to_fit();
+    edgeCount = 0;
+}
+
+size_t ControlFlowGraph::FindFunction(uint64_t va) const {
+    auto it = std::upper_bound(functions.begin(), functions.end(), va,
+                               [](uint64_t value, const Function& function) { return value < function.address; });
+    if (it == functions.begin()) return functions.size();
+    --it;
+    if (va - it->address >= it->size) return functions.size();
+    return static_cast<size_t>(it - functions.begin());
+}
+
+const unsigned char* ControlFlowGraph::GetCode(const Function& function) const {
+    uint64_t offset;
+    if (!image || !image->VaToOffset(function.address, offset)) return nullptr;
+    return reinterpret_cast<const unsigned char*>(data) + offset;
+}
+
+void ControlFlowGraph::DecodeBlock(const Function& function, const Block& block, std::vector<Instruction>& out) const {
+    uint64_t offset;
+    const uint64_t address = function.address + block.offset;
+    if (!image || !image->VaToOffset(address, offset)) return;
+    const InstructionDecoder decoder(machine);
+    const unsigned char* code = reinterpret_cast<const unsigned char*>(data) + offset;
+    for (uint32_t pos = 0; pos < block.size;) {
+        Instruction ins;
+        if (!decoder.Decode(code + pos, block.size - pos, address + pos, ins)) {
+            ins.length = static_cast<uint8_t>(std::min<uint32_t>(decoder.MinLength(), block.size - pos));
+        }
+        out.push_back(ins);
+        pos += ins.length;
+    }
+}
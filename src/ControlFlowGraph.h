@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ElfImage.h"
+#include "InstructionDecoder.h"
+
+class ThreadPool;
+
+// Basic blocks and control flow edges of every function in a library, found
+// by a linear sweep from known function starts.
+//
+// The graph is stored flat so a million functions fit in memory: one array
+// of functions, each owning a contiguous slice of one shared block array.
+// Blocks are 20 bytes, address their successors by index within the
+// function, and do not keep their instructions; DecodeBlock() re-decodes
+// them on demand.
+class ControlFlowGraph {
+public:
+    static constexpr uint32_t kNoBlock = 0xFFFFFFFF;
+
+    struct Block {
+        uint32_t offset;            // From the function start
+        uint32_t size;
+        uint32_t successors[2];     // Taken branch / fall through, kNoBlock if absent
+        uint16_t instructionCount;  // Saturates at 0xFFFF
+        InstructionFlow terminator; // Flow of the last instruction
+        uint8_t flags;
+    };
+    // Block::flags
+    static constexpr uint8_t kBlockExternalTarget = 1;  // Branches out of the function (tail call)
+    static constexpr uint8_t kBlockInvalid = 2;         // Ends in bytes that did not decode
+
+    struct Function {
+        uint64_t address;           // VA
+        uint32_t size;              // Bytes swept, excluding trailing padding
+        uint32_t firstBlock;        // Into the shared block array
+        uint32_t blockCount;
+        uint32_t instructionCount;
+    };
+
+    // Sweeps every function. starts are VAs (in any order, duplicates
+    // allowed); each function extends to the next start or the end of its
+    // executable range. Functions that are not in an executable range are
+    // dropped. Returns false if the machine is not supported.
+    bool Build(const ElfImage& image, const char* data, std::vector<uint64_t> starts, ThreadPool& pool);
+    void Clear();
+
+    bool IsEmpty() const { return functions.empty(); }
+    size_t FunctionCount() const { return functions.size(); }
+    size_t BlockCount() const { return blocks.size(); }
+    size_t EdgeCount() const { return edgeCount; }
+    size_t MemoryUsage() const { return functions.capacity() * sizeof(Function) + blocks.capacity() * sizeof(Block); }
+
+    ElfImage::Machine GetMachine() const { return machine; }
+    const Function& GetFunction(size_t index) const { return functions[index]; }
+    const Block* GetBlocks(const Function& function) const { return blocks.data() + function.firstBlock; }
+    // Bytes of the function in the mapped library, nullptr if unmapped
+    const unsigned char* GetCode(const Function& function) const;
+    // Index of the function containing va, or FunctionCount() if none
+    size_t FindFunction(uint64_t va) const;
+
+    // Appends the instructions of a block to out
+    void DecodeBlock(const Function& function, const Block& block, std::vector<Instruction>& out) const;
+
+private:
+    const ElfImage* image = nullptr;
+    const char* data = nullptr;
+    ElfImage::Machine machine = ElfImage::Machine::Unknown;
+    std::vector<Function> functions;    // Sorted by address
+    std::vector<Block> blocks;
+    size_t edgeCount = 0;
+};
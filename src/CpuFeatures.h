@@ -0,0 +1,33 @@
+#pragma once
+
+// Runtime CPU feature checks for the SIMD kernels.
+//
+// Kernels are compiled for the baseline target (SSE2 on x86-64) and, where the
+// compiler supports per-function targets, additionally for AVX2/SSSE3. The
+// wider variants are only called after checking the running CPU.
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define IL2CPP_X86_DISPATCH 1
+#define IL2CPP_TARGET(features) __attribute__((target(features)))
+#else
+#define IL2CPP_X86_DISPATCH 0
+#define IL2CPP_TARGET(features)
+#endif
+
+inline bool CpuHasAVX2() {
+#if IL2CPP_X86_DISPATCH
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+inline bool CpuHasSSSE3() {
+#if IL2CPP_X86_DISPATCH
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+#else
+    return false;
+#endif
+}
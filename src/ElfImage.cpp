@@ -0,0 +1,420 @@
+#include "ElfImage.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// On-disk structures, declared here rather than taken from <elf.h> so that
+// the parser builds on every host
+
+constexpr uint32_t kPtLoad = 1;
+constexpr uint32_t kPtDynamic = 2;
+constexpr uint32_t kShtProgbits = 1;
+constexpr uint64_t kShfAlloc = 2;
+constexpr uint64_t kShfExecInstr = 4;
+
+constexpr int64_t kDtNull = 0;
+constexpr int64_t kDtRela = 7;
+constexpr int64_t kDtRelaSize = 8;
+constexpr int64_t kDtRelaEnt = 9;
+constexpr int64_t kDtRel = 17;
+constexpr int64_t kDtRelSize = 18;
+constexpr int64_t kDtRelEnt = 19;
+constexpr int64_t kDtRelrSize = 35;
+constexpr int64_t kDtRelr = 36;
+
+constexpr uint16_t kEm386 = 3;
+constexpr uint16_t kEmArm = 40;
+constexpr uint16_t kEmX86_64 = 62;
+constexpr uint16_t kEmAArch64 = 183;
+
+struct Elf32Traits {
+    using Word = uint32_t;
+    using SignedWord = int32_t;
+    struct Ehdr {
+        unsigned char ident[16];
+        uint16_t type, machine;
+        uint32_t version, entry, phoff, shoff, flags;
+        uint16_t ehsize, phentsize, phnum, shentsize, shnum, shstrndx;
+    };
+    struct Phdr {
+        uint32_t type, offset, vaddr, paddr, filesz, memsz, flags, align;
+    };
+    struct Shdr {
+        uint32_t name, type, flags, addr, offset, size, link, info, addralign, entsize;
+    };
+    struct Dyn {
+        int32_t tag;
+        uint32_t val;
+    };
+    struct Rel {
+        uint32_t offset, info;
+    };
+    struct Rela {
+        uint32_t offset, info;
+        int32_t addend;
+    };
+    static uint32_t RelocationType(Word info) { return info & 0xFF; }
+};
+
+struct Elf64Traits {
+    using Word = uint64_t;
+    using SignedWord = int64_t;
+    struct Ehdr {
+        unsigned char ident[16];
+        uint16_t type, machine;
+        uint32_t version;
+        uint64_t entry, phoff, shoff;
+        uint32_t flags;
+        uint16_t ehsize, phentsize, phnum, shentsize, shnum, shstrndx;
+    };
+    struct Phdr {
+        uint32_t type, flags;
+        uint64_t offset, vaddr, paddr, filesz, memsz, align;
+    };
+    struct Shdr {
+        uint32_t name, type;
+        uint64_t flags, addr, offset, size;
+        uint32_t link, info;
+        uint64_t addralign, entsize;
+    };
+    struct Dyn {
+        int64_t tag;
+        uint64_t val;
+    };
+    struct Rel {
+        uint64_t offset, info;
+    };
+    struct Rela {
+        uint64_t offset, info;
+        int64_t addend;
+    };
+    static uint32_t RelocationType(Word info) { return static_cast<uint32_t>(info & 0xFFFFFFFF); }
+};
+
+template <typename T>
+bool ReadAt(const char* data, size_t size, uint64_t offset, T& out) {
+    if (offset > size || sizeof(T) > size - offset) return false;
+    memcpy(&out, data + offset, sizeof(T));
+    return true;
+}
+
+uint32_t RelativeRelocationType(ElfImage::Machine machine) {
+    switch (machine) {
+        case ElfImage::Machine::ARM64:  return 1027;  // R_AARCH64_RELATIVE
+        case ElfImage::Machine::ARM:    return 23;    // R_ARM_RELATIVE
+        case ElfImage::Machine::X86_64: return 8;     // R_X86_64_RELATIVE
+        case ElfImage::Machine::X86:    return 8;     // R_386_RELATIVE
+        default:                        return 0;
+    }
+}
+
+void MergeRanges(std::vector<ElfImage::FileRange>& ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](const ElfImage::FileRange& a, const ElfImage::FileRange& b) {
+        return a.begin < b.begin;
+    });
+    size_t out = 0;
+    for (const auto& range : ranges) {
+        if (range.begin >= range.end) continue;
+        if (out > 0 && range.begin <= ranges[out - 1].end) {
+            ranges[out - 1].end = std::max(ranges[out - 1].end, range.end);
+        } else {
+            ranges[out++] = range;
+        }
+    }
+    ranges.resize(out);
+}
+
+} // namespace
+
+bool ElfImage::Parse(const char* bytes, size_t length) {
+    Clear();
+    data = bytes;
+    size = length;
+
+    if (size < 16 || memcmp(data, "\x7F" "ELF", 4) != 0) {
+        error = "not an ELF image";
+        return false;
+    }
+    if (data[5] != 1) {
+        error = "big-endian ELF images are not supported";
+        return false;
+    }
+    bool ok;
+    if (data[4] == 2) {
+        is64 = true;
+        ok = ParseImage<Elf64Traits>();
+    } else if (data[4] == 1) {
+        ok = ParseImage<Elf32Traits>();
+    } else {
+        error = "unknown ELF class";
+        return false;
+    }
+    if (!ok) {
+        segments.clear();
+        sections.clear();
+        addends.clear();
+        relocationCount = 0;
+        return false;
+    }
+    valid = true;
+    return true;
+}
+
+void ElfImage::Clear() {
+    data = nullptr;
+    size = 0;
+    valid = false;
+    is64 = false;
+    machine = Machine::Unknown;
+    error.clear();
+    imageBase = 0;
+    segments.clear();
+    sections.clear();
+    executableRanges.clear();
+    dataRanges.clear();
+    addends.clear();
+    relocationCount = 0;
+}
+
+template <typename Traits>
+bool ElfImage::ParseImage() {
+    typename Traits::Ehdr ehdr;
+    if (!ReadAt(data, size, 0, ehdr)) {
+        error = "truncated ELF header";
+        return false;
+    }
+    switch (ehdr.machine) {
+        case kEm386:     machine = Machine::X86; break;
+        case kEmX86_64:  machine = Machine::X86_64; break;
+        case kEmArm:     machine = Machine::ARM; break;
+        case kEmAArch64: machine = Machine::ARM64; break;
+        default:
+            error = "unsupported machine type " + std::to_string(ehdr.machine);
+            return false;
+    }
+
+    // Program headers: loadable segments and the dynamic table
+    std::vector<Segment> dynamicSegments;
+    if (ehdr.phnum > 0 && ehdr.phentsize < sizeof(typename Traits::Phdr)) {
+        error = "invalid program header size";
+        return false;
+    }
+    for (uint16_t i = 0; i < ehdr.phnum; i++) {
+        typename Traits::Phdr phdr;
+        if (!ReadAt(data, size, static_cast<uint64_t>(ehdr.phoff) + static_cast<uint64_t>(i) * ehdr.phentsize, phdr)) {
+            error = "truncated program header table";
+            return false;
+        }
+        Segment segment = {phdr.vaddr, phdr.memsz, phdr.offset, phdr.filesz, phdr.flags};
+        if (phdr.type == kPtLoad) {
+            segments.push_back(segment);
+        } else if (phdr.type == kPtDynamic) {
+            dynamicSegments.push_back(segment);
+        }
+    }
+    if (segments.empty()) {
+        error = "no loadable segments";
+        return false;
+    }
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) { return a.vaddr < b.vaddr; });
+    imageBase = segments.front().vaddr;
+
+    // Section headers are optional (stripped or packed images)
+    if (ehdr.shnum > 0 && ehdr.shentsize >= sizeof(typename Traits::Shdr)) {
+        std::vector<typename Traits::Shdr> headers;
+        for (uint16_t i = 0; i < ehdr.shnum; i++) {
+            typename Traits::Shdr shdr;
+            if (!ReadAt(data, size, static_cast<uint64_t>(ehdr.shoff) + static_cast<uint64_t>(i) * ehdr.shentsize, shdr)) {
+                headers.clear();
+                break;
+            }
+            headers.push_back(shdr);
+        }
+        const typename Traits::Shdr* names = ehdr.shstrndx < headers.size() ? &headers[ehdr.shstrndx] : nullptr;
+        for (const auto& shdr : headers) {
+            Section section = {std::string(), shdr.type, shdr.flags, shdr.addr, shdr.offset, shdr.size};
+            if (names && shdr.name < names->size && names->offset + shdr.name < size) {
+                const char* name = data + names->offset + shdr.name;
+                size_t maxLength = std::min<uint64_t>(names->size - shdr.name, size - (names->offset + shdr.name));
+                section.name.assign(name, strnlen(name, maxLength));
+            }
+            sections.push_back(std::move(section));
+        }
+    }
+
+    for (const Segment& dynamic : dynamicSegments) {
+        ParseDynamic<Traits>(dynamic);
+    }
+    // Sorted for ReadPointer; of repeated addresses the last entry wins, as
+    // it would for the loader
+    std::stable_sort(addends.begin(), addends.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    auto last = addends.begin();
+    for (auto it = addends.begin(); it != addends.end(); ++it) {
+        if (last != addends.begin() && (last - 1)->first == it->first) *(last - 1) = *it;
+        else *last++ = *it;
+    }
+    addends.erase(last, addends.end());
+    BuildRanges();
+    return true;
+}
+
+template <typename Traits>
+void ElfImage::ParseDynamic(const Segment& dynamic) {
+    using Word = typename Traits::Word;
+    uint64_t rela = 0, relaSize = 0, relaEnt = sizeof(typename Traits::Rela);
+    uint64_t rel = 0, relSize = 0, relEnt = sizeof(typename Traits::Rel);
+    uint64_t relr = 0, relrSize = 0;
+
+    for (uint64_t offset = dynamic.offset; offset + sizeof(typename Traits::Dyn) <= dynamic.offset + dynamic.fileSize;
+         offset += sizeof(typename Traits::Dyn)) {
+        typename Traits::Dyn dyn;
+        if (!ReadAt(data, size, offset, dyn) || dyn.tag == kDtNull) break;
+        switch (dyn.tag) {
+            case kDtRela:     rela = dyn.val; break;
+            case kDtRelaSize: relaSize = dyn.val; break;
+            case kDtRelaEnt:  relaEnt = dyn.val; break;
+            case kDtRel:      rel = dyn.val; break;
+            case kDtRelSize:  relSize = dyn.val; break;
+            case kDtRelEnt:   relEnt = dyn.val; break;
+            case kDtRelr:     relr = dyn.val; break;
+            case kDtRelrSize: relrSize = dyn.val; break;
+            default: break;
+        }
+    }
+
+    const uint32_t relativeType = RelativeRelocationType(machine);
+    uint64_t tableOffset;
+
+    // RELA: the relocated pointer is the addend
+    if (rela && relaEnt >= sizeof(typename Traits::Rela) && VaToOffset(rela, tableOffset)) {
+        for (uint64_t i = 0; i + relaEnt <= relaSize; i += relaEnt) {
+            typename Traits::Rela entry;
+            if (!ReadAt(data, size, tableOffset + i, entry)) break;
+            if (Traits::RelocationType(entry.info) == relativeType) {
+                addends.emplace_back(entry.offset, static_cast<uint64_t>(static_cast<int64_t>(entry.addend)) & (is64 ? ~uint64_t(0) : 0xFFFFFFFFu));
+                relocationCount++;
+            }
+        }
+    }
+
+    // REL and RELR: the addend is stored in the relocated word itself, so
+    // they are only counted
+    if (rel && relEnt >= sizeof(typename Traits::Rel) && VaToOffset(rel, tableOffset)) {
+        for (uint64_t i = 0; i + relEnt <= relSize; i += relEnt) {
+            typename Traits::Rel entry;
+            if (!ReadAt(data, size, tableOffset + i, entry)) break;
+            relocationCount += Traits::RelocationType(entry.info) == relativeType;
+        }
+    }
+    if (relr && VaToOffset(relr, tableOffset)) {
+        // Packed relative relocations: an even entry is an address, an odd
+        // entry a bitmap over the words following the previous address
+        for (uint64_t i = 0; i + sizeof(Word) <= relrSize; i += sizeof(Word)) {
+            Word entry;
+            if (!ReadAt(data, size, tableOffset + i, entry)) break;
+            if ((entry & 1) == 0) {
+                relocationCount++;
+                continue;
+            }
+            for (uint64_t bits = static_cast<uint64_t>(entry) >> 1; bits != 0; bits &= bits - 1) {
+                relocationCount++;
+            }
+        }
+    }
+}
+
+void ElfImage::BuildRanges() {
+    executableRanges.clear();
+    dataRanges.clear();
+
+    for (const Section& section : sections) {
+        if (section.type != kShtProgbits || !(section.flags & kShfAlloc)) continue;
+        if (section.offset >= size) continue;
+        FileRange range = {section.offset, std::min<uint64_t>(section.offset + section.size, size)};
+        if (section.flags & kShfExecInstr) {
+            executableRanges.push_back(range);
+        } else {
+            dataRanges.push_back(range);
+        }
+    }
+
+    if (executableRanges.empty() && dataRanges.empty()) {
+        // No usable section headers: classify whole segments
+        for (const Segment& segment : segments) {
+            if (segment.offset >= size) continue;
+            FileRange range = {segment.offset, std::min<uint64_t>(segment.offset + segment.fileSize, size)};
+            (segment.IsExecutable() ? executableRanges : dataRanges).push_back(range);
+        }
+    }
+
+    MergeRanges(executableRanges);
+    MergeRanges(dataRanges);
+}
+
+const char* ElfImage::GetMachineName() const {
+    switch (machine) {
+        case Machine::X86:    return "x86";
+        case Machine::X86_64: return "x86-64";
+        case Machine::ARM:    return "ARM";
+        case Machine::ARM64:  return "ARM64";
+        default:              return "unknown";
+    }
+}
+
+const ElfImage::Section* ElfImage::FindSection(const std::string& name) const {
+    for (const Section& section : sections) {
+        if (section.name == name) return &section;
+    }
+    return nullptr;
+}
+
+bool ElfImage::VaToOffset(uint64_t va, uint64_t& offset) const {
+    // Segments are sorted by address; find the last one starting at or below va
+    auto it = std::upper_bound(segments.begin(), segments.end(), va,
+                               [](uint64_t value, const Segment& segment) { return value < segment.vaddr; });
+    if (it == segments.begin()) return false;
+    const Segment& segment = *(it - 1);
+    uint64_t delta = va - segment.vaddr;
+    // Addresses in the zero-filled tail (.bss) have no file bytes
+    if (delta >= segment.fileSize) return false;
+    offset = segment.offset + delta;
+    return offset < size;
+}
+
+bool ElfImage::OffsetToVa(uint64_t offset, uint64_t& va) const {
+    for (const Segment& segment : segments) {
+        if (offset >= segment.offset && offset - segment.offset < segment.fileSize) {
+            va = segment.vaddr + (offset - segment.offset);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ElfImage::ReadPointer(uint64_t va, uint64_t& value) const {
+    auto it = std::lower_bound(addends.begin(), addends.end(), va,
+                               [](const std::pair<uint64_t, uint64_t>& entry, uint64_t value) { return entry.first < value; });
+    if (it != addends.end() && it->first == va) {
+        value = it->second;
+        return true;
+    }
+    uint64_t offset;
+    if (!VaToOffset(va, offset)) return false;
+    if (is64) {
+        uint64_t pointer;
+        if (!ReadAt(data, size, offset, pointer)) return false;
+        value = pointer;
+    } else {
+        uint32_t pointer;
+        if (!ReadAt(data, size, offset, pointer)) return false;
+        value = pointer;
+    }
+    return true;
+}
+
+bool ElfImage::Read32(uint64_t va, uint32_t& value) const {
+    uint64_t offset;
+    return VaToOffset(va, offset) && ReadAt(data, size, offset, value);
+}
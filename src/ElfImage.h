@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Read-only index over an ELF shared object held in memory (the mapped
+// libil2cpp.so).
+//
+// Parses the ELF, program and section headers of 32- and 64-bit little-endian
+// images for ARM, AArch64, x86 and x86-64, and provides translation between
+// file offsets and virtual addresses, the file ranges that hold code and data,
+// and pointer reads that see the values the dynamic loader would write for
+// RELATIVE relocations (pointers in .data.rel.ro are usually 0 in the file).
+class ElfImage {
+public:
+    enum class Machine { Unknown, X86, X86_64, ARM, ARM64 };
+
+    struct Segment {
+        uint64_t vaddr;
+        uint64_t memSize;
+        uint64_t offset;
+        uint64_t fileSize;
+        uint32_t flags;     // PF_X = 1, PF_W = 2, PF_R = 4
+        bool IsExecutable() const { return flags & 1; }
+        bool IsWritable() const { return flags & 2; }
+    };
+
+    struct Section {
+        std::string name;
+        uint32_t type;
+        uint64_t flags;     // SHF_WRITE = 1, SHF_ALLOC = 2, SHF_EXECINSTR = 4
+        uint64_t addr;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // Half-open file range [begin, end)
+    struct FileRange {
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // Returns false (with GetError()) if data is not a supported ELF image
+    bool Parse(const char* data, size_t size);
+    void Clear();
+
+    bool IsValid() const { return valid; }
+    bool Is64Bit() const { return is64; }
+    Machine GetMachine() const { return machine; }
+    const char* GetMachineName() const;
+    const std::string& GetError() const { return error; }
+    size_t PointerSize() const { return is64 ? 8 : 4; }
+
+    const std::vector<Segment>& GetSegments() const { return segments; }
+    const std::vector<Section>& GetSections() const { return sections; }
+    const Section* FindSection(const std::string& name) const;
+
+    // Lowest virtual address of any PT_LOAD segment
+    uint64_t GetImageBase() const { return imageBase; }
+
+    bool VaToOffset(uint64_t va, uint64_t& offset) const;
+    bool OffsetToVa(uint64_t offset, uint64_t& va) const;
+
+    // File ranges holding machine code and initialized non-code data. Taken
+    // from the section headers when present (so .rodata in an executable
+    // segment still counts as data), otherwise from the PT_LOAD flags. Sorted
+    // and non-overlapping.
+    const std::vector<FileRange>& GetExecutableRanges() const { return executableRanges; }
+    const std::vector<FileRange>& GetDataRanges() const { return dataRanges; }
+
+    // Reads a target-sized pointer at va, applying RELATIVE relocations
+    bool ReadPointer(uint64_t va, uint64_t& value) const;
+    // Reads a 32-bit little-endian value at va
+    bool Read32(uint64_t va, uint32_t& value) const;
+    // RELATIVE relocations in the RELA, REL and RELR tables
+    size_t RelocationCount() const { return relocationCount; }
+
+private:
+    template <typename Traits> bool ParseImage();
+    template <typename Traits> void ParseDynamic(const Segment& dynamic);
+    void BuildRanges();
+
+    const char* data = nullptr;
+    size_t size = 0;
+    bool valid = false;
+    bool is64 = false;
+    Machine machine = Machine::Unknown;
+    std::string error;
+    uint64_t imageBase = 0;
+
+    std::vector<Segment> segments;      // PT_LOAD only, sorted by vaddr
+    std::vector<Section> sections;
+    std::vector<FileRange> executableRanges;
+    std::vector<FileRange> dataRanges;
+    // va -> relocated pointer for RELA entries, sorted by va. REL and RELR
+    // keep the addend in the relocated word, which ReadPointer reads anyway.
+    std::vector<std::pair<uint64_t, uint64_t>> addends;
+    size_t relocationCount = 0;
+};
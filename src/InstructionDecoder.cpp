@@ -0,0 +1,301 @@
+#include "InstructionDecoder.h"
+
+namespace {
+
+// Operand layout of an x86 opcode
+enum : uint8_t {
+    kModRM = 1,     // Has a ModRM byte (plus SIB and displacement)
+    kImm8 = 2,
+    kImmZ = 4,      // 16- or 32-bit immediate, by operand size
+    kImm16 = 8,
+    kBad = 16,      // Invalid in 64-bit mode
+};
+
+struct OpcodeTable {
+    uint8_t flags[256];
+};
+
+constexpr OpcodeTable MakeOneByteTable() {
+    OpcodeTable t = {};
+    // The ALU block: op r/m,r / op r,r/m in the first four slots of each row
+    // of eight, then op al,imm8 and op eax,immz
+    for (int op = 0; op < 0x40; op++) {
+        int low = op & 7;
+        if (low < 4) t.flags[op] = kModRM;
+        else if (low == 4) t.flags[op] = kImm8;
+        else if (low == 5) t.flags[op] = kImmZ;
+    }
+    for (int op : {0x06, 0x07, 0x0E, 0x16, 0x17, 0x1E, 0x1F, 0x27, 0x2F, 0x37, 0x3F,
+                   0x60, 0x61, 0x82, 0x9A, 0xCE, 0xD4, 0xD5, 0xD6, 0xEA}) {
+        t.flags[op] = kBad;
+    }
+    t.flags[0x63] = kModRM;
+    t.flags[0x68] = kImmZ;
+    t.flags[0x69] = kModRM | kImmZ;
+    t.flags[0x6A] = kImm8;
+    t.flags[0x6B] = kModRM | kImm8;
+    for (int op = 0x70; op <= 0x7F; op++) t.flags[op] = kImm8;
+    t.flags[0x80] = kModRM | kImm8;
+    t.flags[0x81] = kModRM | kImmZ;
+    t.flags[0x83] = kModRM | kImm8;
+    for (int op = 0x84; op <= 0x8F; op++) t.flags[op] = kModRM;
+    t.flags[0xA8] = kImm8;
+    t.flags[0xA9] = kImmZ;
+    for (int op = 0xB0; op <= 0xB7; op++) t.flags[op] = kImm8;
+    t.flags[0xC0] = kModRM | kImm8;
+    t.flags[0xC1] = kModRM | kImm8;
+    t.flags[0xC2] = kImm16;
+    t.flags[0xC6] = kModRM | kImm8;
+    t.flags[0xC7] = kModRM | kImmZ;
+    t.flags[0xC8] = kImm16 | kImm8;
+    t.flags[0xCA] = kImm16;
+    t.flags[0xCD] = kImm8;
+    for (int op = 0xD0; op <= 0xD3; op++) t.flags[op] = kModRM;
+    for (int op = 0xD8; op <= 0xDF; op++) t.flags[op] = kModRM;
+    for (int op = 0xE0; op <= 0xE7; op++) t.flags[op] = kImm8;
+    t.flags[0xEB] = kImm8;
+    t.flags[0xF6] = kModRM;     // Immediate depends on the reg field
+    t.flags[0xF7] = kModRM;
+    t.flags[0xFE] = kModRM;
+    t.flags[0xFF] = kModRM;
+    return t;
+}
+
+constexpr OpcodeTable MakeTwoByteTable() {
+    OpcodeTable t = {};
+    for (int op = 0; op < 256; op++) t.flags[op] = kModRM;
+    for (int op : {0x05, 0x06, 0x07, 0x08, 0x09, 0x0B, 0x0E, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x37,
+                   0x77, 0xA0, 0xA1, 0xA2, 0xA8, 0xA9, 0xAA}) {
+        t.flags[op] = 0;
+    }
+    for (int op = 0x80; op <= 0x8F; op++) t.flags[op] = 0;     // jcc rel32, handled separately
+    for (int op = 0xC8; op <= 0xCF; op++) t.flags[op] = 0;     // bswap
+    for (int op : {0x04, 0x0A, 0x0C, 0x36, 0x39, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F}) {
+        t.flags[op] = kBad;
+    }
+    for (int op : {0x0F, 0x70, 0x71, 0x72, 0x73, 0xA4, 0xAC, 0xBA, 0xC2, 0xC4, 0xC5, 0xC6}) {
+        t.flags[op] = kModRM | kImm8;
+    }
+    return t;
+}
+
+constexpr OpcodeTable kOneByte = MakeOneByteTable();
+constexpr OpcodeTable kTwoByte = MakeTwoByteTable();
+
+// Map 1 (0F) opcodes that take an imm8 in their VEX/EVEX forms as well
+bool VexMap1HasImm8(uint8_t op) {
+    return (op >= 0x70 && op <= 0x73) || op == 0xC2 || op == 0xC4 || op == 0xC5 || op == 0xC6;
+}
+
+// Length of ModRM, SIB and displacement; 0 if they run past size
+size_t ModRMLength(const unsigned char* p, size_t size) {
+    if (size < 1) return 0;
+    const uint8_t mod = p[0] >> 6, rm = p[0] & 7;
+    size_t length = 1;
+    if (mod != 3) {
+        if (rm == 4) {
+            if (size < 2) return 0;
+            length++;
+            if (mod == 0 && (p[1] & 7) == 5) length += 4;
+        } else if (mod == 0 && rm == 5) {
+            length += 4;    // rip-relative
+        }
+        if (mod == 1) length += 1;
+        else if (mod == 2) length += 4;
+    }
+    return length <= size ? length : 0;
+}
+
+int64_t SignExtend(uint64_t value, unsigned bits) {
+    const uint64_t sign = uint64_t(1) << (bits - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+uint64_t ReadLE(const unsigned char* p, unsigned bytes) {
+    uint64_t value = 0;
+    for (unsigned i = 0; i < bytes; i++) value |= uint64_t(p[i]) << (8 * i);
+    return value;
+}
+
+} // namespace
+
+bool InstructionDecoder::Decode(const unsigned char* code, size_t size, uint64_t address, Instruction& out) const {
+    out = Instruction{address, 0, 0, InstructionFlow::Invalid, false};
+    switch (machine) {
+    case ElfImage::Machine::ARM64: return DecodeArm64(code, size, address, out);
+    case ElfImage::Machine::X86_64: return DecodeX86_64(code, size, address, out);
+    default: return false;
+    }
+}
+
+bool InstructionDecoder::DecodeArm64(const unsigned char* code, size_t size, uint64_t address, Instruction& out) const {
+    if (size < 4) return false;
+    const uint32_t insn = static_cast<uint32_t>(ReadLE(code, 4));
+    out.length = 4;
+    out.flow = InstructionFlow::Sequential;
+
+    if ((insn & 0x7C000000) == 0x14000000) {
+        // B / BL imm26
+        out.flow = (insn & 0x80000000) ? InstructionFlow::Call : InstructionFlow::Jump;
+        out.target = address + SignExtend(insn & 0x03FFFFFF, 26) * 4;
+    } else if ((insn & 0xFF000010) == 0x54000000) {
+        // B.cond imm19; AL and NV always branch
+        uint32_t cond = insn & 0xF;
+        out.flow = cond >= 0xE ? InstructionFlow::Jump : InstructionFlow::ConditionalJump;
+        out.target = address + SignExtend((insn >> 5) & 0x7FFFF, 19) * 4;
+    } else if ((insn & 0x7E000000) == 0x34000000) {
+        // CBZ / CBNZ imm19
+        out.flow = InstructionFlow::ConditionalJump;
+        out.target = address + SignExtend((insn >> 5) & 0x7FFFF, 19) * 4;
+    } else if ((insn & 0x7E000000) == 0x36000000) {
+        // TBZ / TBNZ imm14
+        out.flow = InstructionFlow::ConditionalJump;
+        out.target = address + SignExtend((insn >> 5) & 0x3FFF, 14) * 4;
+    } else if ((insn & 0xFE000000) == 0xD6000000) {
+        // Branch to register, including the pointer-authenticated forms
+        switch ((insn >> 21) & 0x7) {
+        case 0: out.flow = InstructionFlow::IndirectJump; break;     // BR
+        case 1: out.flow = InstructionFlow::IndirectCall; break;     // BLR
+        case 2: case 4: case 5: out.flow = InstructionFlow::Return; break;  // RET, ERET, DRPS
+        default: out.flow = InstructionFlow::Invalid; return false;
+        }
+    } else if ((insn & 0xFFE0001F) == 0xD4200000 || (insn & 0xFFE0001F) == 0xD4400000) {
+        // BRK / HLT
+        out.flow = InstructionFlow::Trap;
+    } else if ((insn & 0xFFFF0000) == 0) {
+        // UDF; zero words are also what linkers pad with
+        out.flow = InstructionFlow::Trap;
+        out.isNop = insn == 0;
+    } else if (insn == 0xD503201F) {
+        out.isNop = true;
+    }
+    return true;
+}
+
+bool InstructionDecoder::DecodeX86_64(const unsigned char* code, size_t size, uint64_t address, Instruction& out) const {
+    const size_t limit = size < 15 ? size : 15;
+    size_t pos = 0;
+    bool operandSize16 = false, addressSize32 = false, rexW = false;
+
+    // Legacy prefixes, then an optional REX which must come last
+    for (; pos < limit; pos++) {
+        uint8_t b = code[pos];
+        if (b == 0x66) operandSize16 = true;
+        else if (b == 0x67) addressSize32 = true;
+        else if (b == 0xF0 || b == 0xF2 || b == 0xF3 || b == 0x2E || b == 0x36 || b == 0x3E ||
+                 b == 0x26 || b == 0x64 || b == 0x65) continue;
+        else break;
+    }
+    if (pos < limit && (code[pos] & 0xF0) == 0x40) {
+        rexW = (code[pos] & 0x08) != 0;
+        pos++;
+    }
+    if (pos >= limit) return false;
+
+    const uint8_t opcode = code[pos++];
+    uint8_t flags;
+    size_t immediate = 0;
+    out.flow = InstructionFlow::Sequential;
+
+    auto finish = [&](size_t length) {
+        if (length > limit) {
+            out.flow = InstructionFlow::Invalid;
+            return false;
+        }
+        out.length = static_cast<uint8_t>(length);
+        return true;
+    };
+    auto immZ = [&]() -> size_t { return operandSize16 ? 2 : 4; };
+
+    if (opcode == 0xC4 || opcode == 0xC5 || opcode == 0x62) {
+        // VEX (2 or 3 byte) and EVEX: the map comes from the prefix, every
+        // form has a ModRM
+        size_t prefixBytes = opcode == 0xC5 ? 1 : opcode == 0xC4 ? 2 : 3;
+        if (pos + prefixBytes + 1 > limit) return false;
+        unsigned map = opcode == 0xC5 ? 1 : (code[pos] & (opcode == 0xC4 ? 0x1F : 0x07));
+        pos += prefixBytes;
+        const uint8_t op = code[pos++];
+        if (map == 1 && op == 0x77) return finish(pos);   // vzeroupper / vzeroall
+        size_t modrm = ModRMLength(code + pos, limit - pos);
+        if (!modrm) return false;
+        pos += modrm;
+        if (map == 3 || (map == 1 && VexMap1HasImm8(op))) pos += 1;
+        return finish(pos);
+    }
+
+    if (opcode == 0x0F) {
+        if (pos >= limit) return false;
+        const uint8_t op = code[pos++];
+        if (op == 0x38 || op == 0x3A) {
+            if (pos >= limit) return false;
+            pos++;
+            size_t modrm = ModRMLength(code + pos, limit - pos);
+            if (!modrm) return false;
+            return finish(pos + modrm + (op == 0x3A ? 1 : 0));
+        }
+        if (op >= 0x80 && op <= 0x8F) {
+            if (!finish(pos + 4)) return false;
+            out.flow = InstructionFlow::ConditionalJump;
+            out.target = address + out.length + SignExtend(ReadLE(code + pos, 4), 32);
+            return true;
+        }
+        flags = kTwoByte.flags[op];
+        if (flags & kBad) return false;
+        if (op == 0x0B || op == 0xB9 || op == 0xFF) out.flow = InstructionFlow::Trap;  // ud2, ud1, ud0
+        if (op == 0x1F) out.isNop = true;
+        if (flags & kModRM) {
+            size_t modrm = ModRMLength(code + pos, limit - pos);
+            if (!modrm) return false;
+            pos += modrm;
+        }
+        if (flags & kImm8) pos += 1;
+        return finish(pos);
+    }
+
+    flags = kOneByte.flags[opcode];
+    if (flags & kBad) return false;
+
+    uint8_t modrmByte = 0;
+    if (flags & kModRM) {
+        if (pos >= limit) return false;
+        modrmByte = code[pos];
+        size_t modrm = ModRMLength(code + pos, limit - pos);
+        if (!modrm) return false;
+        pos += modrm;
+    }
+    if (flags & kImm8) immediate += 1;
+    if (flags & kImm16) immediate += 2;
+    if (flags & kImmZ) immediate += immZ();
+
+    const uint8_t reg = (modrmByte >> 3) & 7;
+    if (opcode >= 0xB8 && opcode <= 0xBF) immediate = rexW ? 8 : immZ();          // mov r, imm
+    else if (opcode >= 0xA0 && opcode <= 0xA3) immediate = addressSize32 ? 4 : 8; // mov moffs
+    else if ((opcode == 0xF6 || opcode == 0xF7) && reg < 2) immediate = opcode == 0xF6 ? 1 : immZ();
+    else if (opcode == 0xE8 || opcode == 0xE9) immediate = 4;                     // rel32 ignores 66
+
+    if (!finish(pos + immediate)) return false;
+    const uint64_t next = address + out.length;
+
+    if ((opcode >= 0x70 && opcode <= 0x7F) || (opcode >= 0xE0 && opcode <= 0xE3)) {
+        out.flow = InstructionFlow::ConditionalJump;
+        out.target = next + SignExtend(code[pos], 8);
+    } else if (opcode == 0xEB) {
+        out.flow = InstructionFlow::Jump;
+        out.target = next + SignExtend(code[pos], 8);
+    } else if (opcode == 0xE9 || opcode == 0xE8) {
+        out.flow = opcode == 0xE9 ? InstructionFlow::Jump : InstructionFlow::Call;
+        out.target = next + SignExtend(ReadLE(code + pos, 4), 32);
+    } else if (opcode == 0xC3 || opcode == 0xC2 || opcode == 0xCB || opcode == 0xCA || opcode == 0xCF) {
+        out.flow = InstructionFlow::Return;
+    } else if (opcode == 0xCC || opcode == 0xF1 || opcode == 0xF4) {
+        out.flow = InstructionFlow::Trap;
+        out.isNop = opcode == 0xCC;     // int3 fill between functions
+    } else if (opcode == 0xFF && (reg == 2 || reg == 3)) {
+        out.flow = InstructionFlow::IndirectCall;
+    } else if (opcode == 0xFF && (reg == 4 || reg == 5)) {
+        out.flow = InstructionFlow::IndirectJump;
+    } else if (opcode == 0x90) {
+        out.isNop = true;
+    }
+    return true;
+}
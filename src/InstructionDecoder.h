@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ElfImage.h"
+
+// How an instruction affects control flow
+enum class InstructionFlow : uint8_t {
+    Sequential,         // Falls through to the next instruction
+    Call,               // Direct call; returns to the next instruction
+    IndirectCall,
+    Jump,               // Direct unconditional branch
+    ConditionalJump,    // Direct conditional branch; may fall through
+    IndirectJump,       // Branch to a register or memory operand
+    Return,
+    Trap,               // int3, ud2, hlt, brk, udf: ends the block
+    Invalid,            // Could not be decoded
+};
+
+struct Instruction {
+    uint64_t address;
+    uint64_t target;        // Branch/call target for the direct forms, else 0
+    uint8_t length;
+    InstructionFlow flow;
+    bool isNop;             // Alignment padding: nop, multi-byte nop, int3/udf fill
+
+    bool EndsBlock() const {
+        return flow != InstructionFlow::Sequential && flow != InstructionFlow::Call && flow != InstructionFlow::IndirectCall;
+    }
+    bool HasTarget() const {
+        return flow == InstructionFlow::Jump || flow == InstructionFlow::ConditionalJump || flow == InstructionFlow::Call;
+    }
+};
+
+// Length decoder and branch classifier for AArch64 and x86-64 code.
+//
+// It recovers what a linear sweep needs - instruction boundaries, whether an
+// instruction branches, and where to - without full operand decoding. x86-64
+// lengths are table driven over the legacy, REX, VEX and EVEX encodings;
+// AArch64 instructions are always four bytes and only the branch classes are
+// looked at.
+class InstructionDecoder {
+public:
+    explicit InstructionDecoder(ElfImage::Machine machine) : machine(machine) {}
+
+    static bool IsSupported(ElfImage::Machine machine) {
+        return machine == ElfImage::Machine::ARM64 || machine == ElfImage::Machine::X86_64;
+    }
+    bool IsSupported() const { return IsSupported(machine); }
+    // Length to skip when Decode() fails
+    uint8_t MinLength() const { return machine == ElfImage::Machine::ARM64 ? 4 : 1; }
+
+    // Decodes the instruction at code (address is its VA). Returns false, with
+    // out.flow == Invalid, if the bytes are not a valid instruction or run
+    // past size.
+    bool Decode(const unsigned char* code, size_t size, uint64_t address, Instruction& out) const;
+
+private:
+    bool DecodeArm64(const unsigned char* code, size_t size, uint64_t address, Instruction& out) const;
+    bool DecodeX86_64(const unsigned char* code, size_t size, uint64_t address, Instruction& out) const;
+
+    ElfImage::Machine machine;
+};
@@ -0,0 +1,169 @@
+#include "JsonWriter.h"
+
+namespace {
+
+// For every byte: 0 if it can be copied as is, otherwise the character that
+// follows the backslash in its escape ('u' for \u00XX). Bytes from 0x80 are
+// marked '8': they are copied if they start a valid UTF-8 sequence.
+struct EscapeTable {
+    char map[256];
+    constexpr EscapeTable() : map() {
+        for (int c = 0; c < 0x20; c++) map[c] = 'u';
+        map[static_cast<unsigned char>('"')] = '"';
+        map[static_cast<unsigned char>('\\')] = '\\';
+        map[static_cast<unsigned char>('\b')] = 'b';
+        map[static_cast<unsigned char>('\f')] = 'f';
+        map[static_cast<unsigned char>('\n')] = 'n';
+        map[static_cast<unsigned char>('\r')] = 'r';
+        map[static_cast<unsigned char>('\t')] = 't';
+        map[0x7F] = 'u';
+        for (int c = 0x80; c < 0x100; c++) map[c] = '8';
+    }
+};
+
+constexpr EscapeTable kEscapes;
+
+// Length of the well-formed UTF-8 sequence at data (RFC 3629: no overlong
+// forms, surrogates or code points above U+10FFFF), or 0 if there is none
+size_t Utf8SequenceLength(const unsigned char* data, size_t size) {
+    const unsigned char lead = data[0];
+    size_t length;
+    unsigned char low = 0x80, high = 0xBF;     // Range of the second byte
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) low = 0xA0;
+        if (lead == 0xED) high = 0x9F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) low = 0x90;
+        if (lead == 0xF4) high = 0x8F;
+    } else {
+        return 0;
+    }
+    if (size < length || data[1] < low || data[1] > high) return 0;
+    for (size_t i = 2; i < length; i++) {
+        if ((data[i] & 0xC0) != 0x80) return 0;
+    }
+    return length;
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(BufferedWriter& out, bool pretty) : out(out), pretty(pretty), afterKey(false) {}
+
+void JsonWriter::Escape(BufferedWriter& out, std::string_view value) {
+    size_t runStart = 0;
+    for (size_t i = 0; i < value.size(); i++) {
+        char escape = kEscapes.map[static_cast<unsigned char>(value[i])];
+        if (!escape) continue;
+        if (escape == '8') {
+            // Valid UTF-8 is copied; any other byte is written as \u00XX so
+            // that the output stays valid JSON
+            const size_t length =
+                Utf8SequenceLength(reinterpret_cast<const unsigned char*>(value.data()) + i, value.size() - i);
+            if (length) {
+                i += length - 1;
+                continue;
+            }
+            escape = 'u';
+        }
+
+        out.Write(value.substr(runStart, i - runStart));
+        char sequence[6] = {'\\', escape, '0', '0', 0, 0};
+        if (escape == 'u') {
+            FormatHex(sequence + 4, static_cast<unsigned char>(value[i]), 2);
+            out.Write(std::string_view(sequence, 6));
+        } else {
+            out.Write(std::string_view(sequence, 2));
+        }
+        runStart = i + 1;
+    }
+    out.Write(value.substr(runStart));
+}
+
+void JsonWriter::Newline() {
+    out.Put('\n');
+    for (size_t i = 0; i < scopes.size(); i++) {
+        out.Write("  ");
+    }
+}
+
+void JsonWriter::BeforeValue() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (scopes.empty()) return;
+    Scope& scope = scopes.back();
+    if (!scope.empty) out.Put(',');
+    scope.empty = false;
+    if (pretty) Newline();
+}
+
+void JsonWriter::BeginObject() {
+    BeforeValue();
+    out.Put('{');
+    scopes.push_back({true, true});
+}
+
+void JsonWriter::BeginArray() {
+    BeforeValue();
+    out.Put('[');
+    scopes.push_back({false, true});
+}
+
+void JsonWriter::Close(char bracket) {
+    bool empty = scopes.back().empty;
+    scopes.pop_back();
+    if (pretty && !empty) Newline();
+    out.Put(bracket);
+}
+
+void JsonWriter::EndObject() {
+    Close('}');
+}
+
+void JsonWriter::EndArray() {
+    Close(']');
+}
+
+void JsonWriter::Key(std::string_view name) {
+    BeforeValue();
+    out.Put('"');
+    Escape(out, name);
+    out.Write(pretty ? "\": " : "\":");
+    afterKey = true;
+}
+
+void JsonWriter::String(std::string_view value) {
+    BeforeValue();
+    out.Put('"');
+    Escape(out, value);
+    out.Put('"');
+}
+
+void JsonWriter::Uint(uint64_t value) {
+    BeforeValue();
+    out.WriteDec(value);
+}
+
+void JsonWriter::Int(int64_t value) {
+    BeforeValue();
+    out.WriteDec(value);
+}
+
+void JsonWriter::Bool(bool value) {
+    BeforeValue();
+    out.Write(value ? "true" : "false");
+}
+
+void JsonWriter::Null() {
+    BeforeValue();
+    out.Write("null");
+}
+
+void JsonWriter::EndRecord() {
+    out.Put('\n');
+}
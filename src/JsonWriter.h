@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "BufferedWriter.h"
+
+// Streaming JSON emitter on top of a BufferedWriter.
+//
+// Commas, indentation and string escaping are handled here, so callers only
+// describe structure: BeginObject()/Key()/value/.../EndObject(). Strings are
+// escaped with a lookup table and copied in runs; numbers go through to_chars.
+// Nothing is kept in memory beyond the nesting stack.
+//
+// In compact mode nothing but the JSON itself is written, which combined with
+// EndRecord() gives NDJSON: one complete top-level value per line.
+class JsonWriter {
+public:
+    explicit JsonWriter(BufferedWriter& out, bool pretty = true);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    void Key(std::string_view name);
+
+    void String(std::string_view value);
+    void Uint(uint64_t value);
+    void Int(int64_t value);
+    void Bool(bool value);
+    void Null();
+
+    // Shorthands for the common Key() + value pairs
+    void Member(std::string_view name, std::string_view value) { Key(name); String(value); }
+    void Member(std::string_view name, uint64_t value) { Key(name); Uint(value); }
+
+    // Ends a top-level value with a newline (NDJSON record separator)
+    void EndRecord();
+
+    // Writes value as the body of a JSON string, without the quotes
+    static void Escape(BufferedWriter& out, std::string_view value);
+
+private:
+    // Emits the separator and indentation that precede a value or key
+    void BeforeValue();
+    void Close(char bracket);
+    void Newline();
+
+    struct Scope {
+        bool isObject;
+        bool empty;
+    };
+
+    BufferedWriter& out;
+    bool pretty;
+    bool afterKey;
+    std::vector<Scope> scopes;
+};
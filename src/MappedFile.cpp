@@ -0,0 +1,146 @@
+#include "MappedFile.h"
+#include <cerrno>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : bytes(nullptr), length(0), mapping(nullptr) {}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+void MappedFile::Close() {
+#if !defined(_WIN32)
+    if (mapping) {
+        munmap(mapping, length);
+    }
+#endif
+    mapping = nullptr;
+    bytes = nullptr;
+    length = 0;
+    std::vector<char>().swap(owned);
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const std::string& path, AccessHint) {
+    Close();
+    error.clear();
+
+    // No mapping backend on this platform yet; always use the buffered path
+    if (path == "-") {
+        owned.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            error = "cannot open file";
+            return false;
+        }
+        owned.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    bytes = owned.data();
+    length = owned.size();
+    return true;
+}
+
+void MappedFile::Advise(AccessHint, size_t, size_t) const {}
+
+bool MappedFile::ReadAll(int) {
+    return false;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path, AccessHint hint) {
+    Close();
+    error.clear();
+
+    if (path == "-") {
+        return ReadAll(STDIN_FILENO);
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        error = std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    // Only regular, non-empty files can be mapped; everything else is streamed
+    if (!S_ISREG(st.st_mode) || st.st_size == 0) {
+        bool ok = ReadAll(fd);
+        ::close(fd);
+        return ok;
+    }
+
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        // e.g. filesystems without mmap support: fall back to reading
+        bool ok = ReadAll(fd);
+        ::close(fd);
+        return ok;
+    }
+    ::close(fd);
+
+    mapping = addr;
+    bytes = static_cast<const char*>(addr);
+    length = fileSize;
+    Advise(hint);
+    return true;
+}
+
+void MappedFile::Advise(AccessHint hint, size_t offset, size_t len) const {
+    if (!mapping || offset >= length) return;
+
+    // madvise needs a page-aligned start address
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t alignedOffset = offset - (offset % pageSize);
+    size_t end = (len == 0 || len > length - offset) ? length : offset + len;
+
+    int advice = MADV_NORMAL;
+    switch (hint) {
+        case AccessHint::Normal:     advice = MADV_NORMAL; break;
+        case AccessHint::Sequential: advice = MADV_SEQUENTIAL; break;
+        case AccessHint::Random:     advice = MADV_RANDOM; break;
+        case AccessHint::WillNeed:   advice = MADV_WILLNEED; break;
+    }
+    madvise(static_cast<char*>(mapping) + alignedOffset, end - alignedOffset, advice);
+}
+
+bool MappedFile::ReadAll(int fd) {
+    char chunk[1 << 16];
+    for (;;) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n > 0) {
+            owned.insert(owned.end(), chunk, chunk + n);
+        } else if (n == 0) {
+            break;
+        } else if (errno != EINTR) {
+            error = std::strerror(errno);
+            std::vector<char>().swap(owned);
+            return false;
+        }
+    }
+    bytes = owned.data();
+    length = owned.size();
+    return true;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only view over the bytes of an input file.
+//
+// Regular files are memory-mapped so that the loader can hand out pointers into
+// the file without copying it. Pipes, character devices and stdin (path "-")
+// cannot be mapped; for those the contents are read into an owned buffer and the
+// same data()/size() interface is exposed over it.
+class MappedFile {
+public:
+    enum class AccessHint {
+        Normal,
+        Sequential,  // Streaming scans (binary analysis)
+        Random,      // Table lookups scattered across the file
+        WillNeed     // Prefetch the whole range
+    };
+
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path, AccessHint hint = AccessHint::Normal);
+    void Close();
+
+    // Forward an access pattern hint for [offset, offset + length) to the kernel.
+    // A zero length covers the rest of the file. No-op for buffered inputs.
+    void Advise(AccessHint hint, size_t offset = 0, size_t length = 0) const;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    bool IsMapped() const { return mapping != nullptr; }
+    const std::string& GetError() const { return error; }
+
+private:
+    bool ReadAll(int fd);
+
+    const char* bytes;
+    size_t length;
+    void* mapping;
+    std::vector<char> owned;
+    std::string error;
+};
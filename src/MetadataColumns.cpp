@@ -0,0 +1,177 @@
+#include "MetadataColumns.h"
+#include <cstddef>
+#include <initializer_list>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// The SSE2 kernels load four consecutive words of a record at a time
+static_assert(offsetof(Il2CppTypeDefinition, namespaceIndex) == offsetof(Il2CppTypeDefinition, nameIndex) + 4 &&
+              offsetof(Il2CppTypeDefinition, byvalTypeIndex) == offsetof(Il2CppTypeDefinition, nameIndex) + 8 &&
+              offsetof(Il2CppTypeDefinition, parentIndex) == offsetof(Il2CppTypeDefinition, declaringTypeIndex) + 4 &&
+              offsetof(Il2CppTypeDefinition, token) + 4 == sizeof(Il2CppTypeDefinition),
+              "type definition words the transpose relies on");
+static_assert(offsetof(Il2CppMethodDefinition, nameIndex) == 0 &&
+              offsetof(Il2CppMethodDefinition, genericContainerIndex) == 16 &&
+              offsetof(Il2CppMethodDefinition, token) == 20 && offsetof(Il2CppMethodDefinition, flags) == 24 &&
+              offsetof(Il2CppMethodDefinition, parameterCount) == 30 && sizeof(Il2CppMethodDefinition) == 32,
+              "method definition words the transpose relies on");
+
+void TransposeTypesScalar(const Il2CppTypeDefinition* records, size_t begin, size_t end,
+                          MetadataColumns::TypeColumns& out) {
+    for (size_t i = begin; i < end; i++) {
+        out.nameIndex[i] = records[i].nameIndex;
+        out.namespaceIndex[i] = records[i].namespaceIndex;
+        out.byvalTypeIndex[i] = records[i].byvalTypeIndex;
+        out.declaringTypeIndex[i] = records[i].declaringTypeIndex;
+        out.parentIndex[i] = records[i].parentIndex;
+        out.flags[i] = records[i].flags;
+        out.token[i] = records[i].token;
+    }
+}
+
+void TransposeMethodsScalar(const Il2CppMethodDefinition* records, size_t begin, size_t end,
+                            MetadataColumns::MethodColumns& out) {
+    for (size_t i = begin; i < end; i++) {
+        out.nameIndex[i] = records[i].nameIndex;
+        out.declaringType[i] = records[i].declaringType;
+        out.returnType[i] = records[i].returnType;
+        out.parameterStart[i] = records[i].parameterStart;
+        out.genericContainerIndex[i] = records[i].genericContainerIndex;
+        out.token[i] = records[i].token;
+        out.flags[i] = records[i].flags;
+        out.parameterCount[i] = records[i].parameterCount;
+    }
+}
+
+#if defined(__SSE2__)
+
+// Loads bytes [offset, offset + 16) of four records kStride apart and
+// transposes them, so column[k] holds word k of that range for all four
+template <size_t kStride>
+inline void Transpose4(const char* records, size_t offset, __m128i column[4]) {
+    const char* base = records + offset;
+    const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base));
+    const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + kStride));
+    const __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + 2 * kStride));
+    const __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + 3 * kStride));
+    const __m128i t0 = _mm_unpacklo_epi32(r0, r1);  // a0 b0 a1 b1
+    const __m128i t1 = _mm_unpacklo_epi32(r2, r3);  // c0 d0 c1 d1
+    const __m128i t2 = _mm_unpackhi_epi32(r0, r1);  // a2 b2 a3 b3
+    const __m128i t3 = _mm_unpackhi_epi32(r2, r3);  // c2 d2 c3 d3
+    column[0] = _mm_unpacklo_epi64(t0, t1);
+    column[1] = _mm_unpackhi_epi64(t0, t1);
+    column[2] = _mm_unpacklo_epi64(t2, t3);
+    column[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+inline void Store(uint32_t* out, __m128i words) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), words);
+}
+
+// The low or high halves of four words. Sign-extending the half first makes
+// the saturating pack exact.
+inline void StoreLow16(uint16_t* out, __m128i words) {
+    const __m128i low = _mm_srai_epi32(_mm_slli_epi32(words, 16), 16);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(low, low));
+}
+
+inline void StoreHigh16(uint16_t* out, __m128i words) {
+    const __m128i high = _mm_srai_epi32(words, 16);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packs_epi32(high, high));
+}
+
+void TransposeTypesSSE2(const Il2CppTypeDefinition* records, size_t count, MetadataColumns::TypeColumns& out) {
+    constexpr size_t kStride = sizeof(Il2CppTypeDefinition);
+    const size_t blocked = count / 4 * 4;
+    __m128i column[4];
+    for (size_t i = 0; i < blocked; i += 4) {
+        const char* rows = reinterpret_cast<const char*>(records + i);
+        Transpose4<kStride>(rows, offsetof(Il2CppTypeDefinition, nameIndex), column);
+        Store(&out.nameIndex[i], column[0]);
+        Store(&out.namespaceIndex[i], column[1]);
+        Store(&out.byvalTypeIndex[i], column[2]);
+        Transpose4<kStride>(rows, offsetof(Il2CppTypeDefinition, declaringTypeIndex), column);
+        Store(&out.declaringTypeIndex[i], column[0]);
+        Store(&out.parentIndex[i], column[1]);
+        Transpose4<kStride>(rows, offsetof(Il2CppTypeDefinition, flags), column);
+        Store(&out.flags[i], column[0]);
+        Transpose4<kStride>(rows, kStride - 16, column);
+        Store(&out.token[i], column[3]);
+    }
+    TransposeTypesScalar(records, blocked, count, out);
+}
+
+void TransposeMethodsSSE2(const Il2CppMethodDefinition* records, size_t count, MetadataColumns::MethodColumns& out) {
+    constexpr size_t kStride = sizeof(Il2CppMethodDefinition);
+    const size_t blocked = count / 4 * 4;
+    __m128i column[4];
+    for (size_t i = 0; i < blocked; i += 4) {
+        const char* rows = reinterpret_cast<const char*>(records + i);
+        Transpose4<kStride>(rows, 0, column);
+        Store(&out.nameIndex[i], column[0]);
+        Store(&out.declaringType[i], column[1]);
+        Store(&out.returnType[i], column[2]);
+        Store(&out.parameterStart[i], column[3]);
+        Transpose4<kStride>(rows, 16, column);
+        Store(&out.genericContainerIndex[i], column[0]);
+        Store(&out.token[i], column[1]);
+        StoreLow16(&out.flags[i], column[2]);            // flags | iflags << 16
+        StoreHigh16(&out.parameterCount[i], column[3]);  // slot | parameterCount << 16
+    }
+    TransposeMethodsScalar(records, blocked, count, out);
+}
+
+#endif
+
+template <typename Vector>
+void ReleaseAll(std::initializer_list<Vector*> vectors) {
+    for (Vector* vector : vectors) {
+        vector->clear();
+        vector->shrink_to_fit();
+    }
+}
+
+} // namespace
+
+void MetadataColumns::Build(const Il2CppTypeDefinition* typeRecords, size_t typeCount,
+                            const Il2CppMethodDefinition* methodRecords, size_t methodCount) {
+    Clear();
+    if (!typeRecords) typeCount = 0;
+    if (!methodRecords) methodCount = 0;
+
+    for (std::vector<uint32_t>* column : {&types.nameIndex, &types.namespaceIndex, &types.byvalTypeIndex,
+                                          &types.declaringTypeIndex, &types.parentIndex, &types.flags, &types.token}) {
+        column->resize(typeCount);
+    }
+    for (std::vector<uint32_t>* column : {&methods.nameIndex, &methods.declaringType, &methods.returnType,
+                                          &methods.parameterStart, &methods.genericContainerIndex, &methods.token}) {
+        column->resize(methodCount);
+    }
+    methods.flags.resize(methodCount);
+    methods.parameterCount.resize(methodCount);
+
+#if defined(__SSE2__)
+    TransposeTypesSSE2(typeRecords, typeCount, types);
+    TransposeMethodsSSE2(methodRecords, methodCount, methods);
+#else
+    TransposeTypesScalar(typeRecords, 0, typeCount, types);
+    TransposeMethodsScalar(methodRecords, 0, methodCount, methods);
+#endif
+}
+
+void MetadataColumns::Clear() {
+    ReleaseAll<std::vector<uint32_t>>({&types.nameIndex, &types.namespaceIndex, &types.byvalTypeIndex,
+                                       &types.declaringTypeIndex, &types.parentIndex, &types.flags, &types.token,
+                                       &methods.nameIndex, &methods.declaringType, &methods.returnType,
+                                       &methods.parameterStart, &methods.genericContainerIndex, &methods.token});
+    ReleaseAll<std::vector<uint16_t>>({&methods.flags, &methods.parameterCount});
+}
+
+size_t MetadataColumns::MemoryUsage() const {
+    return types.Count() * 7 * sizeof(uint32_t) +
+           methods.Count() * (6 * sizeof(uint32_t) + 2 * sizeof(uint16_t));
+}
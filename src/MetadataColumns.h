@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "il2cpp_structs.h"
+
+// Struct-of-arrays copies of the type and method definition fields that
+// full-table passes read: one contiguous array per field, indexed by
+// TypeDefinitionIndex or MethodIndex. A pass that only needs names and
+// tokens streams through 8 bytes per element instead of a whole 92- or
+// 32-byte record, and the arrays are laid out for vector loops.
+//
+// Built once from the in-memory records by a 4x4 transpose (SSE2, scalar
+// elsewhere); the records stay the source of truth for everything else.
+class MetadataColumns {
+public:
+    struct TypeColumns {
+        std::vector<StringIndex> nameIndex;
+        std::vector<StringIndex> namespaceIndex;
+        std::vector<TypeIndex> byvalTypeIndex;
+        std::vector<TypeIndex> declaringTypeIndex;
+        std::vector<TypeIndex> parentIndex;
+        std::vector<uint32_t> flags;
+        std::vector<uint32_t> token;
+
+        size_t Count() const { return token.size(); }
+    };
+
+    struct MethodColumns {
+        std::vector<StringIndex> nameIndex;
+        std::vector<TypeDefinitionIndex> declaringType;
+        std::vector<TypeIndex> returnType;
+        std::vector<ParameterIndex> parameterStart;
+        std::vector<GenericContainerIndex> genericContainerIndex;
+        std::vector<uint32_t> token;
+        std::vector<uint16_t> flags;
+        std::vector<uint16_t> parameterCount;
+
+        size_t Count() const { return token.size(); }
+    };
+
+    void Build(const Il2CppTypeDefinition* types, size_t typeCount, const Il2CppMethodDefinition* methods,
+               size_t methodCount);
+    void Clear();
+
+    const TypeColumns& Types() const { return types; }
+    const MethodColumns& Methods() const { return methods; }
+    size_t MemoryUsage() const;
+
+private:
+    TypeColumns types;
+    MethodColumns methods;
+};
@@ -0,0 +1,421 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "il2cpp_structs.h"
+
+// How global-metadata.dat stores its header and records, by metadata
+// version. The structs of il2cpp_structs.h are the in-memory form the loader
+// works with, which is the v24.2 file layout; each specialization of
+// MetadataLayout names the on-disk struct of every versioned record, and
+// MetadataTables converts the ones that differ when the file is loaded.
+//
+// Only the records the loader reads are described. The generic container,
+// generic parameter and index tables have kept their layout since v24.
+enum class MetadataLayoutVersion : uint8_t {
+    V23,    // v23: v24.0 records, but no exported types in the header or images
+    V24_0,  // v24.0: custom attribute indices in the records, rgctx ranges
+    V24_1,  // v24.1: custom attribute ranges moved to the images
+    V24_2,  // v24.2-v24.5: no rgctx ranges or method indices in the records
+    V27,    // v27-v27.2: no byref TypeIndex, no metadata usage tables
+    V29,    // v29-v30: attribute data ranges replace the attribute tables
+    V31,    // v31+: return parameter token in method definitions
+};
+
+// "v24.2"
+const char* MetadataLayoutName(MetadataLayoutVersion layout);
+
+// sanity through typeDefinitionsCount, which every version since v21 shares
+struct Il2CppMetadataHeaderPrefix {
+    int32_t sanity;
+    int32_t version;
+    int32_t stringLiteralOffset;
+    int32_t stringLiteralCount;
+    int32_t stringLiteralDataOffset;
+    int32_t stringLiteralDataCount;
+    int32_t stringOffset;
+    int32_t stringCount;
+    int32_t eventsOffset;
+    int32_t eventsCount;
+    int32_t propertiesOffset;
+    int32_t propertiesCount;
+    int32_t methodsOffset;
+    int32_t methodsCount;
+    int32_t parameterDefaultValuesOffset;
+    int32_t parameterDefaultValuesCount;
+    int32_t fieldDefaultValuesOffset;
+    int32_t fieldDefaultValuesCount;
+    int32_t fieldAndParameterDefaultValueDataOffset;
+    int32_t fieldAndParameterDefaultValueDataCount;
+    int32_t fieldMarshaledSizesOffset;
+    int32_t fieldMarshaledSizesCount;
+    int32_t parametersOffset;
+    int32_t parametersCount;
+    int32_t fieldsOffset;
+    int32_t fieldsCount;
+    int32_t genericParametersOffset;
+    int32_t genericParametersCount;
+    int32_t genericParameterConstraintsOffset;
+    int32_t genericParameterConstraintsCount;
+    int32_t genericContainersOffset;
+    int32_t genericContainersCount;
+    int32_t nestedTypesOffset;
+    int32_t nestedTypesCount;
+    int32_t interfacesOffset;
+    int32_t interfacesCount;
+    int32_t vtableMethodsOffset;
+    int32_t vtableMethodsCount;
+    int32_t interfaceOffsetsOffset;
+    int32_t interfaceOffsetsCount;
+    int32_t typeDefinitionsOffset;
+    int32_t typeDefinitionsCount;
+};
+
+static_assert(sizeof(Il2CppMetadataHeaderPrefix) == offsetof(Il2CppGlobalMetadataHeader, imagesOffset),
+              "the header prefix must end where the in-memory header's images follow it");
+
+template <MetadataLayoutVersion V>
+struct MetadataLayout;
+
+// The in-memory layout itself
+template <>
+struct MetadataLayout<MetadataLayoutVersion::V24_2> {
+    using Header = Il2CppGlobalMetadataHeader;
+    using ImageDefinition = Il2CppImageDefinition;
+    using TypeDefinition = Il2CppTypeDefinition;
+    using MethodDefinition = Il2CppMethodDefinition;
+    using FieldDefinition = Il2CppFieldDefinition;
+    using PropertyDefinition = Il2CppPropertyDefinition;
+    using ParameterDefinition = Il2CppParameterDefinition;
+};
+
+template <>
+struct MetadataLayout<MetadataLayoutVersion::V24_1> : MetadataLayout<MetadataLayoutVersion::V24_2> {
+    struct Header {
+        Il2CppMetadataHeaderPrefix prefix;
+        int32_t rgctxEntriesOffset;
+        int32_t rgctxEntriesCount;
+        int32_t imagesOffset;
+        int32_t imagesCount;
+        int32_t assembliesOffset;
+        int32_t assembliesCount;
+        int32_t metadataUsageListsOffset;
+        int32_t metadataUsageListsCount;
+        int32_t metadataUsagePairsOffset;
+        int32_t metadataUsagePairsCount;
+        int32_t fieldRefsOffset;
+        int32_t fieldRefsCount;
+        int32_t referencedAssembliesOffset;
+        int32_t referencedAssembliesCount;
+        int32_t attributesInfoOffset;
+        int32_t attributesInfoCount;
+        int32_t attributeTypesOffset;
+        int32_t attributeTypesCount;
+        int32_t unresolvedVirtualCallParameterTypesOffset;
+        int32_t unresolvedVirtualCallParameterTypesCount;
+        int32_t unresolvedVirtualCallParameterRangesOffset;
+        int32_t unresolvedVirtualCallParameterRangesCount;
+        int32_t windowsRuntimeTypeNamesOffset;
+        int32_t windowsRuntimeTypeNamesSize;
+        int32_t exportedTypeDefinitionsOffset;
+        int32_t exportedTypeDefinitionsCount;
+    };
+
+    struct TypeDefinition {
+        StringIndex nameIndex;
+        StringIndex namespaceIndex;
+        TypeIndex byvalTypeIndex;
+        TypeIndex byrefTypeIndex;
+        TypeIndex declaringTypeIndex;
+        TypeIndex parentIndex;
+        TypeIndex elementTypeIndex;
+        RGCTXIndex rgctxStartIndex;
+        int32_t rgctxCount;
+        GenericContainerIndex genericContainerIndex;
+        uint32_t flags;
+        FieldIndex fieldStart;
+        MethodIndex methodStart;
+        EventIndex eventStart;
+        PropertyIndex propertyStart;
+        NestedTypeIndex nestedTypesStart;
+        InterfacesIndex interfacesStart;
+        VTableIndex vtableStart;
+        InterfacesIndex interfaceOffsetsStart;
+        uint16_t method_count;
+        uint16_t property_count;
+        uint16_t field_count;
+        uint16_t event_count;
+        uint16_t nested_type_count;
+        uint16_t vtable_count;
+        uint16_t interfaces_count;
+        uint16_t interface_offsets_count;
+        uint32_t bitfield;
+        uint32_t token;
+    };
+
+    struct MethodDefinition {
+        StringIndex nameIndex;
+        TypeDefinitionIndex declaringType;
+        TypeIndex returnType;
+        ParameterIndex parameterStart;
+        GenericContainerIndex genericContainerIndex;
+        MethodIndex methodIndex;
+        MethodIndex invokerIndex;
+        MethodIndex delegateWrapperIndex;
+        RGCTXIndex rgctxStartIndex;
+        int32_t rgctxCount;
+        uint32_t token;
+        uint16_t flags;
+        uint16_t iflags;
+        uint16_t slot;
+        uint16_t parameterCount;
+    };
+};
+
+template <>
+struct MetadataLayout<MetadataLayoutVersion::V24_0> : MetadataLayout<MetadataLayoutVersion::V24_1> {
+    struct ImageDefinition {
+        StringIndex nameIndex;
+        AssemblyIndex assemblyIndex;
+        TypeDefinitionIndex typeStart;
+        uint32_t typeCount;
+        TypeDefinitionIndex exportedTypeStart;
+        uint32_t exportedTypeCount;
+        MethodIndex entryPointIndex;
+        uint32_t token;
+    };
+
+    struct TypeDefinition {
+        StringIndex nameIndex;
+        StringIndex namespaceIndex;
+        CustomAttributeIndex customAttributeIndex;
+        TypeIndex byvalTypeIndex;
+        TypeIndex byrefTypeIndex;
+        TypeIndex declaringTypeIndex;
+        TypeIndex parentIndex;
+        TypeIndex elementTypeIndex;
+        RGCTXIndex rgctxStartIndex;
+        int32_t rgctxCount;
+        GenericContainerIndex genericContainerIndex;
+        uint32_t flags;
+        FieldIndex fieldStart;
+        MethodIndex methodStart;
+        EventIndex eventStart;
+        PropertyIndex propertyStart;
+        NestedTypeIndex nestedTypesStart;
+        InterfacesIndex interfacesStart;
+        VTableIndex vtableStart;
+        InterfacesIndex interfaceOffsetsStart;
+        uint16_t method_count;
+        uint16_t property_count;
+        uint16_t field_count;
+        uint16_t event_count;
+        uint16_t nested_type_count;
+        uint16_t vtable_count;
+        uint16_t interfaces_count;
+        uint16_t interface_offsets_count;
+        uint32_t bitfield;
+        uint32_t token;
+    };
+
+    struct MethodDefinition {
+        StringIndex nameIndex;
+        TypeDefinitionIndex declaringType;
+        TypeIndex returnType;
+        ParameterIndex parameterStart;
+        CustomAttributeIndex customAttributeIndex;
+        GenericContainerIndex genericContainerIndex;
+        MethodIndex methodIndex;
+        MethodIndex invokerIndex;
+        MethodIndex delegateWrapperIndex;
+        RGCTXIndex rgctxStartIndex;
+        int32_t rgctxCount;
+        uint32_t token;
+        uint16_t flags;
+        uint16_t iflags;
+        uint16_t slot;
+        uint16_t parameterCount;
+    };
+
+    struct FieldDefinition {
+        StringIndex nameIndex;
+        TypeIndex typeIndex;
+        CustomAttributeIndex customAttributeIndex;
+        uint32_t token;
+    };
+
+    struct PropertyDefinition {
+        StringIndex nameIndex;
+        MethodIndex get;
+        MethodIndex set;
+        uint32_t attrs;
+        CustomAttributeIndex customAttributeIndex;
+        uint32_t token;
+    };
+
+    struct ParameterDefinition {
+        StringIndex nameIndex;
+        uint32_t token;
+        CustomAttributeIndex customAttributeIndex;
+        TypeIndex typeIndex;
+    };
+};
+
+template <>
+struct MetadataLayout<MetadataLayoutVersion::V27> : MetadataLayout<MetadataLayoutVersion::V24_2> {
+    struct Header {
+        Il2CppMetadataHeaderPrefix prefix;
+        int32_t imagesOffset;
+        int32_t imagesCount;
+        int32_t assembliesOffset;
+        int32_t assembliesCount;
+        int32_t fieldRefsOffset;
+        int32_t fieldRefsCount;
+        int32_t referencedAssembliesOffset;
+        int32_t referencedAssembliesCount;
+        int32_t attributesInfoOffset;
+        int32_t attributesInfoCount;
+        int32_t attributeTypesOffset;
+        int32_t attributeTypesCount;
+        int32_t unresolvedVirtualCallParameterTypesOffset;
+        int32_t unresolvedVirtualCallParameterTypesCount;
+        int32_t unresolvedVirtualCallParameterRangesOffset;
+        int32_t unresolvedVirtualCallParameterRangesCount;
+        int32_t windowsRuntimeTypeNamesOffset;
+        int32_t windowsRuntimeTypeNamesSize;
+        int32_t windowsRuntimeStringsOffset;
+        int32_t windowsRuntimeStringsSize;
+        int32_t exportedTypeDefinitionsOffset;
+        int32_t exportedTypeDefinitionsCount;
+    };
+
+    struct TypeDefinition {
+        StringIndex nameIndex;
+        StringIndex namespaceIndex;
+        TypeIndex byvalTypeIndex;
+        TypeIndex declaringTypeIndex;
+        TypeIndex parentIndex;
+        TypeIndex elementTypeIndex;
+        GenericContainerIndex genericContainerIndex;
+        uint32_t flags;
+        FieldIndex fieldStart;
+        MethodIndex methodStart;
+        EventIndex eventStart;
+        PropertyIndex propertyStart;
+        NestedTypeIndex nestedTypesStart;
+        InterfacesIndex interfacesStart;
+        VTableIndex vtableStart;
+        InterfacesIndex interfaceOffsetsStart;
+        uint16_t method_count;
+        uint16_t property_count;
+        uint16_t field_count;
+        uint16_t event_count;
+        uint16_t nested_type_count;
+        uint16_t vtable_count;
+        uint16_t interfaces_count;
+        uint16_t interface_offsets_count;
+        uint32_t bitfield;
+        uint32_t token;
+    };
+};
+
+template <>
+struct MetadataLayout<MetadataLayoutVersion::V29> : MetadataLayout<MetadataLayoutVersion::V27> {
+    struct Header {
+        Il2CppMetadataHeaderPrefix prefix;
+        int32_t imagesOffset;
+        int32_t imagesCount;
+        int32_t assembliesOffset;
+        int32_t assembliesCount;
+        int32_t fieldRefsOffset;
+        int32_t fieldRefsCount;
+        int32_t referencedAssembliesOffset;
+        int32_t referencedAssembliesCount;
+        int32_t attributeDataOffset;
+        int32_t attributeDataSize;
+        int32_t attributeDataRangeOffset;
+        int32_t attributeDataRangeSize;
+        int32_t unresolvedVirtualCallParameterTypesOffset;
+        int32_t unresolvedVirtualCallParameterTypesCount;
+        int32_t unresolvedVirtualCallParameterRangesOffset;
+        int32_t unresolvedVirtualCallParameterRangesCount;
+        int32_t windowsRuntimeTypeNamesOffset;
+        int32_t windowsRuntimeTypeNamesSize;
+        int32_t windowsRuntimeStringsOffset;
+        int32_t windowsRuntimeStringsSize;
+        int32_t exportedTypeDefinitionsOffset;
+        int32_t exportedTypeDefinitionsCount;
+    };
+};
+
+template <>
+struct MetadataLayout<MetadataLayoutVersion::V31> : MetadataLayout<MetadataLayoutVersion::V29> {
+    struct MethodDefinition {
+        StringIndex nameIndex;
+        TypeDefinitionIndex declaringType;
+        TypeIndex returnType;
+        uint32_t returnParameterToken;
+        ParameterIndex parameterStart;
+        GenericContainerIndex genericContainerIndex;
+        uint32_t token;
+        uint16_t flags;
+        uint16_t iflags;
+        uint16_t slot;
+        uint16_t parameterCount;
+    };
+};
+
+template <>
+struct MetadataLayout<MetadataLayoutVersion::V23> : MetadataLayout<MetadataLayoutVersion::V24_0> {
+    struct Header {
+        Il2CppMetadataHeaderPrefix prefix;
+        int32_t rgctxEntriesOffset;
+        int32_t rgctxEntriesCount;
+        int32_t imagesOffset;
+        int32_t imagesCount;
+        int32_t assembliesOffset;
+        int32_t assembliesCount;
+        int32_t metadataUsageListsOffset;
+        int32_t metadataUsageListsCount;
+        int32_t metadataUsagePairsOffset;
+        int32_t metadataUsagePairsCount;
+        int32_t fieldRefsOffset;
+        int32_t fieldRefsCount;
+        int32_t referencedAssembliesOffset;
+        int32_t referencedAssembliesCount;
+        int32_t attributesInfoOffset;
+        int32_t attributesInfoCount;
+        int32_t attributeTypesOffset;
+        int32_t attributeTypesCount;
+        int32_t unresolvedVirtualCallParameterTypesOffset;
+        int32_t unresolvedVirtualCallParameterTypesCount;
+        int32_t unresolvedVirtualCallParameterRangesOffset;
+        int32_t unresolvedVirtualCallParameterRangesCount;
+        int32_t windowsRuntimeTypeNamesOffset;
+        int32_t windowsRuntimeTypeNamesSize;
+    };
+
+    struct ImageDefinition {
+        StringIndex nameIndex;
+        AssemblyIndex assemblyIndex;
+        TypeDefinitionIndex typeStart;
+        uint32_t typeCount;
+        MethodIndex entryPointIndex;
+        uint32_t token;
+    };
+};
+
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V23>::Header) == 264, "v23 header");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_0>::Header) == 272, "v24.0 header");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_2>::Header) == 264, "v24.2 header");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V29>::Header) == 256, "v29 header");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_0>::TypeDefinition) == 104, "v24.0 type definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_1>::TypeDefinition) == 100, "v24.1 type definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_2>::TypeDefinition) == 92, "v24.2 type definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V27>::TypeDefinition) == 88, "v27 type definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_0>::MethodDefinition) == 56, "v24.0 method definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_1>::MethodDefinition) == 52, "v24.1 method definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_2>::MethodDefinition) == 32, "v24.2 method definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V31>::MethodDefinition) == 36, "v31 method definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V23>::ImageDefinition) == 24, "v23 image definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_0>::ImageDefinition) == 32, "v24.0 image definition");
+static_assert(sizeof(MetadataLayout<MetadataLayoutVersion::V24_2>::FieldDefinition) == 12, "v24.1+ field definition");
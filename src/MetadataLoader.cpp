@@ -1,17 +1,29 @@
 #include "MetadataLoader.h"
+#include "XorKeySearch.h"
+#include "ThreadPool.h"
+#include "JsonWriter.h"
+#include "BinaryExport.h"
+#include "AhoCorasick.h"
+#include "NameClassifier.h"
+#include "PatternScanner.h"
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <cctype>
+#include <charconv>
 #include <algorithm>
 #include <vector>
 #include <iomanip>
 #include <sstream>
 #include <regex>
+#include <set>
+#include <unordered_map>
+#include <filesystem>
 
 // Enhanced IL2CPP Dumper - Accurate Metadata Parsing
 // Based on Perfare's Il2CppDumper approach
 
-MetadataLoader::MetadataLoader() : header(nullptr), libBase(0), metadataOffset(0), isObfuscated(false) {
+MetadataLoader::MetadataLoader() : header(nullptr), libBase(0), addressesTried(false), addressesFound(false), metadataOffset(0), recoveredSymbols(nameArena), isObfuscated(false), threadCount(0), jsonLines(false), writeScriptJson(true), writeBinary(false) {
     InitializeObfuscationProfiles();
 }
 MetadataLoader::~MetadataLoader() {}
@@ -25,36 +37,57 @@ std::string get_verbose_log() {
 
 bool MetadataLoader::LoadFile(const std::string& filePath) {
     vlog << "[*] Loading metadata file: " << filePath << "\n";
-    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        vlog << "[-] Failed to open metadata file\n";
+    header = nullptr;
+    // Table lookups jump all over the file, so prefetch it rather than read ahead
+    if (!fileBuffer.Open(filePath, MappedFile::AccessHint::WillNeed)) {
+        vlog << "[-] Failed to open metadata file: " << fileBuffer.GetError() << "\n";
         return false;
     }
-    size_t size = file.tellg();
-    fileBuffer.resize(size);
-    file.seekg(0, std::ios::beg);
-    file.read(fileBuffer.data(), size);
-    file.close();
+    size_t size = fileBuffer.size();
+    vlog << "[*] " << (fileBuffer.IsMapped() ? "Mapped " : "Buffered ") << size << " bytes of metadata\n";
     
     // Validate and set up header
-    if (size < sizeof(Il2CppGlobalMetadataHeader)) {
+    Il2CppMetadataHeaderPrefix prefix;
+    if (size < sizeof(prefix)) {
         vlog << "[-] Metadata file too small to contain valid header\n";
         return false;
     }
-    
-    header = reinterpret_cast<const Il2CppGlobalMetadataHeader*>(fileBuffer.data());
+    // Offsets into the file are stored as 32-bit values (as in the format itself)
+    if (size > UINT32_MAX) {
+        vlog << "[-] Metadata file larger than 4GB is not supported\n";
+        return false;
+    }
+    memcpy(&prefix, fileBuffer.data(), sizeof(prefix));
     
     // Validate header
-    if (header->sanity != 0xFAB11BAF && header->sanity != 0xB11BFAF && header->sanity != 0xEAB11BAF) {
-        vlog << "[-] Invalid metadata header sanity check: 0x" << std::hex << header->sanity << std::dec << "\n";
+    if (prefix.sanity != 0xFAB11BAF && prefix.sanity != 0xB11BFAF && prefix.sanity != 0xEAB11BAF) {
+        vlog << "[-] Invalid metadata header sanity check: 0x" << std::hex << prefix.sanity << std::dec << "\n";
         return false;
     }
 
     // Validate header values to prevent crashes from malformed data
-    if (header->version < 16 || header->version > 32) {
-        vlog << "[-] Unexpected metadata version: " << header->version << "\n";
+    if (prefix.version < 16 || prefix.version > 32) {
+        vlog << "[-] Unexpected metadata version: " << prefix.version << "\n";
+        return false;
+    }
+
+    // The header and records are read in the layout of the file's version
+    // once, here; everything after works on the in-memory layout
+    if (!metadata.Load(fileBuffer)) {
+        vlog << "[-] Metadata file too small to contain valid header\n";
         return false;
     }
+    header = &metadata.Header();
+    if (header->version < 23) {
+        vlog << "[!] Metadata v" << header->version << " predates the v23 layout it is read with\n";
+    }
+    vlog << "[+] Record layout: " << MetadataLayoutName(metadata.Layout()) << ", "
+         << metadata.ConvertedBytes() / 1024 << " KB converted\n";
+    const MetadataSpan<Il2CppTypeDefinition>& types = metadata.Types();
+    const MetadataSpan<Il2CppMethodDefinition>& methods = metadata.Methods();
+    columns.Build(types.begin(), types.size(), methods.begin(), methods.size());
+    vlog << "[+] Columnar tables: " << columns.Types().Count() << " types, " << columns.Methods().Count()
+         << " methods (" << columns.MemoryUsage() / 1024 << " KB)\n";
 
     // For newer Unity versions (like 29), allow higher limits
     // But still validate against obviously wrong values
@@ -71,6 +104,10 @@ bool MetadataLoader::LoadFile(const std::string& filePath) {
         return false;
     }
 
+    // String lookups are resolved once here instead of on every access
+    BuildStringIndex();
+    BuildTypeHierarchy();
+
     vlog << "[+] Metadata loaded successfully. Version: " << header->version << "\n";
     vlog << "[+] String count: " << header->stringCount << ", Type count: " << header->typeDefinitionsCount << "\n";
     vlog << "[+] Method count: " << header->methodsCount << ", Field count: " << header->fieldsCount << "\n";
@@ -80,157 +117,440 @@ bool MetadataLoader::LoadFile(const std::string& filePath) {
 
 bool MetadataLoader::LoadLibrary(const std::string& libPath) { 
     vlog << "[*] Loading library: " << libPath << "\n";
-    std::ifstream file(libPath, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        vlog << "[-] Failed to open library file\n";
+    // The binary scanners walk the library front to back
+    if (!libBuffer.Open(libPath, MappedFile::AccessHint::Sequential)) {
+        vlog << "[-] Failed to open library file: " << libBuffer.GetError() << "\n";
         return false;
     }
-    size_t size = file.tellg();
-    libBuffer.resize(size);
-    file.seekg(0, std::ios::beg);
-    file.read(libBuffer.data(), size);
-    file.close();
+    vlog << "[*] " << (libBuffer.IsMapped() ? "Mapped " : "Buffered ") << libBuffer.size() << " bytes of library\n";
+    methodAddresses.clear();
+    addressesTried = addressesFound = false;
+
+    if (libImage.Parse(libBuffer.data(), libBuffer.size())) {
+        libBase = libImage.GetImageBase();
+        uint64_t codeBytes = 0, dataBytes = 0;
+        for (const auto& range : libImage.GetExecutableRanges()) codeBytes += range.end - range.begin;
+        for (const auto& range : libImage.GetDataRanges()) dataBytes += range.end - range.begin;
+        vlog << "[+] ELF " << libImage.GetMachineName() << (libImage.Is64Bit() ? " 64-bit" : " 32-bit")
+             << ", base 0x" << std::hex << libBase << std::dec << ", " << libImage.GetSegments().size() << " load segments, "
+             << libImage.GetSections().size() << " sections, " << libImage.RelocationCount() << " relative relocations\n";
+        vlog << "[+] Code: " << codeBytes << " bytes, data: " << dataBytes << " bytes\n";
+    } else {
+        libBase = 0;
+        vlog << "[!] Library is not a supported ELF image (" << libImage.GetError() << "), scanning the whole file\n";
+    }
     return true;
 }
 
-const char* MetadataLoader::GetStringFromIndex(StringIndex index) {
-    if (index == kMetadataInvalidPointer || !header || static_cast<uint32_t>(index) >= static_cast<uint32_t>(header->stringCount)) {
-        return "";
+namespace {
+
+// Character classes accepted inside a metadata string (isprint || isspace)
+struct StringCharTable {
+    bool valid[256];
+    StringCharTable() {
+        for (int c = 0; c < 256; c++) {
+            valid[c] = std::isprint(c) || std::isspace(c);
+        }
+    }
+};
+const StringCharTable kStringChars;
+
+// Length of the NUL-terminated string at p if it is made of accepted characters
+// and terminates within 1000 characters and before end; -1 otherwise
+int64_t MeasureMetadataString(const char* p, const char* end) {
+    const char* start = p;
+    int charCount = 0;
+    while (p < end && *p != '\0' && charCount < 1000) {
+        if (!kStringChars.valid[static_cast<unsigned char>(*p)]) {
+            return -1;
+        }
+        p++;
+        charCount++;
     }
+    if (p < end && *p == '\0') {
+        return p - start;
+    }
+    return -1;
+}
 
-    // Bounds check for stringOffset
-    if (static_cast<uint32_t>(header->stringOffset) >= fileBuffer.size()) {
-        return "";
+} // namespace
+
+void MetadataLoader::BuildStringIndex() {
+    stringTable.clear();
+
+    uint32_t count = static_cast<uint32_t>(header->stringCount);
+    size_t tableStart = static_cast<size_t>(static_cast<uint32_t>(header->stringOffset));
+    size_t tableEnd = tableStart + static_cast<size_t>(count) * sizeof(int32_t);
+    if (tableStart >= fileBuffer.size() || tableEnd > fileBuffer.size()) {
+        vlog << "[-] String offset table lies outside the metadata file\n";
+        return;
     }
 
-    // Calculate the end of the string offset table
-    size_t stringOffsetTableEnd = static_cast<size_t>(header->stringOffset) + (static_cast<size_t>(header->stringCount) * sizeof(int32_t));
-    if (stringOffsetTableEnd > fileBuffer.size()) {
-        return "";
+    const char* base = fileBuffer.data();
+    const char* end = base + fileBuffer.size();
+    const int32_t* offsets = reinterpret_cast<const int32_t*>(base + tableStart);
+    const char* stringData = base + tableEnd;
+    size_t stringDataSize = fileBuffer.size() - tableEnd;
+
+    // Start of every string when the data section is treated as a plain
+    // sequence of NUL-terminated strings. Only computed if some entry needs it.
+    std::vector<uint32_t> sequentialStarts;
+    auto buildSequentialStarts = [&]() {
+        sequentialStarts.reserve(count);
+        const char* current = stringData;
+        while (sequentialStarts.size() < count) {
+            sequentialStarts.push_back(static_cast<uint32_t>(current - base));
+            if (current >= end - 1) break;
+            const char* nul = static_cast<const char*>(memchr(current, '\0', end - current));
+            if (!nul) break;
+            current = nul + 1;
+        }
+    };
+
+    size_t relativeCount = 0, absoluteCount = 0, sequentialCount = 0, invalidCount = 0;
+    stringTable.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        StringEntry& entry = stringTable[i];
+        entry.offset = kInvalidStringOffset;
+        entry.length = 0;
+
+        int32_t stringOffset = offsets[i];
+        int64_t len;
+
+        // Relative to the start of the string data
+        if (stringOffset >= 0 && static_cast<size_t>(stringOffset) < stringDataSize &&
+            (len = MeasureMetadataString(stringData + stringOffset, end)) >= 0) {
+            entry.offset = static_cast<uint32_t>(tableEnd + stringOffset);
+            entry.length = static_cast<uint32_t>(len);
+            relativeCount++;
+            continue;
+        }
+
+        // Absolute offset from the file start (seen in some Unity 29 builds)
+        if (stringOffset >= 0 && static_cast<size_t>(stringOffset) < fileBuffer.size() &&
+            (len = MeasureMetadataString(base + stringOffset, end)) >= 0) {
+            entry.offset = static_cast<uint32_t>(stringOffset);
+            entry.length = static_cast<uint32_t>(len);
+            absoluteCount++;
+            continue;
+        }
+
+        // The index-th string in the data section
+        if (sequentialStarts.empty()) {
+            buildSequentialStarts();
+        }
+        if (i < sequentialStarts.size() && sequentialStarts[i] < fileBuffer.size() &&
+            (len = MeasureMetadataString(base + sequentialStarts[i], end)) >= 0) {
+            entry.offset = sequentialStarts[i];
+            entry.length = static_cast<uint32_t>(len);
+            sequentialCount++;
+            continue;
+        }
+
+        invalidCount++;
     }
 
-    // Calculate the actual offset using the header information
-    const char* stringStart = fileBuffer.data() + header->stringOffset;
-    const int32_t* stringOffsetTable = reinterpret_cast<const int32_t*>(stringStart);
+    vlog << "[+] String index built: " << relativeCount << " relative, " << absoluteCount << " absolute, "
+         << sequentialCount << " sequential, " << invalidCount << " unresolved\n";
+}
+
+namespace {
+
+// Start of a metadata table and how many whole elements of it lie inside
+// the file
+template <typename T>
+const T* MetadataTable(const MappedFile& file, int32_t offset, int32_t count, size_t& available) {
+    available = 0;
+    const size_t start = static_cast<uint32_t>(offset);
+    if (count <= 0 || start >= file.size()) return nullptr;
+    available = std::min<size_t>(static_cast<uint32_t>(count), (file.size() - start) / sizeof(T));
+    return reinterpret_cast<const T*>(file.data() + start);
+}
 
-    // Bounds check for the specific index in the offset table
-    if ((static_cast<size_t>(header->stringOffset) + (static_cast<size_t>(index) * sizeof(int32_t)) + sizeof(int32_t)) > fileBuffer.size()) {
-        return "";
+} // namespace
+
+void MetadataLoader::BuildTypeHierarchy(const std::vector<std::pair<TypeIndex, TypeDefinitionIndex>>& genericTypes) {
+    TypeHierarchy::Tables tables;
+    tables.types = metadata.Types().begin();
+    tables.typeCount = metadata.Types().size();
+    tables.nestedTypes = MetadataTable<TypeDefinitionIndex>(fileBuffer, header->nestedTypesOffset,
+                                                            header->nestedTypesCount, tables.nestedTypeCount);
+    tables.interfaces = MetadataTable<TypeIndex>(fileBuffer, header->interfacesOffset, header->interfacesCount,
+                                                 tables.interfaceCount);
+    typeHierarchy.Build(tables, genericTypes);
+
+    vlog << "[+] Type hierarchy built: " << typeHierarchy.TypeCount() << " types, "
+         << typeHierarchy.ResolvedParentCount() << " parents resolved (" << typeHierarchy.UnresolvedParentCount()
+         << " generic or unknown), " << typeHierarchy.NestedLinkCount() << " nested, "
+         << typeHierarchy.InterfaceLinkCount() << " interface links (" << typeHierarchy.MemoryUsage() / 1024
+         << " KB)\n";
+}
+
+void MetadataLoader::BuildTypeTable() {
+    if (!typeTable.IsEmpty() || !metadataRegistration.types) return;
+    if (!typeTable.Decode(libImage, metadataRegistration, header->version)) {
+        vlog << "[!] Il2CppType table at 0x" << std::hex << metadataRegistration.types << std::dec
+             << " could not be read\n";
+        return;
     }
 
-    // Get the offset for this string
-    int32_t stringOffset = stringOffsetTable[index];
-
-    // The string data starts after the offset table
-    const char* stringData = fileBuffer.data() + stringOffsetTableEnd;
-
-    // For Unity 29, the string offset might be absolute or relative differently
-    // Try multiple approaches:
-
-    // Approach 1: Standard relative to string data start
-    if (stringOffset >= 0 && static_cast<size_t>(stringOffset) < (fileBuffer.size() - (stringData - fileBuffer.data()))) {
-        const char* result = stringData + stringOffset;
-        if (result >= stringData && result < fileBuffer.data() + fileBuffer.size()) {
-            // Check if it's a valid string (starts with printable characters)
-            const char* p = result;
-            int charCount = 0;
-            while (p < fileBuffer.data() + fileBuffer.size() && *p != '\0' && charCount < 1000) { // Limit to avoid infinite loops
-                unsigned char c = static_cast<unsigned char>(*p);
-                // Accept alphanumeric, common symbols, and whitespace
-                if (isprint(c) || isspace(c)) {
-                    p++;
-                    charCount++;
-                } else {
-                    break; // Invalid character found
-                }
-            }
-            if (*p == '\0') { // Found null terminator
-                return result;
-            }
+    // Generic instances let the hierarchy resolve bases such as List<int>
+    std::vector<std::pair<TypeIndex, TypeDefinitionIndex>> genericTypes;
+    for (TypeIndex i = 0; i < typeTable.RegisteredCount(); i++) {
+        const TypeTable::Entry* entry = typeTable.Get(i);
+        if (entry->type == IL2CPP_TYPE_GENERICINST && entry->data != TypeTable::kNone) {
+            genericTypes.emplace_back(i, entry->data);
         }
     }
+    if (!genericTypes.empty()) BuildTypeHierarchy(genericTypes);
+
+    typeNames.Build(
+        typeTable,
+        [&](TextBuffer& out, TypeDefinitionIndex index, bool withoutArity) { WriteTypeName(out, index, withoutArity); },
+        [&](TextBuffer& out, GenericParameterIndex index) { WriteGenericParameterName(out, index); });
+    vlog << "[+] Type table decoded: " << typeTable.RegisteredCount() << " types, "
+         << typeTable.Count() - typeTable.RegisteredCount() << " more referenced by address, "
+         << typeTable.CanonicalCount() << " distinct, " << typeNames.UniqueNameCount() << " names ("
+         << typeTable.MemoryUsage() / 1024 << " KB)\n";
+
+    // Method specs by method, for listing the instances of each method
+    const std::vector<TypeTable::MethodSpec>& specs = typeTable.MethodSpecs();
+    const uint32_t methodCount = header->methodsCount > 0 ? static_cast<uint32_t>(header->methodsCount) : 0;
+    methodSpecStart.assign(methodCount + 1, 0);
+    for (const TypeTable::MethodSpec& spec : specs) {
+        if (spec.method < methodCount) methodSpecStart[spec.method + 1]++;
+    }
+    for (uint32_t i = 0; i < methodCount; i++) methodSpecStart[i + 1] += methodSpecStart[i];
+    methodSpecs.resize(methodSpecStart[methodCount]);
+    std::vector<uint32_t> fill(methodSpecStart.begin(), methodSpecStart.end() - 1);
+    for (uint32_t i = 0; i < specs.size(); i++) {
+        if (specs[i].method < methodCount) methodSpecs[fill[specs[i].method]++] = i;
+    }
+    vlog << "[+] Generic instances: " << typeTable.InstanceCount() << " distinct argument lists ("
+         << typeTable.RegisteredInstanceCount() << " registered), " << specs.size() << " method specs\n";
+}
 
-    // Approach 2: Absolute offset from file start
-    if (stringOffset >= 0 && static_cast<size_t>(stringOffset) < fileBuffer.size()) {
-        const char* result = fileBuffer.data() + stringOffset;
-        if (result >= fileBuffer.data() && result < fileBuffer.data() + fileBuffer.size()) {
-            // Check if it's a valid string
-            const char* p = result;
-            int charCount = 0;
-            while (p < fileBuffer.data() + fileBuffer.size() && *p != '\0' && charCount < 1000) {
-                unsigned char c = static_cast<unsigned char>(*p);
-                if (isprint(c) || isspace(c)) {
-                    p++;
-                    charCount++;
-                } else {
-                    break;
-                }
-            }
-            if (*p == '\0') {
-                return result;
-            }
+TypeDefinitionIndex MetadataLoader::FindTypeDefinition(std::string_view ns, std::string_view name) const {
+    const MetadataColumns::TypeColumns& types = columns.Types();
+    for (TypeDefinitionIndex i = 0; i < types.Count(); i++) {
+        if (LookupName(types.nameIndex[i]) == name && LookupName(types.namespaceIndex[i]) == ns) return i;
+    }
+    return TypeHierarchy::kNoType;
+}
+
+void MetadataLoader::WriteTypeName(TextBuffer& out, TypeDefinitionIndex index, bool withoutArity) {
+    // Nested types are written as Outer.Inner, like the runtime's full names
+    TypeDefinitionIndex chain[kMaxNestingDepth];
+    size_t depth = 0;
+    for (TypeDefinitionIndex type = index; type != TypeHierarchy::kNoType && depth < kMaxNestingDepth;
+         type = typeHierarchy.DeclaringType(type)) {
+        chain[depth++] = type;
+    }
+    for (size_t i = depth; i-- > 0;) {
+        const Il2CppTypeDefinition* typeDef = GetTypeDefinition(chain[i]);
+        if (!typeDef) continue;
+        std::string_view name = LookupName(typeDef->nameIndex);
+        // "Dictionary`2" -> "Dictionary"
+        const size_t tick = name.rfind('`');
+        if (withoutArity && tick != std::string_view::npos && tick + 1 < name.size() &&
+            name.find_first_not_of("0123456789", tick + 1) == std::string_view::npos) {
+            name = name.substr(0, tick);
         }
+        out.Write(name);
+        if (i) out.Put('.');
     }
+}
 
-    // Approach 3: Try to find the string in the string data section directly
-    // Sometimes the index refers to a position in the string data section
-    if (index < header->stringCount && stringOffsetTableEnd < fileBuffer.size()) {
-        // This is a fallback approach - try to find strings by scanning the string data section
-        // This is slower but might work for different Unity versions
-        const char* current = stringData;
-        StringIndex currentIndex = 0;
+const Il2CppGenericContainer* MetadataLoader::GetGenericContainer(GenericContainerIndex index, uint32_t owner,
+                                                                  bool isMethod) const {
+    size_t count;
+    const Il2CppGenericContainer* containers = header ? MetadataTable<Il2CppGenericContainer>(
+        fileBuffer, header->genericContainersOffset, header->genericContainersCount, count) : nullptr;
+    if (!containers || index >= count) return nullptr;
+    const Il2CppGenericContainer* container = containers + index;
+    if (container->ownerIndex != owner || (container->is_method != 0) != isMethod || container->type_argc <= 0) {
+        return nullptr;
+    }
+    return container;
+}
+
+const Il2CppGenericParameter* MetadataLoader::GetGenericParameter(GenericParameterIndex index) const {
+    size_t count;
+    const Il2CppGenericParameter* params = header ? MetadataTable<Il2CppGenericParameter>(
+        fileBuffer, header->genericParametersOffset, header->genericParametersCount, count) : nullptr;
+    return params && index < count ? params + index : nullptr;
+}
+
+void MetadataLoader::WriteGenericParameterName(TextBuffer& out, GenericParameterIndex index) const {
+    const Il2CppGenericParameter* param = GetGenericParameter(index);
+    const std::string_view name = param ? LookupName(param->nameIndex) : std::string_view();
+    if (name.empty()) {
+        out.Put('T');
+        out.WriteDec(index);
+    } else {
+        out.Write(name);
+    }
+}
 
-        while (currentIndex < index && current < fileBuffer.data() + fileBuffer.size() - 1) {
-            // Find the next null terminator
-            const char* start = current;
-            while (current < fileBuffer.data() + fileBuffer.size() && *current != '\0') {
-                current++;
+void MetadataLoader::WriteGenericParameters(TextBuffer& out, const Il2CppGenericContainer* container) const {
+    if (!container) return;
+    out.Put('<');
+    for (int32_t i = 0; i < container->type_argc; i++) {
+        const GenericParameterIndex index = container->genericParameterStart + i;
+        const Il2CppGenericParameter* param = GetGenericParameter(index);
+        if (i) out.Write(", ");
+        // Variance only applies to interface and delegate parameters
+        if (param && !container->is_method && (param->flags & kGenericParameterCovariant)) out.Write("out ");
+        if (param && !container->is_method && (param->flags & kGenericParameterContravariant)) out.Write("in ");
+        WriteGenericParameterName(out, index);
+    }
+    out.Put('>');
+}
+
+void MetadataLoader::WriteGenericConstraints(TextBuffer& out, const Il2CppGenericContainer* container) {
+    if (!container) return;
+    size_t constraintCount;
+    const TypeIndex* constraints = MetadataTable<TypeIndex>(fileBuffer, header->genericParameterConstraintsOffset,
+                                                            header->genericParameterConstraintsCount, constraintCount);
+    for (int32_t i = 0; i < container->type_argc; i++) {
+        const GenericParameterIndex index = container->genericParameterStart + i;
+        const Il2CppGenericParameter* param = GetGenericParameter(index);
+        if (!param) continue;
+        bool listed = false;
+        auto next = [&]() {
+            if (listed) {
+                out.Write(", ");
+                return;
             }
-            if (current < fileBuffer.data() + fileBuffer.size() && *current == '\0') {
-                current++; // Move past the null terminator
-                currentIndex++;
+            out.Write(" where ");
+            WriteGenericParameterName(out, index);
+            out.Write(" : ");
+            listed = true;
+        };
+        if (param->flags & kGenericParameterReferenceTypeConstraint) {
+            next();
+            out.Write("class");
+        } else if (param->flags & kGenericParameterValueTypeConstraint) {
+            next();
+            out.Write("struct");
+        }
+        const size_t first = static_cast<uint16_t>(param->constraintsStart);
+        for (int16_t c = 0; constraints && c < param->constraintsCount && first + c < constraintCount; c++) {
+            const TypeIndex type = constraints[first + c];
+            const std::string_view name = typeNames.Name(type);
+            const TypeDefinitionIndex resolved = typeHierarchy.Resolve(type);
+            // A struct constraint is also recorded as a System.ValueType one
+            if (name.empty() && resolved == TypeHierarchy::kNoType) continue;
+            if (name == "ValueType" && (param->flags & kGenericParameterValueTypeConstraint)) continue;
+            next();
+            if (name.empty()) {
+                WriteTypeName(out, resolved);
             } else {
-                break; // Reached end of buffer
+                out.Write(name);
             }
         }
+        if ((param->flags & kGenericParameterDefaultConstructorConstraint) &&
+            !(param->flags & kGenericParameterValueTypeConstraint)) {
+            next();
+            out.Write("new()");
+        }
+    }
+}
 
-        if (currentIndex == index && current < fileBuffer.data() + fileBuffer.size()) {
-            // We found the string at the right index
-            const char* result = current;
-            // Verify it's a valid string
-            const char* p = result;
-            int charCount = 0;
-            while (p < fileBuffer.data() + fileBuffer.size() && *p != '\0' && charCount < 1000) {
-                unsigned char c = static_cast<unsigned char>(*p);
-                if (isprint(c) || isspace(c)) {
-                    p++;
-                    charCount++;
-                } else {
-                    break;
-                }
-            }
-            if (*p == '\0') {
-                return result;
-            }
+void MetadataLoader::WriteMethodSpecName(TextBuffer& out, const TypeTable::MethodSpec& spec) {
+    const Il2CppMethodDefinition* methodDef = GetMethodDefinition(spec.method);
+    if (!methodDef) return;
+    WriteTypeName(out, methodDef->declaringType, true);
+    out.Write(typeNames.InstanceName(spec.classInstance));
+    out.Put('.');
+    out.Write(LookupName(methodDef->nameIndex));
+    out.Write(typeNames.InstanceName(spec.methodInstance));
+}
+
+void MetadataLoader::WriteTypeReference(TextBuffer& out, TypeIndex type, bool parameter) const {
+    const TypeTable::Entry* entry = typeTable.Get(type);
+    if (entry && entry->byref) {
+        const uint16_t direction = entry->attrs & (kParamAttributeIn | kParamAttributeOut);
+        if (parameter && direction == kParamAttributeOut) {
+            out.Write("out ");
+        } else if (parameter && direction == kParamAttributeIn) {
+            out.Write("in ");
+        } else {
+            out.Write("ref ");
         }
     }
+    const std::string_view name = typeNames.Name(type);
+    out.Write(name.empty() ? std::string_view("?") : name);
+}
 
-    return "";
+void MetadataLoader::WriteMethodSignature(TextBuffer& out, MethodIndex index, const Il2CppMethodDefinition* methodDef,
+                                          std::string_view name) const {
+    if (typeNames.IsEmpty()) {
+        out.Write("void ");
+        out.Write(name);
+        out.Write("()");
+        return;
+    }
+    WriteTypeReference(out, methodDef->returnType, false);
+    out.Put(' ');
+    out.Write(name);
+    WriteGenericParameters(out, GetGenericContainer(methodDef->genericContainerIndex, index, true));
+    out.Put('(');
+    for (uint16_t p = 0; p < methodDef->parameterCount; p++) {
+        const Il2CppParameterDefinition* paramDef = GetParameterDefinition(methodDef->parameterStart + p);
+        if (!paramDef) break;
+        if (p) out.Write(", ");
+        WriteTypeReference(out, paramDef->typeIndex, true);
+        out.Put(' ');
+        const std::string_view paramName = LookupName(paramDef->nameIndex);
+        if (paramName.empty()) {
+            out.Write("arg");
+            out.WriteDec(uint32_t(p));
+        } else {
+            out.Write(paramName);
+        }
+    }
+    out.Put(')');
+}
+
+const char* MetadataLoader::GetStringFromIndex(StringIndex index) {
+    if (index >= stringTable.size() || stringTable[index].offset == kInvalidStringOffset) {
+        return "";
+    }
+    return fileBuffer.data() + stringTable[index].offset;
 }
 
-std::string MetadataLoader::GetDecryptedString(StringIndex index) {
+std::string_view MetadataLoader::GetStringView(StringIndex index) const {
+    if (index >= stringTable.size() || stringTable[index].offset == kInvalidStringOffset) {
+        return std::string_view();
+    }
+    const StringEntry& entry = stringTable[index];
+    return std::string_view(fileBuffer.data() + entry.offset, entry.length);
+}
+
+std::string_view MetadataLoader::GetDecryptedString(StringIndex index) {
     // Check if we have already decrypted this string
-    if (decryptedStrings.find(index) != decryptedStrings.end()) {
-        return decryptedStrings[index];
+    std::string_view cached;
+    if (FindDecryptedString(index, cached)) {
+        return cached;
     }
     
-    const char* rawStr = GetStringFromIndex(index);
-    if (!rawStr || strlen(rawStr) == 0) {
+    std::string_view str = GetStringView(index);
+    if (str.empty()) {
         return "";
     }
     
-    std::string str(rawStr);
+    std::string_view decrypted = tryDecryption(str);
+    if (!decrypted.empty()) {
+        StoreDecryptedString(index, decrypted);
+        return decrypted;
+    }
     
+    // If not encrypted or decryption failed, return original
+    return str;
+}
+
+std::string_view MetadataLoader::tryDecryption(std::string_view str) {
     // Check if string looks encrypted (contains many non-printable chars)
     int nonPrintable = 0;
     for (char c : str) {
@@ -238,35 +558,78 @@ std::string MetadataLoader::GetDecryptedString(StringIndex index) {
             nonPrintable++;
         }
     }
+    if (nonPrintable <= static_cast<int>(str.length() * 0.3)) {
+        return "";
+    }
 
-    if (nonPrintable > static_cast<int>(str.length() * 0.3)) {
-        // Try multiple decryption algorithms
-        std::string decrypted = tryXORDecryption(str);
-        if (!decrypted.empty()) {
-            decryptedStrings[index] = decrypted;
-            return decrypted;
-        }
-        
-        decrypted = tryCaesarDecryption(str);
-        if (!decrypted.empty()) {
-            decryptedStrings[index] = decrypted;
-            return decrypted;
-        }
-        
-        decrypted = tryBase64Decryption(str);
-        if (!decrypted.empty()) {
-            decryptedStrings[index] = decrypted;
-            return decrypted;
-        }
+    // Try multiple decryption algorithms
+    std::string_view decrypted = tryXORDecryption(str);
+    if (decrypted.empty()) decrypted = tryCaesarDecryption(str);
+    if (decrypted.empty()) decrypted = tryBase64Decryption(str);
+    return decrypted;
+}
+
+bool MetadataLoader::FindDecryptedString(StringIndex index, std::string_view& value) const {
+    if (!decryptedStrings.Has(index)) {
+        return false;
     }
-    
-    // If not encrypted or decryption failed, return original
-    return str;
+    value = nameArena.View(decryptedStrings.Get(index));
+    return true;
+}
+
+void MetadataLoader::StoreDecryptedString(StringIndex index, std::string_view value) {
+    if (index >= static_cast<uint32_t>(header->stringCount)) return;
+    decryptedStrings.Reserve(static_cast<uint32_t>(header->stringCount));
+    decryptedStrings.Set(index, nameArena.Intern(value));
+}
+
+void MetadataLoader::SetThreadCount(unsigned count) {
+    threadCount = count;
+    threadPool.reset();
+}
+
+void MetadataLoader::SetCSOutputDirectory(const std::string& outputDir) {
+    csOutputDir = outputDir;
+}
+
+void MetadataLoader::SetJsonLines(bool enabled) {
+    jsonLines = enabled;
+}
+
+void MetadataLoader::SetScriptOutputs(bool json, bool binary) {
+    writeScriptJson = json;
+    writeBinary = binary;
+}
+
+void MetadataLoader::SetControlFlowOutput(const std::string& path) {
+    controlFlowOutput = path;
+}
+
+void MetadataLoader::SetNameModel(NameClassifier::Model model) {
+    nameClassifier.SetModel(std::move(model));
+}
+
+void MetadataLoader::SetProgressCallback(ProgressCallback callback) {
+    progressCallback = std::move(callback);
+}
+
+void MetadataLoader::ReportProgress(const char* task, uint64_t done, uint64_t total) {
+    if (progressCallback) {
+        progressCallback(task, done, total);
+    }
+}
+
+ThreadPool& MetadataLoader::GetThreadPool() {
+    if (!threadPool) {
+        threadPool = std::make_unique<ThreadPool>(threadCount);
+    }
+    return *threadPool;
 }
 
-std::string MetadataLoader::GetRecoveredSymbol(uint32_t token) {
-    if (recoveredSymbols.find(token) != recoveredSymbols.end()) {
-        return recoveredSymbols[token];
+std::string_view MetadataLoader::GetRecoveredSymbol(uint32_t token) {
+    std::string_view name;
+    if (recoveredSymbols.Find(token, name)) {
+        return name;
     }
     return ""; // Return empty if not found, will use original name
 }
@@ -311,15 +674,13 @@ void MetadataLoader::InitializeObfuscationProfiles() {
             int shortNameCount = 0;
             int totalCount = 0;
             
-            for (TypeDefinitionIndex i = 0; i < (header->typeDefinitionsCount < 1000 ? header->typeDefinitionsCount : 1000); i++) {
-                const Il2CppTypeDefinition* typeDef = GetTypeDefinition(i);
-                if (typeDef) {
-                    std::string name(GetStringFromIndex(typeDef->nameIndex));
-                    if (name.length() <= 2) {
-                        shortNameCount++;
-                    }
-                    totalCount++;
+            const std::vector<StringIndex>& names = columns.Types().nameIndex;
+            for (TypeDefinitionIndex i = 0; i < std::min<size_t>(names.size(), 1000); i++) {
+                std::string name(GetStringFromIndex(names[i]));
+                if (name.length() <= 2) {
+                    shortNameCount++;
                 }
+                totalCount++;
             }
             
             return (totalCount > 0) && ((double)shortNameCount / totalCount > 0.7);
@@ -376,80 +737,82 @@ DeobfuscationResult MetadataLoader::ApplyDeobfuscation() {
 }
 
 void MetadataLoader::ApplyStringDecryption() {
-    // Decrypt all strings in the string pool
-    for (StringIndex i = 0; i < header->stringCount; i++) {
-        const char* rawStr = GetStringFromIndex(i);
-        if (!rawStr || strlen(rawStr) == 0) continue;
-
-        std::string str(rawStr);
-        
-        // Check if string looks encrypted (contains many non-printable chars)
-        int nonPrintable = 0;
-        for (char c : str) {
-            if (!std::isprint(static_cast<unsigned char>(c)) && c != '\0') {
-                nonPrintable++;
-            }
-        }
-
-        if (nonPrintable > static_cast<int>(str.length() * 0.3)) {
-            // Try multiple decryption algorithms
-            std::string decrypted = tryXORDecryption(str);
-            if (!decrypted.empty()) {
-                decryptedStrings[i] = decrypted;
-                continue;
-            }
-
-            decrypted = tryCaesarDecryption(str);
-            if (!decrypted.empty()) {
-                decryptedStrings[i] = decrypted;
-                continue;
+    // Decrypt all strings in the string pool. Strings are independent, so the
+    // index range is split into chunks that workers decrypt into their own
+    // result lists; these are merged into the dense table afterwards.
+    ThreadPool& pool = GetThreadPool();
+    uint32_t stringCount = static_cast<uint32_t>(header->stringCount);
+    std::vector<std::vector<std::pair<StringIndex, std::string_view>>> workerResults(pool.GetThreadCount());
+
+    pool.ParallelFor(stringCount, 4096, [&](size_t begin, size_t end, unsigned worker) {
+        auto& results = workerResults[worker];
+        for (StringIndex i = static_cast<StringIndex>(begin); i < end; i++) {
+            std::string_view str = GetStringView(i);
+            if (str.empty()) continue;
+            
+            // Check if string looks encrypted (contains many non-printable chars)
+            int nonPrintable = 0;
+            for (char c : str) {
+                if (!std::isprint(static_cast<unsigned char>(c)) && c != '\0') {
+                    nonPrintable++;
+                }
             }
 
-            decrypted = tryBase64Decryption(str);
-            if (!decrypted.empty()) {
-                decryptedStrings[i] = decrypted;
-                continue;
+            if (nonPrintable > static_cast<int>(str.length() * 0.3)) {
+                // Try multiple decryption algorithms
+                std::string_view decrypted = tryXORDecryption(str);
+                if (decrypted.empty()) decrypted = tryCaesarDecryption(str);
+                if (decrypted.empty()) decrypted = tryBase64Decryption(str);
+                if (decrypted.empty()) decrypted = tryRot13Decryption(str);
+                if (!decrypted.empty()) {
+                    results.emplace_back(i, decrypted);
+                }
             }
+        }
+    });
 
-            decrypted = tryRot13Decryption(str);
-            if (!decrypted.empty()) {
-                decryptedStrings[i] = decrypted;
-                continue;
-            }
+    size_t decryptedCount = 0;
+    for (auto& results : workerResults) {
+        for (auto& entry : results) {
+            StoreDecryptedString(entry.first, entry.second);
+            decryptedCount++;
         }
     }
+    vlog << "[+] Decrypted " << decryptedCount << " strings using " << pool.GetThreadCount() << " threads\n";
 }
 
-std::string MetadataLoader::tryXORDecryption(const std::string& encrypted) {
-    for (int key = 1; key <= 255; key++) {
-        std::string decrypted = encrypted;
-        for (char& c : decrypted) {
-            if (static_cast<unsigned char>(c) != 0) {
-                c ^= key;
-            }
-        }
+namespace {
 
-        // Check if decryption produced mostly printable text
-        int printable = 0;
-        for (char c : decrypted) {
-            if (std::isprint(static_cast<unsigned char>(c)) || c == '\0') {
-                printable++;
-            }
-        }
+// Per-thread buffer the decryption routines decode candidates into, so trying
+// a key or shift does not allocate; only accepted results are interned
+std::string& DecryptionScratch() {
+    thread_local std::string scratch;
+    return scratch;
+}
 
-        if (printable > static_cast<int>(decrypted.length() * 0.8)) {
-            // Additional check: see if the result contains common string patterns
-            if (hasCommonStringPatterns(decrypted)) {
-                return decrypted;
-            }
-        }
+} // namespace
+
+std::string_view MetadataLoader::tryXORDecryption(std::string_view encrypted) {
+    // Score all keys in one vectorized pass; only the winning key is decoded
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(encrypted.data());
+    XorKeyScore best = FindBestXorKey(data, encrypted.size());
+    if (best.key == 0) {
+        return "";
+    }
+
+    std::string& decrypted = DecryptionScratch();
+    decrypted.resize(encrypted.size());
+    XorDecode(data, encrypted.size(), best.key, &decrypted[0]);
+    if (hasCommonStringPatterns(decrypted)) {
+        return nameArena.InternView(decrypted);
     }
     return "";
 }
 
-std::string MetadataLoader::tryCaesarDecryption(const std::string& encrypted) {
+std::string_view MetadataLoader::tryCaesarDecryption(std::string_view encrypted) {
+    std::string& decrypted = DecryptionScratch();
     for (int shift = 1; shift <= 25; shift++) {
-        std::string decrypted = encrypted;
+        decrypted.assign(encrypted.data(), encrypted.size());
         for (char& c : decrypted) {
             if (std::isalpha(static_cast<unsigned char>(c))) {
                 char base = std::islower(static_cast<unsigned char>(c)) ? 'a' : 'A';
@@ -467,21 +830,21 @@ std::string MetadataLoader::tryCaesarDecryption(const std::string& encrypted) {
 
         if (printable > static_cast<int>(decrypted.length() * 0.8)) {
             if (hasCommonStringPatterns(decrypted)) {
-                return decrypted;
+                return nameArena.InternView(decrypted);
             }
         }
     }
     return "";
 }
 
-std::string MetadataLoader::tryBase64Decryption(const std::string& encrypted) {
+std::string_view MetadataLoader::tryBase64Decryption(std::string_view encrypted) {
     // Basic Base64 alphabet
-    const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    static constexpr std::string_view base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
     
     // Check if the string looks like Base64 (alphanumeric + +/ and possibly ending with =)
     bool isBase64Like = true;
     for (char c : encrypted) {
-        if (base64_chars.find(c) == std::string::npos && c != '=') {
+        if (base64_chars.find(c) == std::string_view::npos && c != '=') {
             isBase64Like = false;
             break;
         }
@@ -490,7 +853,8 @@ std::string MetadataLoader::tryBase64Decryption(const std::string& encrypted) {
     if (!isBase64Like) return "";
     
     // Simple Base64 decode implementation
-    std::string decoded = base64_decode(encrypted);
+    std::string& decoded = DecryptionScratch();
+    base64_decode(encrypted, decoded);
 
     // Check if the result is printable
     int printable = 0;
@@ -502,15 +866,16 @@ std::string MetadataLoader::tryBase64Decryption(const std::string& encrypted) {
 
     if (printable > static_cast<int>(decoded.length() * 0.8)) {
         if (hasCommonStringPatterns(decoded)) {
-            return decoded;
+            return nameArena.InternView(decoded);
         }
     }
 
     return "";
 }
 
-std::string MetadataLoader::tryRot13Decryption(const std::string& encrypted) {
-    std::string decrypted = encrypted;
+std::string_view MetadataLoader::tryRot13Decryption(std::string_view encrypted) {
+    std::string& decrypted = DecryptionScratch();
+    decrypted.assign(encrypted.data(), encrypted.size());
     for (char& c : decrypted) {
         if (std::isalpha(static_cast<unsigned char>(c))) {
             char base = std::islower(static_cast<unsigned char>(c)) ? 'a' : 'A';
@@ -528,19 +893,16 @@ std::string MetadataLoader::tryRot13Decryption(const std::string& encrypted) {
 
     if (printable > static_cast<int>(decrypted.length() * 0.8)) {
         if (hasCommonStringPatterns(decrypted)) {
-            return decrypted;
+            return nameArena.InternView(decrypted);
         }
     }
     return "";
 }
 
-std::string MetadataLoader::tryCustomPatternDecryption(const std::string& encrypted) {
+std::string_view MetadataLoader::tryCustomPatternDecryption(std::string_view encrypted) {
     // Common obfuscation patterns used in IL2CPP
     // This could include character substitution, byte manipulation, etc.
     
-    // Example: Character swapping or substitution
-    std::string result = encrypted;
-    
     // Try to detect and reverse simple substitution patterns
     // This is a placeholder for more complex pattern detection
     
@@ -548,8 +910,8 @@ std::string MetadataLoader::tryCustomPatternDecryption(const std::string& encryp
     // we might be able to reverse engineer the substitution
     
     // Another common technique: reversed strings
-    std::string reversed = result;
-    std::reverse(reversed.begin(), reversed.end());
+    std::string& reversed = DecryptionScratch();
+    reversed.assign(encrypted.rbegin(), encrypted.rend());
     
     int printable = 0;
     for (char c : reversed) {
@@ -560,7 +922,7 @@ std::string MetadataLoader::tryCustomPatternDecryption(const std::string& encryp
     
     if (printable > static_cast<int>(reversed.length() * 0.8)) {
         if (hasCommonStringPatterns(reversed)) {
-            return reversed;
+            return nameArena.InternView(reversed);
         }
     }
     
@@ -595,9 +957,9 @@ std::string MetadataLoader::processObfuscatedString(const std::string& input) {
     return result;
 }
 
-bool MetadataLoader::hasCommonStringPatterns(const std::string& str) {
+bool MetadataLoader::hasCommonStringPatterns(std::string_view str) {
     // Check for common string patterns that indicate successful decryption
-    std::vector<std::string> commonPatterns = {
+    static constexpr std::string_view commonPatterns[] = {
         "System.", "UnityEngine.", "Mono.", "Console.", "Debug.", 
         "get_", "set_", "ctor", "cctor", "ToString", "Equals",
         "Length", "Count", "Add", "Remove", "Clear", "Find",
@@ -608,7 +970,7 @@ bool MetadataLoader::hasCommonStringPatterns(const std::string& str) {
     };
     
     for (const auto& pattern : commonPatterns) {
-        if (str.find(pattern) != std::string::npos) {
+        if (str.find(pattern) != std::string_view::npos) {
             return true;
         }
     }
@@ -639,26 +1001,24 @@ bool MetadataLoader::hasCommonStringPatterns(const std::string& str) {
     return letterRatio >= 0.4f; // At least 40% should be letters
 }
 
-std::string MetadataLoader::base64_decode(const std::string& input) {
-    const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-    std::string output;
+void MetadataLoader::base64_decode(std::string_view input, std::string& output) {
+    static constexpr std::string_view base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    output.clear();
     int val = 0, valb = -8;
     
     for (unsigned char c : input) {
         if (c == '=') break; // Stop at padding
         
-        int pos = base64_chars.find(c);
-        if (pos == std::string::npos) break; // Invalid character
+        size_t pos = base64_chars.find(c);
+        if (pos == std::string_view::npos) break; // Invalid character
         
-        val = (val << 6) + pos;
+        val = (val << 6) + static_cast<int>(pos);
         valb += 6;
         if (valb >= 0) {
             output.push_back(char((val >> valb) & 0xFF));
             valb -= 8;
         }
     }
-    
-    return output;
 }
 
 void MetadataLoader::ApplyControlFlowRestoration() {
@@ -669,119 +1029,494 @@ void MetadataLoader::ApplyControlFlowRestoration() {
         return;
     }
     
+    // Recover real instructions and basic blocks first, so the detectors can
+    // work on them where the library allows it
+    restoreLinearControlFlow();
+
     // Identify common obfuscation patterns in the binary
     identifyDispatcherPatterns();
     identifySwitchStatementObfuscation();
     identifyJunkCode();
+
+    // Undo flattening where the graph shows a dispatcher loop
+    unflattenControlFlow();
     
     vlog << "[+] Control flow restoration completed\n";
 }
 
+bool MetadataLoader::LoadSignatureFile(const std::string& path) {
+    std::string error;
+    size_t before = customSignatures.Count();
+    if (!customSignatures.LoadFile(path, error)) {
+        vlog << "[-] Failed to load signatures: " << error << "\n";
+        return false;
+    }
+    vlog << "[+] Loaded " << (customSignatures.Count() - before) << " signatures from " << path << "\n";
+    return true;
+}
+
+std::vector<ElfImage::FileRange> MetadataLoader::LibraryRanges(bool code) const {
+    if (libImage.IsValid()) {
+        return code ? libImage.GetExecutableRanges() : libImage.GetDataRanges();
+    }
+    // Not an ELF image we understand: everything is a candidate
+    return {ElfImage::FileRange{0, libBuffer.size()}};
+}
+
+namespace {
+
+// Library ranges are scanned in chunks on the thread pool. A match belongs to
+// the chunk it starts in; the scan of a chunk reads up to the longest pattern
+// length past its end (but not past the end of its range) so that matches
+// straddling the boundary are still seen.
+constexpr uint64_t kScanChunkSize = 1 << 20;
+
+struct ScanChunk {
+    uint64_t begin;
+    uint64_t end;
+    uint64_t rangeBegin;
+    uint64_t rangeEnd;
+};
+
+std::vector<ScanChunk> SplitIntoChunks(const std::vector<ElfImage::FileRange>& ranges) {
+    std::vector<ScanChunk> chunks;
+    for (const ElfImage::FileRange& range : ranges) {
+        for (uint64_t begin = range.begin; begin < range.end; begin += kScanChunkSize) {
+            chunks.push_back({begin, std::min(begin + kScanChunkSize, range.end), range.begin, range.end});
+        }
+    }
+    return chunks;
+}
+
+// Run of detector events no more than maxGap bytes apart: branches of a
+// switch cluster, or the overlapping "nop x3" matches of one NOP run
+struct EventRun {
+    uint64_t first;
+    uint64_t last;
+    uint32_t count;
+};
+
+// Collects the runs of one chunk. Runs in the middle of a chunk are final and
+// only kept if they qualify; the first and last run may continue into the
+// neighbouring chunks, so they are always kept for MergeRuns().
+class RunCollector {
+public:
+    RunCollector(uint64_t maxGap, bool (*qualifies)(const EventRun&)) : maxGap(maxGap), qualifies(qualifies) {}
+
+    void Add(uint64_t position) {
+        if (!runs.empty() && position - runs.back().last <= maxGap) {
+            runs.back().last = position;
+            runs.back().count++;
+            return;
+        }
+        if (runs.size() > 1 && !qualifies(runs.back())) runs.pop_back();
+        runs.push_back({position, position, 1});
+    }
+
+    std::vector<EventRun> runs;
+
+private:
+    uint64_t maxGap;
+    bool (*qualifies)(const EventRun&);
+};
+
+// Joins the runs of consecutive chunks and calls emit for every finished run
+// that qualifies. Call with an empty list at the end of each range.
+template <typename Emit>
+void MergeRuns(const std::vector<EventRun>& runs, uint64_t maxGap, bool (*qualifies)(const EventRun&),
+               EventRun& pending, bool& hasPending, Emit&& emit) {
+    for (const EventRun& run : runs) {
+        if (hasPending && run.first - pending.last <= maxGap) {
+            pending.last = run.last;
+            pending.count += run.count;
+            continue;
+        }
+        if (hasPending && qualifies(pending)) emit(pending);
+        pending = run;
+        hasPending = true;
+    }
+}
+
+// Branches less than 10 bytes apart form a cluster; more than 5 of them look
+// like a flattened switch
+constexpr uint64_t kBranchGap = 9;
+bool IsBranchCluster(const EventRun& run) { return run.count > 5; }
+// A run of n NOPs produces n - 2 consecutive "nop x3" matches
+constexpr uint64_t kNopGap = 1;
+uint32_t NopCount(const EventRun& run) { return static_cast<uint32_t>(run.last + 3 - run.first); }
+bool IsNopRun(const EventRun& run) { return NopCount(run) > 5; }
+
+} // namespace
+
+void MetadataLoader::ScanLibrary() {
+    if (libraryScan.done || libBuffer.empty()) return;
+    libraryScan = LibraryScanResults();
+    libraryScan.done = true;
+
+    // Every code detector registers its signatures with one scanner; the
+    // matches of a single pass over the executable ranges are then routed to
+    // the detectors
+    PatternScanner codeScanner;
+    const PatternScanner::SignatureId dispatcherId = codeScanner.Add("dispatcher", "48 8B 05 ?? ?? ?? ?? 48 FF E0"); // mov rax, [rip+disp32]; jmp rax
+    const PatternScanner::SignatureId jccShortId = codeScanner.Add("jcc rel8", "7?");
+    const PatternScanner::SignatureId jccNearId = codeScanner.Add("jcc rel32", "0F 8?");
+    const PatternScanner::SignatureId jcxzId = codeScanner.Add("jcxz", "E3");
+    const PatternScanner::SignatureId nopId = codeScanner.Add("nop x3", "90 90 90");
+    const PatternScanner::SignatureId firstCustomId = static_cast<PatternScanner::SignatureId>(codeScanner.Count());
+    for (PatternScanner::SignatureId id = 0; id < customSignatures.Count(); id++) {
+        codeScanner.Add(customSignatures.Get(id));
+    }
+    codeScanner.Compile();
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(libBuffer.data());
+    ThreadPool& pool = GetThreadPool();
+
+    struct CodeChunkResult {
+        std::vector<uint64_t> dispatchers;
+        RunCollector branches{kBranchGap, IsBranchCluster};
+        RunCollector nops{kNopGap, IsNopRun};
+        std::vector<SignatureHit> signatureHits;
+    };
+    const std::vector<ScanChunk> codeChunks = SplitIntoChunks(LibraryRanges(true));
+    std::vector<CodeChunkResult> codeResults(codeChunks.size());
+    pool.ParallelFor(codeChunks.size(), 1, [&](size_t first, size_t last, unsigned) {
+        for (size_t c = first; c < last; c++) {
+            const ScanChunk& chunk = codeChunks[c];
+            CodeChunkResult& result = codeResults[c];
+            const uint64_t scanEnd = std::min<uint64_t>(chunk.end + codeScanner.MaxLength(), chunk.rangeEnd);
+            codeScanner.Scan(data + chunk.begin, scanEnd - chunk.begin, [&](PatternScanner::SignatureId id, size_t position) {
+                const uint64_t offset = chunk.begin + position;
+                if (offset >= chunk.end) return;
+                if (id == dispatcherId) {
+                    result.dispatchers.push_back(offset);
+                } else if (id == jccShortId || id == jccNearId || id == jcxzId) {
+                    result.branches.Add(offset);
+                } else if (id == nopId) {
+                    result.nops.Add(offset);
+                } else if (id >= firstCustomId) {
+                    result.signatureHits.push_back({id - firstCustomId, offset});
+                }
+            });
+        }
+    });
+
+    // Merge in chunk order, so the results do not depend on the thread count;
+    // runs may continue across chunks but not across ranges
+    EventRun pendingBranches = {}, pendingNops = {};
+    bool hasBranches = false, hasNops = false;
+    auto emitCluster = [&](const EventRun& run) { libraryScan.branchClusters.push_back({run.last, run.count}); };
+    auto emitNops = [&](const EventRun& run) { libraryScan.nopRuns.push_back({run.first, NopCount(run)}); };
+    auto finishRange = [&]() {
+        if (hasBranches && IsBranchCluster(pendingBranches)) emitCluster(pendingBranches);
+        if (hasNops && IsNopRun(pendingNops)) emitNops(pendingNops);
+        hasBranches = hasNops = false;
+    };
+    for (size_t c = 0; c < codeChunks.size(); c++) {
+        if (c > 0 && codeChunks[c].rangeBegin != codeChunks[c - 1].rangeBegin) finishRange();
+        CodeChunkResult& result = codeResults[c];
+        libraryScan.dispatchers.insert(libraryScan.dispatchers.end(), result.dispatchers.begin(), result.dispatchers.end());
+        libraryScan.signatureHits.insert(libraryScan.signatureHits.end(), result.signatureHits.begin(), result.signatureHits.end());
+        MergeRuns(result.branches.runs, kBranchGap, IsBranchCluster, pendingBranches, hasBranches, emitCluster);
+        MergeRuns(result.nops.runs, kNopGap, IsNopRun, pendingNops, hasNops, emitNops);
+        result = CodeChunkResult();
+    }
+    finishRange();
+
+    // Names are looked for in the data ranges only
+    PatternScanner stringScanner;
+    stringScanner.Add("symbol", "53 79 73 74 65 6D 2E"); // "System."
+    stringScanner.Compile();
+    const std::vector<ScanChunk> dataChunks = SplitIntoChunks(LibraryRanges(false));
+    std::vector<std::vector<LibraryRange>> symbolResults(dataChunks.size());
+    pool.ParallelFor(dataChunks.size(), 1, [&](size_t first, size_t last, unsigned) {
+        for (size_t c = first; c < last; c++) {
+            const ScanChunk& chunk = dataChunks[c];
+            const uint64_t scanEnd = std::min<uint64_t>(chunk.end + stringScanner.MaxLength(), chunk.rangeEnd);
+            stringScanner.Scan(data + chunk.begin, scanEnd - chunk.begin, [&](PatternScanner::SignatureId, size_t position) {
+                const uint64_t offset = chunk.begin + position;
+                if (offset >= chunk.end) return;
+                // Extend the match over the rest of the qualified name
+                uint64_t end = offset;
+                while (end < chunk.rangeEnd &&
+                       (std::isalnum(data[end]) || data[end] == '.' || data[end] == '_' || data[end] == '<' || data[end] == '>' || data[end] == '`')) {
+                    end++;
+                }
+                symbolResults[c].push_back({offset, static_cast<uint32_t>(end - offset)});
+            });
+        }
+    });
+    for (const auto& symbols : symbolResults) {
+        libraryScan.symbols.insert(libraryScan.symbols.end(), symbols.begin(), symbols.end());
+    }
+}
+
 void MetadataLoader::identifyDispatcherPatterns() {
-    // Look for common dispatcher patterns used in control flow flattening
-    const char* data = libBuffer.data();
-    size_t dataSize = libBuffer.size();
-    
-    // Pattern: sequences of conditional jumps followed by indirect jumps
-    // This is typical of flattened control flow
-    for (size_t i = 0; i < dataSize - 10; i++) {
-        // Look for common x86-64 dispatcher patterns
-        // This is a simplified example - real implementation would be more complex
-        if (data[i] == 0x48 && data[i+1] == 0x8B && data[i+2] == 0x05) { // mov rax, [rip+disp32]
-            // This could be loading a function pointer or state variable
-            // Followed by jump to rax
-            if (i + 10 < dataSize && data[i+7] == 0x48 && data[i+8] == 0xFF && data[i+9] == 0xE0) { // jmp rax
-                vlog << "[+] Found potential dispatcher pattern at 0x" << std::hex << i << std::dec << "\n";
+    // Look for common dispatcher patterns used in control flow flattening:
+    // loading a function pointer or state variable followed by a jump to it
+    ScanLibrary();
+    for (uint64_t offset : libraryScan.dispatchers) {
+        vlog << "[+] Found potential dispatcher pattern at 0x" << std::hex << offset << std::dec << "\n";
+    }
+
+    // With real instructions, an indirect jump is reported only in a
+    // dispatcher's shape: the jump, or the chain of compare blocks falling
+    // into it, is the target of a back edge, i.e. the header of the loop
+    // every case returns to. Switch tables and tail calls through registers
+    // are only counted.
+    if (controlFlow.IsEmpty()) return;
+    size_t indirectJumps = 0, dispatchers = 0;
+    std::vector<uint8_t> loopHeader;
+    for (size_t f = 0; f < controlFlow.FunctionCount(); f++) {
+        const ControlFlowGraph::Function& function = controlFlow.GetFunction(f);
+        const ControlFlowGraph::Block* blocks = controlFlow.GetBlocks(function);
+        loopHeader.assign(function.blockCount, 0);
+        for (uint32_t b = 0; b < function.blockCount; b++) {
+            for (uint32_t successor : blocks[b].successors) {
+                if (successor != ControlFlowGraph::kNoBlock && successor <= b) loopHeader[successor] = 1;
             }
         }
+        for (uint32_t b = 0; b < function.blockCount; b++) {
+            if (blocks[b].terminator != InstructionFlow::IndirectJump) continue;
+            indirectJumps++;
+            uint32_t head = b;
+            while (!loopHeader[head] && head > 0 && blocks[head - 1].terminator == InstructionFlow::ConditionalJump &&
+                   blocks[head - 1].successors[1] == head) {
+                head--;
+            }
+            if (!loopHeader[head]) continue;
+            dispatchers++;
+            vlog << "[+] Found indirect jump dispatcher at 0x" << std::hex << function.address + blocks[b].offset + blocks[b].size
+                 << " in function 0x" << function.address << " (loop header 0x" << function.address + blocks[head].offset
+                 << ")" << std::dec << "\n";
+        }
     }
+    vlog << "[+] " << indirectJumps << " indirect jumps in swept functions, " << dispatchers
+         << " heading a dispatcher loop\n";
 }
 
 void MetadataLoader::identifySwitchStatementObfuscation() {
     // Look for obfuscated switch statements
     // These often manifest as large blocks of conditional branches
-    const char* data = libBuffer.data();
-    size_t dataSize = libBuffer.size();
-    
-    // Count conditional branch instructions in proximity
-    int consecutiveBranches = 0;
-    size_t lastBranchPos = 0;
-    
-    for (size_t i = 0; i < dataSize - 1; i++) {
-        // Common conditional jump opcodes (x86-64)
-        if ((data[i] & 0xF0) == 0x70 ||                           // jcc rel8
-            (data[i] == 0x0F && (data[i+1] & 0xF0) == 0x80) ||   // jcc rel32
-            (data[i] == 0xE3)) {                                 // jcxz
-            if (lastBranchPos == 0 || i - lastBranchPos < 10) {
-                consecutiveBranches++;
-            } else {
-                if (consecutiveBranches > 5) {
-                    vlog << "[+] Found potential obfuscated switch with " << consecutiveBranches << " consecutive branches at 0x" << std::hex << lastBranchPos << std::dec << "\n";
+    if (!controlFlow.IsEmpty()) {
+        // Decoded code: a chain of short compare-and-branch blocks, each
+        // falling through into the next
+        for (size_t f = 0; f < controlFlow.FunctionCount(); f++) {
+            const ControlFlowGraph::Function& function = controlFlow.GetFunction(f);
+            const ControlFlowGraph::Block* blocks = controlFlow.GetBlocks(function);
+            uint32_t chain = 0;
+            for (uint32_t b = 0; b <= function.blockCount; b++) {
+                const bool link = b < function.blockCount && blocks[b].terminator == InstructionFlow::ConditionalJump &&
+                                  blocks[b].instructionCount <= 3 && blocks[b].successors[1] == b + 1;
+                if (link) {
+                    chain++;
+                    continue;
                 }
-                consecutiveBranches = 1;
+                if (chain > 5) {
+                    const ControlFlowGraph::Block& last = blocks[b - 1];
+                    vlog << "[+] Found potential obfuscated switch with " << chain << " consecutive branches at 0x" << std::hex
+                         << function.address + last.offset << " in function 0x" << function.address << std::dec << "\n";
+                }
+                chain = 0;
             }
-            lastBranchPos = i;
         }
+        return;
     }
-    
-    if (consecutiveBranches > 5) {
-        vlog << "[+] Found potential obfuscated switch with " << consecutiveBranches << " consecutive branches at 0x" << std::hex << lastBranchPos << std::dec << "\n";
+
+    // Without a CFG, fall back to clusters of branch opcodes in the raw bytes
+    ScanLibrary();
+    for (const auto& cluster : libraryScan.branchClusters) {
+        vlog << "[+] Found potential obfuscated switch with " << cluster.count << " consecutive branches at 0x" << std::hex << cluster.offset << std::dec << "\n";
     }
 }
 
 void MetadataLoader::identifyJunkCode() {
     // Look for junk code insertion patterns
     // These are often NOP sleds or meaningless operations inserted to confuse analysis
-    
-    const char* data = libBuffer.data();
-    size_t dataSize = libBuffer.size();
-    
-    // Look for repeated patterns that might be junk
-    for (size_t i = 0; i < dataSize - 16; i++) {
-        // Check for NOP patterns
-        if (data[i] == 0x90 && data[i+1] == 0x90 && data[i+2] == 0x90) { // Multiple NOPs
-            int nopCount = 3;
-            while (i + nopCount < dataSize && data[i + nopCount] == 0x90) {
-                nopCount++;
-            }
-            if (nopCount > 5) {
-                vlog << "[+] Found " << nopCount << " consecutive NOPs at 0x" << std::hex << i << std::dec << "\n";
+    ScanLibrary();
+    for (const auto& run : libraryScan.nopRuns) {
+        vlog << "[+] Found " << run.count << " consecutive NOPs at 0x" << std::hex << run.offset << std::dec << "\n";
+    }
+}
+
+void MetadataLoader::ReportSignatureMatches() {
+    if (customSignatures.Count() == 0 || libBuffer.empty()) return;
+    ScanLibrary();
+    std::vector<uint32_t> perSignature(customSignatures.Count(), 0);
+    for (const auto& hit : libraryScan.signatureHits) {
+        vlog << "[+] Signature '" << customSignatures.Get(hit.signature).name << "' matched at 0x" << std::hex << hit.offset << std::dec << "\n";
+        perSignature[hit.signature]++;
+    }
+    for (PatternScanner::SignatureId id = 0; id < customSignatures.Count(); id++) {
+        vlog << "[*] Signature '" << customSignatures.Get(id).name << "': " << perSignature[id] << " matches\n";
+    }
+}
+
+bool MetadataLoader::ResolveMethodAddresses() {
+    // The locator scans the whole library, so the outcome is kept, failure
+    // included
+    if (addressesTried) return addressesFound;
+    if (!header || libBuffer.empty()) return false;
+    addressesTried = true;
+    if (!libImage.IsValid()) {
+        vlog << "[!] Method addresses need an ELF library, skipping\n";
+        return false;
+    }
+    // Older metadata indexes one global method pointer table instead of per
+    // image modules
+    if (metadata.Layout() < MetadataLayoutVersion::V24_2) {
+        vlog << "[!] Method address resolution needs metadata v24.2 or newer (found "
+             << MetadataLayoutName(metadata.Layout()) << ")\n";
+        return false;
+    }
+
+    const uint32_t imageCount = header->imagesCount > 0 ? static_cast<uint32_t>(header->imagesCount) : 0;
+    const MetadataSpan<Il2CppImageDefinition>& images = metadata.Images();
+    std::vector<std::string_view> imageNames(imageCount);
+    for (ImageIndex i = 0; i < images.size(); i++) imageNames[i] = LookupName(images[i].nameIndex);
+
+    RegistrationLocator locator(libImage, libBuffer.data());
+    if (locator.FindMetadataRegistration(static_cast<uint32_t>(header->typeDefinitionsCount), metadataRegistration)) {
+        vlog << "[+] MetadataRegistration at 0x" << std::hex << metadataRegistration.address << std::dec
+             << " (" << metadataRegistration.typesCount << " types, " << metadataRegistration.methodSpecsCount << " method specs)\n";
+    } else {
+        vlog << "[!] MetadataRegistration not found\n";
+    }
+    if (!locator.FindCodeRegistration(imageNames, codeRegistration)) {
+        vlog << "[-] CodeRegistration not found, method addresses are unknown\n";
+        return false;
+    }
+    vlog << "[+] CodeRegistration.codeGenModules at 0x" << std::hex
+         << (codeRegistration.codeGenModulesField ? codeRegistration.codeGenModulesField : codeRegistration.codeGenModules)
+         << std::dec << " (" << codeRegistration.modules.size() << " modules)\n";
+
+    // Each image's methods index its module's methodPointers by token rid, so
+    // one walk over the images fills the table for O(1) lookups afterwards
+    const uint32_t methodCount = header->methodsCount > 0 ? static_cast<uint32_t>(header->methodsCount) : 0;
+    methodAddresses.assign(methodCount, 0);
+    const size_t pointerSize = libImage.PointerSize();
+    const bool thumb = libImage.GetMachine() == ElfImage::Machine::ARM;
+    uint32_t resolved = 0;
+    const MetadataSpan<Il2CppMethodDefinition>& methods = metadata.Methods();
+    for (ImageIndex i = 0; i < images.size(); i++) {
+        const Il2CppImageDefinition& imageDef = images[i];
+        const CodeGenModuleInfo& module = codeRegistration.modules[i];
+        if (!module.methodPointers) continue;
+
+        for (const Il2CppTypeDefinition& typeDef : metadata.Types().Slice(imageDef.typeStart, imageDef.typeCount)) {
+            for (const Il2CppMethodDefinition& methodDef : methods.Slice(typeDef.methodStart, typeDef.method_count)) {
+                const MethodIndex methodIdx = methods.IndexOf(methodDef);
+                uint32_t rid = methodDef.token & 0x00FFFFFF;
+                if (rid == 0 || rid > module.methodPointerCount) continue;
+
+                uint64_t pointer;
+                if (!libImage.ReadPointer(module.methodPointers + (rid - 1) * pointerSize, pointer) || pointer == 0) continue;
+                // Thumb entry points have the low bit set
+                if (thumb) pointer &= ~uint64_t(1);
+                methodAddresses[methodIdx] = pointer - libBase;
+                resolved++;
             }
-            i += nopCount - 1; // Skip the NOPs we just found
         }
-        
-        // Look for other junk patterns (e.g., push/pop pairs that cancel out)
-        // This is a simplified example
     }
+    vlog << "[+] Resolved addresses for " << resolved << " of " << methodCount << " methods\n";
+    addressesFound = true;
+    return true;
 }
 
 void MetadataLoader::restoreLinearControlFlow() {
-    // Algorithm to restore linear control flow from flattened structures
-    // This would involve reconstructing the original control flow graph
-    
-    // In a real implementation, this would:
-    // 1. Identify basic blocks
-    // 2. Reconstruct the control flow graph
-    // 3. Identify the original program structure
-    // 4. Generate deobfuscated representation
-    
-    vlog << "[*] Linear control flow restoration would reconstruct the original CFG\n";
+    // Sweep every method with a known address into basic blocks and a CFG
+    if (!controlFlow.IsEmpty()) return;
+    if (!libImage.IsValid() || !InstructionDecoder::IsSupported(libImage.GetMachine())) {
+        vlog << "[!] Control flow recovery needs an AArch64 or x86-64 ELF library\n";
+        return;
+    }
+    if (!ResolveMethodAddresses()) {
+        vlog << "[!] No function addresses known, skipping control flow recovery\n";
+        return;
+    }
+
+    std::vector<uint64_t> starts;
+    starts.reserve(methodAddresses.size());
+    for (uint64_t rva : methodAddresses) {
+        if (rva) starts.push_back(libBase + rva);
+    }
+    controlFlow.Build(libImage, libBuffer.data(), std::move(starts), GetThreadPool());
+    vlog << "[+] Control flow graph: " << controlFlow.FunctionCount() << " functions, " << controlFlow.BlockCount()
+         << " blocks, " << controlFlow.EdgeCount() << " edges (" << controlFlow.MemoryUsage() / 1024 << " KB)\n";
 }
 
+void MetadataLoader::unflattenControlFlow() {
+    if (controlFlow.IsEmpty()) return;
+    unflattener.Run(controlFlow, GetThreadPool());
+    vlog << "[+] Unflattened " << unflattener.FlattenedCount() << " of " << controlFlow.FunctionCount() << " functions: "
+         << unflattener.EdgeCount() << " edges recovered, " << unflattener.UnresolvedCount() << " unresolved\n";
+}
+
+// Output of one symbol recovery pass. The table is cut into fixed-size
+// chunks and every chunk has its own slot, written only by the task that
+// processes it, so the passes need no locks. Slots are merged in chunk order,
+// which keeps the symbols and the log independent of scheduling.
+struct SymbolRecoveryOutput {
+    struct Name {
+        uint32_t index;
+        bool inferred;          // Recovered from an obfuscated name, logged on merge
+        std::string_view name;
+    };
+    struct Chunk {
+        std::vector<Name> names;
+        std::vector<std::pair<StringIndex, std::string_view>> decrypted;
+    };
+    std::vector<Chunk> chunks;
+};
+
+namespace {
+
+constexpr size_t kRecoveryChunkSize = 4096;
+
+// Calls fn(index, name, obfuscated, chunk) for every element of a table of
+// count elements, chunk-parallel on the pool. The names of a chunk, from
+// nameOf(index, chunk), are classified together in one batch.
+template <typename NameFn, typename Fn>
+void RunRecoveryPass(ThreadPool& pool, const NameClassifier& classifier, size_t count, SymbolRecoveryOutput& out,
+                     NameFn&& nameOf, Fn&& fn) {
+    out.chunks.resize((count + kRecoveryChunkSize - 1) / kRecoveryChunkSize);
+    pool.ParallelFor(count, kRecoveryChunkSize, [&](size_t begin, size_t end, unsigned) {
+        SymbolRecoveryOutput::Chunk& chunk = out.chunks[begin / kRecoveryChunkSize];
+        std::string_view names[kRecoveryChunkSize];
+        uint64_t obfuscated[kRecoveryChunkSize / 64];
+        for (size_t i = begin; i < end; i++) names[i - begin] = nameOf(static_cast<uint32_t>(i), chunk);
+        classifier.Classify(names, end - begin, obfuscated);
+        for (size_t i = begin; i < end; i++) {
+            const size_t n = i - begin;
+            fn(static_cast<uint32_t>(i), names[n], (obfuscated[n / 64] >> (n % 64)) & 1, chunk);
+        }
+    });
+}
+
+} // namespace
+
 void MetadataLoader::ApplySymbolRecovery() {
     vlog << "[*] Starting symbol recovery...\n";
-    
-    // 1. Recover class names
-    recoverClassNames();
-    
-    // 2. Recover method names
-    recoverMethodNames();
-    
-    // 3. Recover field names
-    recoverFieldNames();
-    
-    // 4. Recover property names
-    recoverPropertyNames();
+    recoveredSymbols.Reserve(static_cast<uint32_t>(header->typeDefinitionsCount),
+                             static_cast<uint32_t>(header->fieldsCount),
+                             static_cast<uint32_t>(header->methodsCount),
+                             static_cast<uint32_t>(header->propertiesCount));
+    
+    // 1-4. Recover class, method, field and property names. The tables are
+    // independent, so the four passes run as concurrent tasks that each spread
+    // their table over the pool; the results are merged in table order.
+    ThreadPool& pool = GetThreadPool();
+    SymbolRecoveryOutput classes, methods, fields, properties;
+    ThreadPool::TaskGroup passes;
+    pool.Submit(passes, [&](unsigned) { recoverClassNames(classes); });
+    pool.Submit(passes, [&](unsigned) { recoverMethodNames(methods); });
+    pool.Submit(passes, [&](unsigned) { recoverFieldNames(fields); });
+    pool.Submit(passes, [&](unsigned) { recoverPropertyNames(properties); });
+    pool.Wait(passes);
+
+    mergeRecoveredNames(classes, RecoveredSymbolTable::kTypeTable, "class");
+    mergeRecoveredNames(methods, RecoveredSymbolTable::kMethodTable, "method");
+    mergeRecoveredNames(fields, RecoveredSymbolTable::kFieldTable, "field");
+    mergeRecoveredNames(properties, RecoveredSymbolTable::kPropertyTable, "property");
     
     // 5. Cross-reference with binary if available
     if (!libBuffer.empty()) {
@@ -791,240 +1526,203 @@ void MetadataLoader::ApplySymbolRecovery() {
     vlog << "[+] Symbol recovery completed\n";
 }
 
-void MetadataLoader::recoverClassNames() {
-    for (TypeDefinitionIndex i = 0; i < header->typeDefinitionsCount; i++) {
-        const Il2CppTypeDefinition* typeDef = GetTypeDefinition(i);
-        if (!typeDef) continue;
-        
-        std::string name = GetDecryptedString(typeDef->nameIndex);
-        if (name.empty()) {
-            name = GetStringFromIndex(typeDef->nameIndex);
+std::string_view MetadataLoader::recoveryName(StringIndex index,
+                                              std::vector<std::pair<StringIndex, std::string_view>>& decrypted) {
+    std::string_view name;
+    if (FindDecryptedString(index, name)) {
+        return name;
+    }
+    name = GetStringView(index);
+    std::string_view plain = name.empty() ? std::string_view() : tryDecryption(name);
+    if (plain.empty()) {
+        return name;
+    }
+    decrypted.emplace_back(index, plain);
+    return plain;
+}
+
+void MetadataLoader::mergeRecoveredNames(const SymbolRecoveryOutput& out, uint32_t table, const char* kind) {
+    for (const SymbolRecoveryOutput::Chunk& chunk : out.chunks) {
+        for (const auto& entry : chunk.decrypted) {
+            StoreDecryptedString(entry.first, entry.second);
         }
-        
-        uint32_t token = 0x02000000 + i;
-        
-        // If name is too short or looks obfuscated, try to recover a better one
-        if (isObfuscatedName(name)) {
-            std::string recoveredName = inferClassName(i, typeDef);
-            if (!recoveredName.empty()) {
-                recoveredSymbols[token] = recoveredName;
-                vlog << "[+] Recovered class name: " << recoveredName << " for token 0x" << std::hex << token << std::dec << "\n";
-            }
-        } else {
-            // Even if the name looks valid, we might still want to enhance it
-            std::string enhancedName = enhanceClassName(name, i);
-            if (enhancedName != name) {
-                recoveredSymbols[token] = enhancedName;
+        for (const SymbolRecoveryOutput::Name& entry : chunk.names) {
+            uint32_t token = (table << 24) | entry.index;
+            recoveredSymbols.Set(token, entry.name);
+            if (entry.inferred) {
+                vlog << "[+] Recovered " << kind << " name: " << entry.name << " for token 0x" << std::hex << token
+                     << std::dec << "\n";
             }
         }
     }
 }
 
-void MetadataLoader::recoverMethodNames() {
-    for (MethodIndex i = 0; i < header->methodsCount; i++) {
-        const Il2CppMethodDefinition* methodDef = GetMethodDefinition(i);
-        if (!methodDef) continue;
-        
-        std::string name = GetDecryptedString(methodDef->nameIndex);
-        if (name.empty()) {
-            name = GetStringFromIndex(methodDef->nameIndex);
-        }
-        
-        uint32_t token = 0x06000000 + i;
-        
-        // If name is obfuscated, try to recover a better one
-        if (isObfuscatedName(name)) {
-            std::string recoveredName = inferMethodName(i, methodDef);
-            if (!recoveredName.empty()) {
-                recoveredSymbols[token] = recoveredName;
-                vlog << "[+] Recovered method name: " << recoveredName << " for token 0x" << std::hex << token << std::dec << "\n";
+void MetadataLoader::recoverClassNames(SymbolRecoveryOutput& out) {
+    const std::vector<StringIndex>& names = columns.Types().nameIndex;
+    RunRecoveryPass(GetThreadPool(), nameClassifier, names.size(), out,
+        [&](TypeDefinitionIndex i, SymbolRecoveryOutput::Chunk& chunk) { return recoveryName(names[i], chunk.decrypted); },
+        [&](TypeDefinitionIndex i, std::string_view name, bool obfuscated, SymbolRecoveryOutput::Chunk& chunk) {
+            // If name is too short or looks obfuscated, try to recover a better one
+            if (obfuscated) {
+                std::string_view recoveredName = inferClassName(i, GetTypeDefinition(i));
+                if (!recoveredName.empty()) {
+                    chunk.names.push_back({i, true, recoveredName});
+                }
+            } else {
+                // Even if the name looks valid, we might still want to enhance it
+                std::string_view enhancedName = enhanceClassName(name, i);
+                if (enhancedName != name) {
+                    chunk.names.push_back({i, false, enhancedName});
+                }
             }
-        } else {
-            // Enhance the name if possible
-            std::string enhancedName = enhanceMethodName(name, i);
-            if (enhancedName != name) {
-                recoveredSymbols[token] = enhancedName;
+        });
+}
+
+void MetadataLoader::recoverMethodNames(SymbolRecoveryOutput& out) {
+    const std::vector<StringIndex>& names = columns.Methods().nameIndex;
+    RunRecoveryPass(GetThreadPool(), nameClassifier, names.size(), out,
+        [&](MethodIndex i, SymbolRecoveryOutput::Chunk& chunk) { return recoveryName(names[i], chunk.decrypted); },
+        [&](MethodIndex i, std::string_view name, bool obfuscated, SymbolRecoveryOutput::Chunk& chunk) {
+            // If name is obfuscated, try to recover a better one
+            if (obfuscated) {
+                std::string_view recoveredName = inferMethodName(i, GetMethodDefinition(i));
+                if (!recoveredName.empty()) {
+                    chunk.names.push_back({i, true, recoveredName});
+                }
+            } else {
+                // Enhance the name if possible
+                std::string_view enhancedName = enhanceMethodName(name, i);
+                if (enhancedName != name) {
+                    chunk.names.push_back({i, false, enhancedName});
+                }
             }
-        }
-    }
+        });
 }
 
-void MetadataLoader::recoverFieldNames() {
-    for (FieldIndex i = 0; i < header->fieldsCount; i++) {
-        const Il2CppFieldDefinition* fieldDef = GetFieldDefinition(i);
-        if (!fieldDef) continue;
-        
-        std::string name = GetDecryptedString(fieldDef->nameIndex);
-        if (name.empty()) {
-            name = GetStringFromIndex(fieldDef->nameIndex);
-        }
-        
-        uint32_t token = 0x04000000 + i;
-        
-        // If name is obfuscated, try to recover a better one
-        if (isObfuscatedName(name)) {
-            std::string recoveredName = inferFieldName(i, fieldDef);
-            if (!recoveredName.empty()) {
-                recoveredSymbols[token] = recoveredName;
-                vlog << "[+] Recovered field name: " << recoveredName << " for token 0x" << std::hex << token << std::dec << "\n";
+void MetadataLoader::recoverFieldNames(SymbolRecoveryOutput& out) {
+    const MetadataSpan<Il2CppFieldDefinition>& fields = metadata.Fields();
+    RunRecoveryPass(GetThreadPool(), nameClassifier, fields.size(), out,
+        [&](FieldIndex i, SymbolRecoveryOutput::Chunk& chunk) { return recoveryName(fields[i].nameIndex, chunk.decrypted); },
+        [&](FieldIndex i, std::string_view, bool obfuscated, SymbolRecoveryOutput::Chunk& chunk) {
+            // If name is obfuscated, try to recover a better one
+            if (obfuscated) {
+                std::string_view recoveredName = inferFieldName(i, &fields[i]);
+                if (!recoveredName.empty()) {
+                    chunk.names.push_back({i, true, recoveredName});
+                }
             }
-        }
-    }
+        });
 }
 
-void MetadataLoader::recoverPropertyNames() {
-    for (PropertyIndex i = 0; i < header->propertiesCount; i++) {
-        const Il2CppPropertyDefinition* propDef = GetPropertyDefinition(i);
-        if (!propDef) continue;
-        
-        std::string name = GetDecryptedString(propDef->nameIndex);
-        if (name.empty()) {
-            name = GetStringFromIndex(propDef->nameIndex);
-        }
-        
-        uint32_t token = 0x07000000 + i;
-        
-        // If name is obfuscated, try to recover a better one
-        if (isObfuscatedName(name)) {
-            std::string recoveredName = inferPropertyName(i, propDef);
-            if (!recoveredName.empty()) {
-                recoveredSymbols[token] = recoveredName;
-                vlog << "[+] Recovered property name: " << recoveredName << " for token 0x" << std::hex << token << std::dec << "\n";
+void MetadataLoader::recoverPropertyNames(SymbolRecoveryOutput& out) {
+    const MetadataSpan<Il2CppPropertyDefinition>& properties = metadata.Properties();
+    RunRecoveryPass(GetThreadPool(), nameClassifier, properties.size(), out,
+        [&](PropertyIndex i, SymbolRecoveryOutput::Chunk& chunk) {
+            return recoveryName(properties[i].nameIndex, chunk.decrypted);
+        },
+        [&](PropertyIndex i, std::string_view, bool obfuscated, SymbolRecoveryOutput::Chunk& chunk) {
+            // If name is obfuscated, try to recover a better one
+            if (obfuscated) {
+                std::string_view recoveredName = inferPropertyName(i, &properties[i]);
+                if (!recoveredName.empty()) {
+                    chunk.names.push_back({i, true, recoveredName});
+                }
             }
-        }
-    }
+        });
 }
 
-bool MetadataLoader::isObfuscatedName(const std::string& name) {
-    if (name.empty()) return true;
-    
-    // Check for common obfuscation patterns
-    if (name.length() <= 2) {
-        // Very short names are often obfuscated
-        if (std::all_of(name.begin(), name.end(), ::isalpha)) {
-            return true;
-        }
-    }
-    
-    // Check for random-looking names (many vowels or consonants in sequence)
-    int vowelCount = 0;
-    int consonantCount = 0;
-    for (char c : name) {
-        if (std::tolower(c) == 'a' || std::tolower(c) == 'e' || std::tolower(c) == 'i' || 
-            std::tolower(c) == 'o' || std::tolower(c) == 'u') {
-            vowelCount++;
-            consonantCount = 0; // reset
-        } else if (std::isalpha(c)) {
-            consonantCount++;
-            vowelCount = 0; // reset
-        }
-        
-        // If we have 4+ consecutive vowels or consonants, likely obfuscated
-        if (vowelCount >= 4 || consonantCount >= 4) {
-            return true;
-        }
-    }
-    
-    // Check for names that look like hex or random strings
-    if (name.length() >= 6) {
-        int alphaCount = 0;
-        int digitCount = 0;
-        int upperCount = 0;
-        
-        for (char c : name) {
-            if (std::isalpha(c)) alphaCount++;
-            if (std::isdigit(c)) digitCount++;
-            if (std::isupper(c)) upperCount++;
-        }
-        
-        // High ratio of digits or mixed case without clear pattern suggests obfuscation
-        float digitRatio = static_cast<float>(digitCount) / name.length();
-        if (digitRatio > 0.3f) return true;  // More than 30% digits
-        
-        // Names with many uppercase letters randomly placed might be obfuscated
-        float upperRatio = static_cast<float>(upperCount) / name.length();
-        if (upperRatio > 0.5f && alphaCount > 5) return true;  // More than 50% uppercase
-    }
-    
-    return false;
+bool MetadataLoader::isObfuscatedName(std::string_view name) {
+    return nameClassifier.IsObfuscated(name);
 }
 
-std::string MetadataLoader::inferClassName(TypeDefinitionIndex index, const Il2CppTypeDefinition* typeDef) {
+std::string_view MetadataLoader::MakeIndexedName(std::string_view prefix, uint32_t index) {
+    char buffer[96];
+    size_t length = std::min(prefix.size(), sizeof(buffer) - 16);
+    memcpy(buffer, prefix.data(), length);
+    char* end = std::to_chars(buffer + length, buffer + sizeof(buffer), index).ptr;
+    return nameArena.InternView(std::string_view(buffer, end - buffer));
+}
+
+std::string_view MetadataLoader::inferClassName(TypeDefinitionIndex index, const Il2CppTypeDefinition* typeDef) {
     // Try to infer a meaningful class name based on context and patterns
     // This is a simplified approach - real implementation would be more sophisticated
     
-    // Check if this class extends a known type
-    if (typeDef->parentIndex != kMetadataInvalidPointer) {
-        // Try to get parent class name to infer child class name
-        std::string parentName = GetStringFromIndex(typeDef->parentIndex);
+    // Check if this class extends a known type, directly or through
+    // (possibly obfuscated) intermediate classes
+    TypeDefinitionIndex ancestor = typeHierarchy.Parent(index);
+    for (size_t depth = 0; ancestor != TypeHierarchy::kNoType && depth < typeHierarchy.TypeCount(); depth++) {
+        const Il2CppTypeDefinition* ancestorDef = GetTypeDefinition(ancestor);
+        if (!ancestorDef) break;
+        std::string_view parentName = GetStringView(ancestorDef->nameIndex);
         if (!parentName.empty() && !isObfuscatedName(parentName)) {
             if (parentName == "MonoBehaviour") {
-                return "GameBehavior_" + std::to_string(index);
+                return MakeIndexedName("GameBehavior_", index);
             } else if (parentName == "ScriptableObject") {
-                return "GameData_" + std::to_string(index);
-            } else if (parentName.find("Component") != std::string::npos) {
-                return "Component_" + std::to_string(index);
+                return MakeIndexedName("GameData_", index);
+            } else if (parentName.find("Component") != std::string_view::npos) {
+                return MakeIndexedName("Component_", index);
             }
         }
+        ancestor = typeHierarchy.Parent(ancestor);
     }
     
     // Check namespace for hints
-    std::string ns = GetStringFromIndex(typeDef->namespaceIndex);
+    std::string_view ns = GetStringView(typeDef->namespaceIndex);
     if (!ns.empty()) {
-        if (ns.find("UI") != std::string::npos) {
-            return "UIElement_" + std::to_string(index);
-        } else if (ns.find("Network") != std::string::npos) {
-            return "NetworkClass_" + std::to_string(index);
-        } else if (ns.find("Audio") != std::string::npos) {
-            return "AudioClass_" + std::to_string(index);
+        if (ns.find("UI") != std::string_view::npos) {
+            return MakeIndexedName("UIElement_", index);
+        } else if (ns.find("Network") != std::string_view::npos) {
+            return MakeIndexedName("NetworkClass_", index);
+        } else if (ns.find("Audio") != std::string_view::npos) {
+            return MakeIndexedName("AudioClass_", index);
         }
     }
     
     // Default fallback
-    return "Class_" + std::to_string(index);
+    return MakeIndexedName("Class_", index);
 }
 
-std::string MetadataLoader::inferMethodName(MethodIndex index, const Il2CppMethodDefinition* methodDef) {
+std::string_view MetadataLoader::inferMethodName(MethodIndex index, const Il2CppMethodDefinition* methodDef) {
     // Try to infer a meaningful method name
+    std::string_view name = GetStringView(methodDef->nameIndex);
+
     // Look at the declaring type to get context
     if (methodDef->declaringType != kMetadataInvalidPointer) {
         // We could look up the declaring type name, but for simplicity we'll use patterns
         // Check if this looks like a getter/setter
-        std::string name = GetStringFromIndex(methodDef->nameIndex);
         if (name.length() >= 3) {
             if (name.substr(0, 3) == "get") {
-                return "GetValue_" + std::to_string(index);
+                return MakeIndexedName("GetValue_", index);
             } else if (name.substr(0, 3) == "set") {
-                return "SetValue_" + std::to_string(index);
+                return MakeIndexedName("SetValue_", index);
             }
         }
     }
     
     // Check for constructor patterns
-    std::string name = GetStringFromIndex(methodDef->nameIndex);
     if (name == ".ctor") {
-        return "Constructor";
+        return nameArena.InternView("Constructor");
     } else if (name == ".cctor") {
-        return "StaticConstructor";
+        return nameArena.InternView("StaticConstructor");
     }
     
     // Default fallback
-    return "Method_" + std::to_string(index);
+    return MakeIndexedName("Method_", index);
 }
 
-std::string MetadataLoader::inferFieldName(FieldIndex index, const Il2CppFieldDefinition* fieldDef) {
+std::string_view MetadataLoader::inferFieldName(FieldIndex index, const Il2CppFieldDefinition*) {
     // Infer field names based on type or common patterns
     // Default fallback
-    return "Field_" + std::to_string(index);
+    return MakeIndexedName("Field_", index);
 }
 
-std::string MetadataLoader::inferPropertyName(PropertyIndex index, const Il2CppPropertyDefinition* propDef) {
+std::string_view MetadataLoader::inferPropertyName(PropertyIndex index, const Il2CppPropertyDefinition*) {
     // Infer property names
     // Default fallback
-    return "Property_" + std::to_string(index);
+    return MakeIndexedName("Property_", index);
 }
 
-std::string MetadataLoader::enhanceClassName(const std::string& original, TypeDefinitionIndex index) {
+std::string_view MetadataLoader::enhanceClassName(std::string_view original, TypeDefinitionIndex) {
     // Enhance class names that are valid but could be more descriptive
     if (original.length() > 2 && !isObfuscatedName(original)) {
         // Already a good name, maybe add context
@@ -1033,7 +1731,7 @@ std::string MetadataLoader::enhanceClassName(const std::string& original, TypeDe
     return original; // Return as is if already processed
 }
 
-std::string MetadataLoader::enhanceMethodName(const std::string& original, MethodIndex index) {
+std::string_view MetadataLoader::enhanceMethodName(std::string_view original, MethodIndex) {
     // Enhance method names that are valid but could be more descriptive
     if (original.length() > 2 && !isObfuscatedName(original)) {
         // Already a good name, maybe add context
@@ -1044,47 +1742,97 @@ std::string MetadataLoader::enhanceMethodName(const std::string& original, Metho
 
 void MetadataLoader::crossReferenceWithBinary() {
     vlog << "[*] Cross-referencing symbols with binary data...\n";
-    
+    binaryStringHits.clear();
+
     // Search the binary for references to known good strings
     // This can help recover more meaningful names
     
-    std::vector<std::string> knownGoodStrings;
-    
-    // Collect known good strings from our recovered symbols
-    for (const auto& pair : recoveredSymbols) {
-        if (pair.second.length() > 3) { // Only consider reasonably long strings
-            knownGoodStrings.push_back(pair.second);
+    // Collect known good strings from our recovered symbols. Names are
+    // interned, so the views stay valid and equal names share one pattern.
+    AhoCorasick matcher;
+    std::vector<std::string_view> patterns;
+    recoveredSymbols.ForEach([&](uint32_t, std::string_view name) {
+        if (name.length() > 3) { // Only consider reasonably long strings
+            if (matcher.AddPattern(name) == patterns.size()) {
+                patterns.push_back(name);
+            }
         }
+    });
+    if (patterns.empty()) {
+        vlog << "[*] No symbols to cross-reference\n";
+        return;
     }
-    
-    // Search for these strings in the binary and see if they're referenced near
-    // function boundaries, which might indicate function names
-    const char* binData = libBuffer.data();
-    size_t binSize = libBuffer.size();
-    
-    for (const auto& goodStr : knownGoodStrings) {
-        size_t pos = 0;
-        while ((pos = std::string(binData, binSize).find(goodStr, pos)) != std::string::npos) {
-            vlog << "[+] Found reference to '" << goodStr << "' at binary offset 0x" << std::hex << pos << std::dec << "\n";
-            pos += goodStr.length();
+    matcher.Build();
+
+    // Search for all of them in one pass over the library's data ranges and
+    // see if they're referenced near function boundaries, which might
+    // indicate function names. The chunks are scanned in parallel; each one
+    // starts up to the longest pattern length early and keeps the matches
+    // that end inside it, so concatenating them keeps the end-offset order.
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(libBuffer.data());
+    const std::vector<ScanChunk> chunks = SplitIntoChunks(LibraryRanges(false));
+    std::vector<std::vector<std::pair<AhoCorasick::PatternId, uint64_t>>> chunkHits(chunks.size());
+    GetThreadPool().ParallelFor(chunks.size(), 1, [&](size_t first, size_t last, unsigned) {
+        for (size_t c = first; c < last; c++) {
+            const ScanChunk& chunk = chunks[c];
+            const uint64_t scanBegin = chunk.begin - std::min<uint64_t>(matcher.MaxPatternLength(), chunk.begin - chunk.rangeBegin);
+            matcher.Scan(data + scanBegin, chunk.end - scanBegin, [&](AhoCorasick::PatternId id, size_t position) {
+                const uint64_t offset = scanBegin + position;
+                if (offset + patterns[id].size() <= chunk.begin) return;
+                chunkHits[c].emplace_back(id, offset);
+            });
+        }
+    });
+
+    std::vector<bool> found(patterns.size(), false);
+    for (const auto& hits : chunkHits) {
+        for (const auto& hit : hits) {
+            binaryStringHits.push_back({patterns[hit.first], hit.second});
+            found[hit.first] = true;
         }
     }
+
+    size_t symbolsFound = std::count(found.begin(), found.end(), true);
+    vlog << "[+] Found " << binaryStringHits.size() << " binary references to " << symbolsFound << " of "
+         << patterns.size() << " recovered symbols\n";
 }
 
 void MetadataLoader::Process() {
     vlog << "[*] Starting basic metadata processing...\n";
 
     try {
-        // Generate limited output to avoid memory issues with huge datasets
-        vlog << "[*] Generating limited output for stability...\n";
-
-        // Generate a very limited CS dump (first 10 elements only)
-        DumpCSLimited("dump.cs", 10);
+        // Detect and undo obfuscation before any output is generated
+        DetectObfuscation();
+        ApplyDeobfuscation();
+        ReportSignatureMatches();
+        ResolveMethodAddresses();
+        BuildTypeTable();
+
+        // Full dumps; both are streamed to disk, so memory use stays bounded
+        // regardless of the number of types
+        if (csOutputDir.empty()) {
+            DumpCS("dump.cs");
+        } else {
+            DumpCSPerAssembly(csOutputDir);
+        }
+        if (writeScriptJson) {
+            if (jsonLines) {
+                DumpScriptJSON("script.ndjson", true);
+            } else {
+                DumpScriptJSON("script.json");
+            }
+        }
+        if (writeBinary) {
+            DumpBinary("script.il2b");
+        }
+        if (!controlFlowOutput.empty()) {
+            ApplyControlFlowRestoration();
+            DumpControlFlow(controlFlowOutput);
+        }
 
-        // Generate a very limited JSON dump (first 10 elements only)
-        DumpScriptJSONLimited("script.json", 10);
+        GenerateDeobfuscationReport();
 
-        vlog << "[+] Limited metadata processing completed\n";
+        vlog << "[+] Metadata processing completed\n";
 
     } catch (const std::exception& e) {
         vlog << "[-] Exception during processing: " << e.what() << "\n";
@@ -1100,413 +1848,755 @@ void MetadataLoader::GenerateDeobfuscationReport() {
     
     report << "Detection Results:\n";
     report << "- Obfuscation detected: " << (isObfuscated ? "Yes" : "No") << "\n";
-    report << "- Number of strings decrypted: " << decryptedStrings.size() << "\n";
-    report << "- Number of symbols recovered: " << recoveredSymbols.size() << "\n";
+    report << "- Number of strings decrypted: " << decryptedStrings.Count() << "\n";
+    report << "- Number of symbols recovered: " << recoveredSymbols.Count() << "\n";
+    report << "- Number of binary references found: " << binaryStringHits.size() << "\n";
+    if (!controlFlow.IsEmpty()) {
+        report << "- Number of functions unflattened: " << unflattener.FlattenedCount() << " of "
+               << controlFlow.FunctionCount() << " (" << unflattener.EdgeCount() << " edges recovered)\n";
+    }
     
     report << "\nDecrypted Strings Sample:\n";
     int count = 0;
-    for (const auto& pair : decryptedStrings) {
-        if (count++ > 10) break; // Show first 10
-        report << " 0x" << std::hex << pair.first << std::dec << " -> \"" << pair.second << "\"\n";
-    }
+    decryptedStrings.ForEach([&](uint32_t index, StringArena::Id id) {
+        if (count++ > 10) return; // Show first 10
+        report << " 0x" << std::hex << index << std::dec << " -> \"" << nameArena.View(id) << "\"\n";
+    });
     
     report << "\nRecovered Symbols Sample:\n";
     count = 0;
-    for (const auto& pair : recoveredSymbols) {
-        if (count++ > 10) break; // Show first 10
-        report << " 0x" << std::hex << pair.first << std::dec << " -> \"" << pair.second << "\"\n";
+    recoveredSymbols.ForEach([&](uint32_t token, std::string_view name) {
+        if (count++ > 10) return; // Show first 10
+        report << " 0x" << std::hex << token << std::dec << " -> \"" << name << "\"\n";
+    });
+    
+    if (!binaryStringHits.empty()) {
+        report << "\nBinary References Sample:\n";
+        for (size_t i = 0; i < binaryStringHits.size() && i < 10; i++) {
+            report << " 0x" << std::hex << binaryStringHits[i].offset << std::dec << " -> \""
+                   << binaryStringHits[i].symbol << "\"\n";
+        }
     }
     
     report.close();
 }
 
+const Il2CppImageDefinition* MetadataLoader::GetImageDefinition(ImageIndex index) {
+    return metadata.Images().Get(index);
+}
+
 const Il2CppTypeDefinition* MetadataLoader::GetTypeDefinition(TypeDefinitionIndex index) {
-    if (!header || static_cast<uint32_t>(index) >= static_cast<uint32_t>(header->typeDefinitionsCount)) {
-        return nullptr;
-    }
+    return metadata.Types().Get(index);
+}
 
-    // Bounds check for the offset
-    if (static_cast<uint32_t>(header->typeDefinitionsOffset) >= fileBuffer.size()) {
-        return nullptr;
-    }
+const Il2CppMethodDefinition* MetadataLoader::GetMethodDefinition(MethodIndex index) {
+    return metadata.Methods().Get(index);
+}
 
-    const char* typeDefsStart = fileBuffer.data() + header->typeDefinitionsOffset;
-    size_t elementOffset = static_cast<size_t>(header->typeDefinitionsOffset) + static_cast<size_t>(index) * sizeof(Il2CppTypeDefinition);
+const Il2CppFieldDefinition* MetadataLoader::GetFieldDefinition(FieldIndex index) {
+    return metadata.Fields().Get(index);
+}
 
-    // Bounds check for the target location
-    if (elementOffset >= fileBuffer.size() ||
-        elementOffset + sizeof(Il2CppTypeDefinition) > fileBuffer.size()) {
-        return nullptr;
-    }
+const Il2CppPropertyDefinition* MetadataLoader::GetPropertyDefinition(PropertyIndex index) {
+    return metadata.Properties().Get(index);
+}
 
-    return reinterpret_cast<const Il2CppTypeDefinition*>(typeDefsStart + index * sizeof(Il2CppTypeDefinition));
+const Il2CppParameterDefinition* MetadataLoader::GetParameterDefinition(ParameterIndex index) const {
+    return metadata.Parameters().Get(index);
 }
 
-const Il2CppMethodDefinition* MetadataLoader::GetMethodDefinition(MethodIndex index) {
-    if (!header || static_cast<uint32_t>(index) >= static_cast<uint32_t>(header->methodsCount)) {
-        return nullptr;
+std::string_view MetadataLoader::LookupName(StringIndex index) const {
+    std::string_view name;
+    if (FindDecryptedString(index, name) && !name.empty()) {
+        return name;
     }
+    return GetStringView(index);
+}
 
-    // Bounds check for the offset
-    if (static_cast<uint32_t>(header->methodsOffset) >= fileBuffer.size()) {
-        return nullptr;
-    }
+uint32_t MetadataLoader::RenderImageCS(const Il2CppImageDefinition* imageDef, TextBuffer& out) {
+    std::string_view imageName = GetStringView(imageDef->nameIndex);
+    if (!imageName.empty()) {
+        out.Write("// Image: ");
+        out.Write(imageName);
+        out.Write("\n\n");
+    }
+
+    // System.Object, System.ValueType and System.Enum are left out of base lists
+    auto isImplicitBase = [&](TypeDefinitionIndex type) {
+        const Il2CppTypeDefinition* typeDef = GetTypeDefinition(type);
+        if (!typeDef) return false;
+        const std::string_view name = LookupName(typeDef->nameIndex);
+        return LookupName(typeDef->namespaceIndex) == "System" &&
+               (name == "Object" || name == "ValueType" || name == "Enum");
+    };
 
-    const char* methodsStart = fileBuffer.data() + header->methodsOffset;
-    size_t elementOffset = static_cast<size_t>(header->methodsOffset) + static_cast<size_t>(index) * sizeof(Il2CppMethodDefinition);
+    size_t interfaceCount;
+    const TypeIndex* interfaces = MetadataTable<TypeIndex>(fileBuffer, header->interfacesOffset, header->interfacesCount,
+                                                           interfaceCount);
+
+    // Process types in this image
+    const MetadataSpan<Il2CppTypeDefinition>& types = metadata.Types();
+    const MetadataSpan<Il2CppMethodDefinition>& methods = metadata.Methods();
+    const MetadataSpan<Il2CppFieldDefinition>& fields = metadata.Fields();
+    TextBuffer fallbackName;
+    uint32_t typesWritten = 0;
+    for (const Il2CppTypeDefinition& typeDef : types.Slice(imageDef->typeStart, imageDef->typeCount)) {
+        const TypeDefinitionIndex typeIndex = types.IndexOf(typeDef);
+
+        std::string_view typeName = LookupName(typeDef.nameIndex);
+        if (typeName.empty()) continue;
+
+        std::string_view ns = LookupName(typeDef.namespaceIndex);
+        if (!ns.empty()) {
+            out.Write("namespace ");
+            out.Write(ns);
+            out.Write(" {\n");
+        }
 
-    // Bounds check for the target location
-    if (elementOffset >= fileBuffer.size() ||
-        elementOffset + sizeof(Il2CppMethodDefinition) > fileBuffer.size()) {
-        return nullptr;
-    }
+        out.Write("    // Token: 0x");
+        out.WriteHex(0x02000000 | typeIndex, 8);
+        out.Write("\n    public class ");
+        const Il2CppGenericContainer* container = GetGenericContainer(typeDef.genericContainerIndex, typeIndex, false);
+        WriteTypeName(out, typeIndex, container != nullptr);
+        WriteGenericParameters(out, container);
+        // Bases are written from the type table when there is one, which
+        // keeps generic arguments (Base<int>); otherwise by definition
+        const char* separator = " : ";
+        auto writeBase = [&](TypeIndex type, TypeDefinitionIndex resolved) {
+            const std::string_view name = typeNames.Name(type);
+            if (name.empty() && resolved == TypeHierarchy::kNoType) return;
+            out.Write(separator);
+            separator = ", ";
+            if (name.empty()) {
+                WriteTypeName(out, resolved);
+            } else {
+                out.Write(name);
+            }
+        };
+        const TypeDefinitionIndex parent = typeHierarchy.Parent(typeIndex);
+        if (parent == TypeHierarchy::kNoType || !isImplicitBase(parent)) writeBase(typeDef.parentIndex, parent);
+        if (typeNames.IsEmpty()) {
+            for (TypeDefinitionIndex iface : typeHierarchy.Interfaces(typeIndex)) writeBase(TypeTable::kNone, iface);
+        } else if (interfaces && typeDef.interfacesStart < interfaceCount &&
+                   interfaceCount - typeDef.interfacesStart >= typeDef.interfaces_count) {
+            for (uint16_t n = 0; n < typeDef.interfaces_count; n++) {
+                const TypeIndex iface = interfaces[typeDef.interfacesStart + n];
+                writeBase(iface, typeHierarchy.Resolve(iface));
+            }
+        }
+        WriteGenericConstraints(out, container);
+        out.Write(" {\n");
+
+        // Process methods for this type
+        for (const Il2CppMethodDefinition& methodDef : methods.Slice(typeDef.methodStart, typeDef.method_count)) {
+            const MethodIndex methodIdx = methods.IndexOf(methodDef);
+
+            std::string_view methodName = LookupName(methodDef.nameIndex);
+            if (methodName.empty()) {
+                fallbackName.Clear();
+                fallbackName.Write("Method_");
+                fallbackName.WriteDec(methodIdx);
+                methodName = fallbackName.View();
+            }
+            out.Write("        public ");
+            WriteMethodSignature(out, methodIdx, &methodDef, methodName);
+            out.Write("; // Token: 0x");
+            out.WriteHex(methodDef.token);
+            uint64_t rva = GetMethodAddress(methodIdx);
+            uint64_t offset;
+            if (rva && libImage.VaToOffset(libBase + rva, offset)) {
+                out.Write(" RVA: 0x");
+                out.WriteHex(rva);
+                out.Write(" Offset: 0x");
+                out.WriteHex(offset);
+                out.Write(" VA: 0x");
+                out.WriteHex(libBase + rva);
+            }
+            out.Put('\n');
+            if (methodIdx + 1 < methodSpecStart.size()) {
+                for (uint32_t n = methodSpecStart[methodIdx]; n < methodSpecStart[methodIdx + 1]; n++) {
+                    out.Write("        // Instance: ");
+                    WriteMethodSpecName(out, typeTable.MethodSpecs()[methodSpecs[n]]);
+                    out.Put('\n');
+                }
+            }
+        }
 
-    return reinterpret_cast<const Il2CppMethodDefinition*>(methodsStart + index * sizeof(Il2CppMethodDefinition));
-}
+        // Process fields for this type
+        for (const Il2CppFieldDefinition& fieldDef : fields.Slice(typeDef.fieldStart, typeDef.field_count)) {
+            const FieldIndex fieldIdx = fields.IndexOf(fieldDef);
 
-const Il2CppFieldDefinition* MetadataLoader::GetFieldDefinition(FieldIndex index) {
-    if (!header || static_cast<uint32_t>(index) >= static_cast<uint32_t>(header->fieldsCount)) {
-        return nullptr;
+            std::string_view fieldName = LookupName(fieldDef.nameIndex);
+            out.Write("        public ");
+            if (typeNames.IsEmpty()) {
+                out.Write("var");
+            } else {
+                WriteTypeReference(out, fieldDef.typeIndex, false);
+            }
+            out.Put(' ');
+            if (fieldName.empty()) {
+                out.Write("Field_");
+                out.WriteDec(fieldIdx);
+            } else {
+                out.Write(fieldName);
+            }
+            out.Write("; // Token: 0x");
+            out.WriteHex(fieldDef.token);
+            out.Put('\n');
+        }
+
+        out.Write("    }\n");
+        if (!ns.empty()) out.Write("}\n");
+        out.Put('\n');
+        typesWritten++;
     }
+    return typesWritten;
+}
 
-    // Bounds check for the offset
-    if (static_cast<uint32_t>(header->fieldsOffset) >= fileBuffer.size()) {
-        return nullptr;
+uint32_t MetadataLoader::RenderImagesCS(const std::function<void(ImageIndex, const TextBuffer&)>& sink) {
+    // Images are independent, so a window of them is rendered in parallel into
+    // per-image buffers which are then handed to the sink in image order. The
+    // window bounds memory use to a few images per worker.
+    ThreadPool& pool = GetThreadPool();
+    const uint32_t imageCount = header->imagesCount > 0 ? static_cast<uint32_t>(header->imagesCount) : 0;
+    const uint32_t window = pool.GetThreadCount() * 4;
+    std::vector<TextBuffer> buffers(std::min(window, imageCount));
+    std::vector<uint32_t> typeCounts(buffers.size());
+    uint32_t typesWritten = 0;
+
+    for (uint32_t first = 0; first < imageCount; first += window) {
+        uint32_t count = std::min(window, imageCount - first);
+        pool.ParallelFor(count, 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++) {
+                TextBuffer& buffer = buffers[i];
+                buffer.Clear();
+                const Il2CppImageDefinition* imageDef = GetImageDefinition(first + static_cast<uint32_t>(i));
+                typeCounts[i] = imageDef ? RenderImageCS(imageDef, buffer) : 0;
+            }
+        });
+        for (uint32_t i = 0; i < count; i++) {
+            sink(first + i, buffers[i]);
+            typesWritten += typeCounts[i];
+            ReportProgress("dump.cs", first + i + 1, imageCount);
+        }
     }
+    return typesWritten;
+}
 
-    const char* fieldsStart = fileBuffer.data() + header->fieldsOffset;
-    size_t elementOffset = static_cast<size_t>(header->fieldsOffset) + static_cast<size_t>(index) * sizeof(Il2CppFieldDefinition);
+static void WriteCSHeader(BufferedWriter& out) {
+    out.Write("// Generated by Enhanced IL2CPP Dumper\n");
+    out.Write("// Compatible with Perfare's Il2CppDumper approach\n\n");
+}
 
-    // Bounds check for the target location
-    if (elementOffset >= fileBuffer.size() ||
-        elementOffset + sizeof(Il2CppFieldDefinition) > fileBuffer.size()) {
-        return nullptr;
+void MetadataLoader::DumpCS(const std::string& outputPath) {
+    vlog << "[*] Generating C# output...\n";
+    BufferedWriter out;
+    if (!out.Open(outputPath)) {
+        vlog << "[-] Failed to open " << outputPath << " for writing\n";
+        return;
     }
 
-    return reinterpret_cast<const Il2CppFieldDefinition*>(fieldsStart + index * sizeof(Il2CppFieldDefinition));
-}
+    WriteCSHeader(out);
+    uint32_t typesWritten = RenderImagesCS([&](ImageIndex, const TextBuffer& image) {
+        out.Write(image.View());
+    });
 
-const Il2CppPropertyDefinition* MetadataLoader::GetPropertyDefinition(PropertyIndex index) {
-    if (!header || static_cast<uint32_t>(index) >= static_cast<uint32_t>(header->propertiesCount)) {
-        return nullptr;
+    if (!out.Close()) {
+        vlog << "[-] Error while writing " << outputPath << "\n";
+        return;
     }
+    vlog << "[+] C# dump completed: " << header->imagesCount << " images, " << typesWritten << " types, "
+         << out.BytesWritten() << " bytes\n";
+}
 
-    // Bounds check for the offset
-    if (static_cast<uint32_t>(header->propertiesOffset) >= fileBuffer.size()) {
-        return nullptr;
+void MetadataLoader::DumpCSPerAssembly(const std::string& outputDir) {
+    vlog << "[*] Generating C# output per assembly in " << outputDir << "...\n";
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir, ec);
+    if (ec) {
+        vlog << "[-] Failed to create " << outputDir << ": " << ec.message() << "\n";
+        return;
     }
 
-    const char* propsStart = fileBuffer.data() + header->propertiesOffset;
-    size_t elementOffset = static_cast<size_t>(header->propertiesOffset) + static_cast<size_t>(index) * sizeof(Il2CppPropertyDefinition);
+    std::set<std::string> usedNames;
+    uint32_t filesWritten = 0;
+    uint32_t typesWritten = RenderImagesCS([&](ImageIndex imgIdx, const TextBuffer& image) {
+        // "Assembly-CSharp.dll" -> "Assembly-CSharp.cs"; keep file names unique
+        // and free of path separators
+        std::string fileName;
+        const Il2CppImageDefinition* imageDef = GetImageDefinition(imgIdx);
+        if (imageDef) {
+            fileName = std::string(GetStringView(imageDef->nameIndex));
+        }
+        if (fileName.size() > 4 && fileName.compare(fileName.size() - 4, 4, ".dll") == 0) {
+            fileName.resize(fileName.size() - 4);
+        }
+        for (char& c : fileName) {
+            if (c == '/' || c == '\\' || c == ':' || static_cast<unsigned char>(c) < 0x20) c = '_';
+        }
+        if (fileName.empty() || fileName == "." || fileName == "..") {
+            fileName = "Image_" + std::to_string(imgIdx);
+        }
+        if (!usedNames.insert(fileName).second) {
+            fileName += "_" + std::to_string(imgIdx);
+            usedNames.insert(fileName);
+        }
 
-    // Bounds check for the target location
-    if (elementOffset >= fileBuffer.size() ||
-        elementOffset + sizeof(Il2CppPropertyDefinition) > fileBuffer.size()) {
-        return nullptr;
-    }
+        std::string path = (std::filesystem::path(outputDir) / (fileName + ".cs")).string();
+        BufferedWriter out(image.Size() + 1024);
+        if (!out.Open(path)) {
+            vlog << "[-] Failed to open " << path << " for writing\n";
+            return;
+        }
+        WriteCSHeader(out);
+        out.Write(image.View());
+        if (!out.Close()) {
+            vlog << "[-] Error while writing " << path << "\n";
+            return;
+        }
+        filesWritten++;
+    });
 
-    return reinterpret_cast<const Il2CppPropertyDefinition*>(propsStart + index * sizeof(Il2CppPropertyDefinition));
+    vlog << "[+] C# dump completed: " << filesWritten << " assembly files, " << typesWritten << " types\n";
 }
 
-void MetadataLoader::DumpCS(const std::string& outputPath) {
-    vlog << "[*] Generating C# output...\n";
-    std::ofstream out(outputPath);
-    
-    out << "// Generated by Enhanced IL2CPP Dumper\n";
-    out << "// Compatible with Perfare's Il2CppDumper approach\n\n";
-
-    // Process each image (assembly)
-    const char* imagesStart = fileBuffer.data() + header->imagesOffset;
-    for (ImageIndex imgIdx = 0; imgIdx < header->imagesCount; imgIdx++) {
-        const Il2CppImageDefinition* imageDef = reinterpret_cast<const Il2CppImageDefinition*>(
-            imagesStart + imgIdx * sizeof(Il2CppImageDefinition));
-        
-        std::string imageName = GetStringFromIndex(imageDef->nameIndex);
-        if (!imageName.empty()) {
-            out << "// Image: " << imageName << "\n\n";
+void MetadataLoader::DumpScriptJSON(const std::string& outputPath, bool jsonLines) {
+    BufferedWriter out;
+    if (!out.Open(outputPath)) {
+        vlog << "[-] Failed to open " << outputPath << " for writing\n";
+        return;
+    }
+
+    // In NDJSON mode every method and field is a self-contained record on its
+    // own line, tagged with the section it would belong to in script.json
+    JsonWriter json(out, !jsonLines);
+    if (!jsonLines) {
+        json.BeginObject();
+        json.Key("ScriptMethod");
+        json.BeginArray();
+    }
+
+    TextBuffer signature;
+    uint32_t methodsWritten = 0;
+    const MetadataColumns::MethodColumns& methodColumns = columns.Methods();
+    for (MethodIndex i = 0; i < methodColumns.Count(); i++) {
+        std::string_view name = LookupName(methodColumns.nameIndex[i]);
+        std::string fallback;
+        if (name.empty()) {
+            fallback = "method_" + std::to_string(i);
+            name = fallback;
         }
-        
-        // Process types in this image
-        for (uint32_t i = 0; i < imageDef->typeCount; i++) {
-            TypeDefinitionIndex typeIndex = imageDef->typeStart + i;
-            if (typeIndex >= header->typeDefinitionsCount) continue;
-            
-            const Il2CppTypeDefinition* typeDef = GetTypeDefinition(typeIndex);
-            if (!typeDef) continue;
-            
-            std::string typeName = GetDecryptedString(typeDef->nameIndex);
-            if (typeName.empty()) typeName = GetStringFromIndex(typeDef->nameIndex);
-            if (typeName.empty()) continue;
-
-            std::string ns = GetDecryptedString(typeDef->namespaceIndex);
-            if (ns.empty()) ns = GetStringFromIndex(typeDef->namespaceIndex);
-            if (!ns.empty()) out << "namespace " << ns << " {\n";
-
-            out << "    // Token: 0x" << std::hex << std::setfill('0') << std::setw(8) 
-                << (0x02000000 | typeIndex) << std::dec << "\n";
-            out << "    public class " << typeName << " {\n";
-
-            // Process methods for this type
-            for (uint16_t m = 0; m < typeDef->method_count; m++) {
-                MethodIndex methodIdx = typeDef->methodStart + m;
-                if (methodIdx >= header->methodsCount) continue;
-                
-                const Il2CppMethodDefinition* methodDef = GetMethodDefinition(methodIdx);
-                if (!methodDef) continue;
-                
-                std::string methodName = GetDecryptedString(methodDef->nameIndex);
-                if (methodName.empty()) methodName = GetStringFromIndex(methodDef->nameIndex);
-                if (methodName.empty()) methodName = "Method_" + std::to_string(methodIdx);
-
-                out << "        public void " << methodName << "(); // Token: 0x" 
-                    << std::hex << methodDef->token << std::dec << "\n";
-            }
-            
-            // Process fields for this type
-            for (uint16_t f = 0; f < typeDef->field_count; f++) {
-                FieldIndex fieldIdx = typeDef->fieldStart + f;
-                if (fieldIdx >= header->fieldsCount) continue;
-                
-                const Il2CppFieldDefinition* fieldDef = GetFieldDefinition(fieldIdx);
-                if (!fieldDef) continue;
-                
-                std::string fieldName = GetDecryptedString(fieldDef->nameIndex);
-                if (fieldName.empty()) fieldName = GetStringFromIndex(fieldDef->nameIndex);
-                if (fieldName.empty()) fieldName = "Field_" + std::to_string(fieldIdx);
-
-                out << "        public var " << fieldName << "; // Token: 0x" 
-                    << std::hex << fieldDef->token << std::dec << "\n";
-            }
-            
-            out << "    }\n";
-            if (!ns.empty()) out << "}\n";
-            out << "\n";
+        signature.Clear();
+        WriteMethodSignature(signature, i, GetMethodDefinition(i), name);
+
+        json.BeginObject();
+        if (jsonLines) json.Member("Type", "ScriptMethod");
+        json.Member("Address", GetMethodAddress(i));
+        json.Member("Name", name);
+        json.Member("Signature", signature.View());
+        json.Member("Token", uint64_t(methodColumns.token[i]));
+        json.EndObject();
+        if (jsonLines) json.EndRecord();
+        methodsWritten++;
+    }
+
+    if (!jsonLines) {
+        json.EndArray();
+        json.Key("ScriptField");
+        json.BeginArray();
+    }
+
+    uint32_t fieldsWritten = 0;
+    const MetadataSpan<Il2CppFieldDefinition>& fields = metadata.Fields();
+    for (const Il2CppFieldDefinition& fieldDef : fields) {
+        std::string_view name = LookupName(fieldDef.nameIndex);
+        std::string fallback;
+        if (name.empty()) {
+            fallback = "field_" + std::to_string(fields.IndexOf(fieldDef));
+            name = fallback;
         }
-    }
-    
-    vlog << "[+] C# dump completed\n";
-}
 
-void MetadataLoader::DumpScriptJSON(const std::string& outputPath) {
-    std::ofstream out(outputPath);
-    out << "{\n  \"ScriptMethod\": [\n";
-    
-    bool first = true;
-    for (MethodIndex i = 0; i < header->methodsCount; i++) {
-        const Il2CppMethodDefinition* methodDef = GetMethodDefinition(i);
-        if (!methodDef) continue;
-        
-        std::string name = GetDecryptedString(methodDef->nameIndex);
-        if (name.empty()) name = GetStringFromIndex(methodDef->nameIndex);
-        if (name.empty()) name = "method_" + std::to_string(i);
-        
-        if (!first) out << ",";
-        first = false;
-        
-        out << "\n    {\n      \"Address\": 0,\n      \"Name\": \"" << name << "\",\n      \"Signature\": \"void " << name << "()\",\n      \"Token\": " << std::hex << "0x" << methodDef->token << std::dec << "\n    }";
+        json.BeginObject();
+        if (jsonLines) json.Member("Type", "ScriptField");
+        json.Member("Name", name);
+        json.Member("Token", uint64_t(fieldDef.token));
+        json.EndObject();
+        if (jsonLines) json.EndRecord();
+        fieldsWritten++;
     }
-    
-    out << "\n  ],\n  \"ScriptField\": [\n";
-    
-    first = true;
-    for (FieldIndex i = 0; i < header->fieldsCount; i++) {
-        const Il2CppFieldDefinition* fieldDef = GetFieldDefinition(i);
-        if (!fieldDef) continue;
-        
-        std::string name = GetDecryptedString(fieldDef->nameIndex);
-        if (name.empty()) name = GetStringFromIndex(fieldDef->nameIndex);
-        if (name.empty()) name = "field_" + std::to_string(i);
-        
-        if (!first) out << ",";
-        first = false;
-        
-        out << "\n    {\n      \"Name\": \"" << name << "\",\n      \"Token\": " << std::hex << "0x" << fieldDef->token << std::dec << "\n    }";
+
+    if (!jsonLines) {
+        json.EndArray();
+        json.EndObject();
+        json.EndRecord();
     }
-    
-    out << "\n  ]\n}";
-}
 
-void MetadataLoader::AnalyzeBinaryForSymbols() {
-    // Analyze the library binary to recover additional symbols
-    if (libBuffer.empty()) {
-        vlog << "[*] No library loaded for binary analysis\n";
+    if (!out.Close()) {
+        vlog << "[-] Error while writing " << outputPath << "\n";
         return;
     }
-    
-    vlog << "[*] Analyzing binary for additional symbols...\n";
-    
-    // Search for common patterns in the binary that might reveal class/method names
-    std::string pattern = "System.";
-    const char* data = libBuffer.data();
-    size_t dataSize = libBuffer.size();
-    
-    for (size_t i = 0; i < dataSize - pattern.length(); i++) {
-        if (memcmp(data + i, pattern.c_str(), pattern.length()) == 0) {
-            // Found a potential symbol, extract it
-            size_t end = i;
-            while (end < dataSize && 
-                   (isalnum(data[end]) || data[end] == '.' || data[end] == '_' || data[end] == '<' || data[end] == '>' || data[end] == '`')) {
-                end++;
-            }
-            
-            if (end > i) {
-                std::string symbol(data + i, end - i);
-                vlog << "[+] Found potential symbol in binary: " << symbol << "\n";
-            }
-        }
-    }
+    vlog << "[+] Script JSON completed: " << methodsWritten << " methods, " << fieldsWritten << " fields, "
+         << out.BytesWritten() << " bytes\n";
 }
 
-void MetadataLoader::DumpStrings(const std::string& p) {}
-void MetadataLoader::DumpClasses(const std::string& p) {}
+namespace {
 
-void MetadataLoader::DumpCSLimited(const std::string& outputPath, int maxElements) {
-    std::ofstream out(outputPath);
-    out << "// IL2CPP Metadata Dump\n";
-    out << "// Generated by Enhanced IL2CPP Dumper\n";
-    out << "// File offset information included\n";
-    out << "// Unity Version: " << header->version << " | Sanity: 0x" << std::hex << header->sanity << std::dec << "\n";
-    out << "// Total Types: " << header->typeDefinitionsCount << " | Methods: " << header->methodsCount << "\n\n";
-
-    out << "#pragma once\n\n";
-
-    // Limit the number of images we process
-    int imageCount = std::min(static_cast<int>(header->imagesCount), maxElements);
-    for (ImageIndex imgIdx = 0; imgIdx < imageCount; imgIdx++) {
-        // Calculate the offset for this image definition
-        size_t imageOffset = header->imagesOffset + imgIdx * sizeof(Il2CppImageDefinition);
-        const Il2CppImageDefinition* imageDef = reinterpret_cast<const Il2CppImageDefinition*>(
-            fileBuffer.data() + imageOffset);
-
-        const char* imageName = GetStringFromIndex(imageDef->nameIndex);
-        if (!imageName) imageName = "UnknownImage";
-
-        out << "// Image: " << imageName << " | Index: " << imgIdx << " | Offset: 0x" << std::hex << imageOffset << std::dec << "\n";
-        out << "//   Type Range: [" << imageDef->typeStart << ", " << (imageDef->typeStart + imageDef->typeCount) << "] | Count: " << imageDef->typeCount << "\n";
-
-        // Limit the number of types we process per image
-        int typeCount = std::min(static_cast<int>(imageDef->typeCount), maxElements);
-        for (uint32_t t = 0; t < typeCount; t++) {
-            TypeDefinitionIndex typeIndex = imageDef->typeStart + t;
-            if (typeIndex >= header->typeDefinitionsCount) continue;
-
-            // Calculate the offset for this type definition
-            size_t typeOffset = header->typeDefinitionsOffset + typeIndex * sizeof(Il2CppTypeDefinition);
-            const Il2CppTypeDefinition* typeDef = GetTypeDefinition(typeIndex);
-            if (!typeDef) continue;
-
-            const char* typeName = GetStringFromIndex(typeDef->nameIndex);
-            const char* ns = GetStringFromIndex(typeDef->namespaceIndex);
-
-            // Use index-based naming if string access fails
-            std::string displayTypeName = typeName ? typeName : "Type_" + std::to_string(typeIndex);
-            std::string displayNamespace = ns ? ns : "Namespace_" + std::to_string(typeDef->namespaceIndex);
-
-            out << "// Type: " << displayNamespace << "." << displayTypeName
-                << " | Index: " << typeIndex
-                << " | TypeDef Offset: 0x" << std::hex << typeOffset << std::dec
-                << " | Flags: 0x" << std::hex << typeDef->flags << std::dec
-                << " | Methods: " << typeDef->method_count << "\n";
-
-            // Process methods for this type (limited)
-            int methodCount = std::min(static_cast<int>(typeDef->method_count), maxElements/100);
-            for (uint16_t m = 0; m < methodCount; m++) {
-                MethodIndex methodIdx = typeDef->methodStart + m;
-                if (methodIdx >= header->methodsCount) continue;
-
-                // Calculate the offset for this method definition
-                size_t methodOffset = header->methodsOffset + methodIdx * sizeof(Il2CppMethodDefinition);
-                const Il2CppMethodDefinition* methodDef = GetMethodDefinition(methodIdx);
-                if (!methodDef) continue;
-
-                const char* methodName = GetStringFromIndex(methodDef->nameIndex);
-
-                // Use index-based naming if string access fails
-                std::string displayMethodName = methodName ? methodName : "Method_" + std::to_string(methodIdx);
-
-                out << "//   Method: " << displayMethodName
-                    << " | Index: " << methodIdx
-                    << " | MethodDef Offset: 0x" << std::hex << methodOffset << std::dec
-                    << " | Token: 0x" << std::hex << methodDef->token << std::dec
-                    << " | Flags: 0x" << std::hex << methodDef->flags << std::dec << "\n";
-            }
+// Deduplicating builder for the string blob of the binary export. Keys are
+// views into loader-owned storage (the mapped file or the name arena).
+class BinaryStringBlob {
+public:
+    BinaryStringBlob() { blob.push_back('\0'); }
 
-            out << "\n";
-        }
-        out << "\n";
+    uint32_t Add(std::string_view value) {
+        if (value.empty()) return 0;
+        auto it = offsets.find(value);
+        if (it != offsets.end()) return it->second;
+        uint32_t offset = static_cast<uint32_t>(blob.size());
+        blob.append(value.data(), value.size());
+        blob.push_back('\0');
+        offsets.emplace(value, offset);
+        return offset;
     }
 
-    out.close();
-}
+    const std::string& Data() const { return blob; }
 
-void MetadataLoader::DumpScriptJSONLimited(const std::string& outputPath, int maxElements) {
-    std::ofstream out(outputPath);
-    out << "{\n";
-    out << "  \"metadata\": {\n";
-    out << "    \"version\": " << header->version << ",\n";
-    out << "    \"sanity\": " << header->sanity << ",\n";
-    out << "    \"stringCount\": " << header->stringCount << ",\n";
-    out << "    \"typeDefinitionsCount\": " << header->typeDefinitionsCount << ",\n";
-    out << "    \"methodsCount\": " << header->methodsCount << ",\n";
-    out << "    \"imagesOffset\": " << header->imagesOffset << ",\n";
-    out << "    \"typeDefinitionsOffset\": " << header->typeDefinitionsOffset << ",\n";
-    out << "    \"methodsOffset\": " << header->methodsOffset << "\n";
-    out << "  },\n";
+private:
+    std::string blob;
+    std::unordered_map<std::string_view, uint32_t> offsets;
+};
 
-    out << "  \"types\": [\n";
+void PadTo8(BufferedWriter& out) {
+    static const char zeros[8] = {};
+    out.WriteRaw(zeros, (8 - out.BytesWritten() % 8) % 8);
+}
 
-    // Limit the number of types we process
-    int typeCount = std::min(static_cast<int>(header->typeDefinitionsCount), maxElements);
-    for (TypeDefinitionIndex i = 0; i < typeCount; i++) {
-        const Il2CppTypeDefinition* typeDef = GetTypeDefinition(i);
-        if (!typeDef) continue;
+// Zeroed records for the elements of a table that lie outside the file
+template <typename Record>
+void WriteZeroedRecords(BufferedWriter& out, size_t count) {
+    const Record record = {};
+    for (size_t i = 0; i < count; i++) out.WriteRaw(&record, sizeof(record));
+}
 
-        // Calculate the offset for this type definition
-        size_t typeOffset = header->typeDefinitionsOffset + i * sizeof(Il2CppTypeDefinition);
+} // namespace
 
-        const char* typeName = GetStringFromIndex(typeDef->nameIndex);
-        const char* ns = GetStringFromIndex(typeDef->namespaceIndex);
+void MetadataLoader::DumpBinary(const std::string& outputPath) {
+    BufferedWriter out;
+    if (!out.Open(outputPath)) {
+        vlog << "[-] Failed to open " << outputPath << " for writing\n";
+        return;
+    }
 
-        if (i > 0) out << ",\n";
-        out << "    {\n";
-        out << "      \"index\": " << i << ",\n";
-        out << "      \"name\": \"" << (typeName ? typeName : "UnknownType") << "\",\n";
-        out << "      \"namespace\": \"" << (ns ? ns : "") << "\",\n";
-        out << "      \"flags\": " << typeDef->flags << ",\n";
-        out << "      \"methodCount\": " << typeDef->method_count << ",\n";
-        out << "      \"offset\": " << typeOffset << ",\n";
-        out << "      \"offsetHex\": \"0x" << std::hex << typeOffset << std::dec << "\"\n";
-        out << "    }";
+    BinaryExportHeader fileHeader = {};
+    memcpy(fileHeader.magic, kBinaryExportMagic, sizeof(fileHeader.magic));
+    fileHeader.version = kBinaryExportVersion;
+    fileHeader.headerSize = sizeof(BinaryExportHeader);
+    fileHeader.metadataVersion = header->version;
+    fileHeader.imageCount = header->imagesCount > 0 ? static_cast<uint32_t>(header->imagesCount) : 0;
+    fileHeader.typeCount = header->typeDefinitionsCount > 0 ? static_cast<uint32_t>(header->typeDefinitionsCount) : 0;
+    fileHeader.methodCount = header->methodsCount > 0 ? static_cast<uint32_t>(header->methodsCount) : 0;
+    fileHeader.fieldCount = header->fieldsCount > 0 ? static_cast<uint32_t>(header->fieldsCount) : 0;
+    fileHeader.propertyCount = header->propertiesCount > 0 ? static_cast<uint32_t>(header->propertiesCount) : 0;
+    fileHeader.typeRecordSize = sizeof(BinaryTypeRecord);
+    fileHeader.methodRecordSize = sizeof(BinaryMethodRecord);
+    fileHeader.fieldRecordSize = sizeof(BinaryFieldRecord);
+    fileHeader.propertyRecordSize = sizeof(BinaryPropertyRecord);
+    // Placeholder; offsets and the blob size are filled in once known
+    out.WriteRaw(&fileHeader, sizeof(fileHeader));
+
+    BinaryStringBlob strings;
+
+    const MetadataSpan<Il2CppImageDefinition>& images = metadata.Images();
+    const MetadataSpan<Il2CppTypeDefinition>& types = metadata.Types();
+    const MetadataSpan<Il2CppMethodDefinition>& methods = metadata.Methods();
+    const MetadataSpan<Il2CppFieldDefinition>& fields = metadata.Fields();
+    const MetadataSpan<Il2CppPropertyDefinition>& properties = metadata.Properties();
+
+    // Owning image of every type, from the images' type ranges
+    std::vector<uint32_t> typeImage(fileHeader.typeCount, kBinaryNoIndex);
+    for (const Il2CppImageDefinition& imageDef : images) {
+        for (const Il2CppTypeDefinition& typeDef : types.Slice(imageDef.typeStart, imageDef.typeCount)) {
+            typeImage[types.IndexOf(typeDef)] = images.IndexOf(imageDef);
+        }
     }
 
-    out << "\n  ],\n";
+    // Declaring type of every field, from the types' field ranges
+    std::vector<uint32_t> fieldType(fileHeader.fieldCount, kBinaryNoIndex);
+    for (const Il2CppTypeDefinition& typeDef : types) {
+        for (const Il2CppFieldDefinition& fieldDef : fields.Slice(typeDef.fieldStart, typeDef.field_count)) {
+            fieldType[fields.IndexOf(fieldDef)] = types.IndexOf(typeDef);
+        }
+    }
 
-    out << "  \"methods\": [\n";
+    // Every table gets exactly count records so that record i is element i;
+    // elements outside the file are written as zeroed records
+    PadTo8(out);
+    fileHeader.typesOffset = out.BytesWritten();
+    for (TypeDefinitionIndex i = 0; i < types.size(); i++) {
+        const Il2CppTypeDefinition& typeDef = types[i];
+        BinaryTypeRecord record = {};
+        record.token = typeDef.token;
+        record.name = strings.Add(LookupName(typeDef.nameIndex));
+        record.namespaceName = strings.Add(LookupName(typeDef.namespaceIndex));
+        record.flags = typeDef.flags;
+        record.imageIndex = typeImage[i];
+        record.parentIndex = typeDef.parentIndex;
+        record.declaringTypeIndex = typeDef.declaringTypeIndex;
+        record.methodStart = typeDef.methodStart;
+        record.fieldStart = typeDef.fieldStart;
+        record.propertyStart = typeDef.propertyStart;
+        record.methodCount = typeDef.method_count;
+        record.fieldCount = typeDef.field_count;
+        record.propertyCount = typeDef.property_count;
+        out.WriteRaw(&record, sizeof(record));
+    }
+    WriteZeroedRecords<BinaryTypeRecord>(out, fileHeader.typeCount - types.size());
+
+    PadTo8(out);
+    fileHeader.methodsOffset = out.BytesWritten();
+    for (MethodIndex i = 0; i < methods.size(); i++) {
+        const Il2CppMethodDefinition& methodDef = methods[i];
+        BinaryMethodRecord record = {};
+        record.address = GetMethodAddress(i);
+        record.token = methodDef.token;
+        record.name = strings.Add(LookupName(methodDef.nameIndex));
+        record.declaringType = methodDef.declaringType;
+        record.returnType = methodDef.returnType;
+        record.flags = methodDef.flags;
+        record.iflags = methodDef.iflags;
+        record.slot = methodDef.slot;
+        record.parameterCount = methodDef.parameterCount;
+        out.WriteRaw(&record, sizeof(record));
+    }
+    WriteZeroedRecords<BinaryMethodRecord>(out, fileHeader.methodCount - methods.size());
+
+    PadTo8(out);
+    fileHeader.fieldsOffset = out.BytesWritten();
+    for (FieldIndex i = 0; i < fields.size(); i++) {
+        const Il2CppFieldDefinition& fieldDef = fields[i];
+        BinaryFieldRecord record = {};
+        record.token = fieldDef.token;
+        record.name = strings.Add(LookupName(fieldDef.nameIndex));
+        record.declaringType = fieldType[i];
+        record.typeIndex = fieldDef.typeIndex;
+        out.WriteRaw(&record, sizeof(record));
+    }
+    WriteZeroedRecords<BinaryFieldRecord>(out, fileHeader.fieldCount - fields.size());
+
+    PadTo8(out);
+    fileHeader.propertiesOffset = out.BytesWritten();
+    for (const Il2CppPropertyDefinition& propDef : properties) {
+        BinaryPropertyRecord record = {};
+        record.token = propDef.token;
+        record.name = strings.Add(LookupName(propDef.nameIndex));
+        record.getMethod = propDef.get;
+        record.setMethod = propDef.set;
+        record.attrs = propDef.attrs;
+        out.WriteRaw(&record, sizeof(record));
+    }
+    WriteZeroedRecords<BinaryPropertyRecord>(out, fileHeader.propertyCount - properties.size());
+
+    PadTo8(out);
+    fileHeader.stringsOffset = out.BytesWritten();
+    fileHeader.stringsSize = strings.Data().size();
+    out.Write(strings.Data());
+
+    out.Rewrite(0, &fileHeader, sizeof(fileHeader));
+    if (!out.Close()) {
+        vlog << "[-] Error while writing " << outputPath << "\n";
+        return;
+    }
+    vlog << "[+] Binary export completed: " << fileHeader.typeCount << " types, " << fileHeader.methodCount
+         << " methods, " << fileHeader.fieldCount << " fields, " << fileHeader.propertyCount << " properties, "
+         << out.BytesWritten() << " bytes\n";
+}
 
-    // Limit the number of methods we process
-    int methodCount = std::min(static_cast<int>(header->methodsCount), maxElements);
-    for (MethodIndex i = 0; i < methodCount; i++) {
-        const Il2CppMethodDefinition* methodDef = GetMethodDefinition(i);
-        if (!methodDef) continue;
+void MetadataLoader::DumpControlFlow(const std::string& outputPath) {
+    if (controlFlow.IsEmpty()) {
+        vlog << "[!] No control flow graph to write to " << outputPath << "\n";
+        return;
+    }
+    BufferedWriter out;
+    if (!out.Open(outputPath)) {
+        vlog << "[-] Failed to open " << outputPath << " for writing\n";
+        return;
+    }
 
-        // Calculate the offset for this method definition
-        size_t methodOffset = header->methodsOffset + i * sizeof(Il2CppMethodDefinition);
+    // Each function is labeled with the first method that starts there
+    std::vector<std::pair<uint64_t, MethodIndex>> methodsByAddress;
+    for (MethodIndex i = 0; i < methodAddresses.size(); i++) {
+        if (methodAddresses[i]) methodsByAddress.emplace_back(libBase + methodAddresses[i], i);
+    }
+    std::sort(methodsByAddress.begin(), methodsByAddress.end());
 
-        const char* methodName = GetStringFromIndex(methodDef->nameIndex);
+    const bool dot = outputPath.size() >= 4 && outputPath.compare(outputPath.size() - 4, 4, ".dot") == 0;
+    const ElfImage::Machine machine = controlFlow.GetMachine();
+    JsonWriter json(out, false);
+    std::string name;
+    struct Successor {
+        uint32_t block;
+        bool recovered;
+        Unflattener::EdgeKind kind;
+    };
+    std::vector<Successor> successors;
+    for (size_t f = 0; f < controlFlow.FunctionCount(); f++) {
+        const ControlFlowGraph::Function& function = controlFlow.GetFunction(f);
+        const ControlFlowGraph::Block* blocks = controlFlow.GetBlocks(function);
+        const Unflattener::Result* result = unflattener.Find(f);
+        const uint32_t* dispatcher = result ? unflattener.GetDispatcherBlocks(*result) : nullptr;
+        const Unflattener::Edge* edges = result ? unflattener.GetEdges(*result) : nullptr;
+        auto isDispatcher = [&](uint32_t block) {
+            return result && std::binary_search(dispatcher, dispatcher + result->dispatcherBlockCount, block);
+        };
+
+        uint32_t token = 0;
+        name.clear();
+        auto method = std::lower_bound(methodsByAddress.begin(), methodsByAddress.end(), std::make_pair(function.address, MethodIndex(0)));
+        if (method != methodsByAddress.end() && method->first == function.address) {
+            if (const Il2CppMethodDefinition* methodDef = GetMethodDefinition(method->second)) {
+                token = methodDef->token;
+                if (const Il2CppTypeDefinition* typeDef = GetTypeDefinition(methodDef->declaringType)) {
+                    name.append(LookupName(typeDef->nameIndex));
+                    name.push_back('.');
+                }
+                name.append(LookupName(methodDef->nameIndex));
+            }
+        }
+        const uint64_t rva = function.address - libBase;
+
+        // Successors of a block with edges into the dispatcher replaced by the
+        // recovered ones; unresolved edges keep pointing at the dispatcher
+        uint32_t edgeCursor = 0;
+        auto collectSuccessors = [&](uint32_t b) {
+            successors.clear();
+            for (uint8_t slot = 0; slot < 2; slot++) {
+                const uint32_t successor = blocks[b].successors[slot];
+                if (successor == ControlFlowGraph::kNoBlock) continue;
+                bool replaced = false;
+                if (result && !isDispatcher(b)) {
+                    while (edgeCursor < result->edgeCount &&
+                           (edges[edgeCursor].from < b || (edges[edgeCursor].from == b && edges[edgeCursor].slot < slot))) {
+                        edgeCursor++;
+                    }
+                    for (; edgeCursor < result->edgeCount && edges[edgeCursor].from == b && edges[edgeCursor].slot == slot; edgeCursor++) {
+                        successors.push_back({edges[edgeCursor].to, true, edges[edgeCursor].kind});
+                        replaced = true;
+                    }
+                }
+                if (!replaced) successors.push_back({successor, false, Unflattener::EdgeKind::Direct});
+            }
+        };
+
+        if (dot) {
+            // One graph per function; dispatcher blocks are left out so the
+            // recovered edges show the original structure
+            out.Write("digraph \"0x");
+            out.WriteHex(rva);
+            out.Write("\" {\n  label=\"");
+            JsonWriter::Escape(out, name);
+            out.Write("\";\n  node [shape=box, fontname=monospace];\n");
+            for (uint32_t b = 0; b < function.blockCount; b++) {
+                if (isDispatcher(b)) continue;
+                out.Write("  b");
+                out.WriteDec(b);
+                out.Write(" [label=\"0x");
+                out.WriteHex(rva + blocks[b].offset);
+                out.Write("\\n");
+                out.WriteDec(uint32_t(blocks[b].instructionCount));
+                out.Write(blocks[b].instructionCount == 1 ? " instruction\"];\n" : " instructions\"];\n");
+            }
+            for (uint32_t b = 0; b < function.blockCount; b++) {
+                if (isDispatcher(b)) continue;
+                collectSuccessors(b);
+                for (const Successor& successor : successors) {
+                    if (isDispatcher(successor.block)) continue;
+                    out.Write("  b");
+                    out.WriteDec(b);
+                    out.Write(" -> b");
+                    out.WriteDec(successor.block);
+                    if (successor.recovered) {
+                        out.Write(successor.kind == Unflattener::EdgeKind::Direct ? " [style=bold]"
+                                  : successor.kind == Unflattener::EdgeKind::SelectTrue ? " [style=bold, label=\"true\"]"
+                                                                                       : " [style=bold, label=\"false\"]");
+                    }
+                    out.Write(";\n");
+                }
+            }
+            out.Write("}\n");
+            continue;
+        }
+
+        json.BeginObject();
+        json.Member("Address", rva);
+        json.Member("Token", uint64_t(token));
+        json.Member("Name", name);
+        json.Member("Size", uint64_t(function.size));
+        json.Key("Flattened");
+        json.Bool(result != nullptr);
+        if (result) {
+            json.Member("State", Unflattener::DescribeLocation(machine, result->state));
+            json.Member("Unresolved", uint64_t(result->unresolvedCount));
+        }
+        json.Key("Blocks");
+        json.BeginArray();
+        for (uint32_t b = 0; b < function.blockCount; b++) {
+            json.BeginObject();
+            json.Member("Offset", uint64_t(blocks[b].offset));
+            json.Member("Size", uint64_t(blocks[b].size));
+            json.Member("Instructions", uint64_t(blocks[b].instructionCount));
+            if (isDispatcher(b)) {
+                json.Key("Dispatcher");
+                json.Bool(true);
+            }
+            json.Key("Successors");
+            json.BeginArray();
+            collectSuccessors(b);
+            for (const Successor& successor : successors) json.Uint(successor.block);
+            json.EndArray();
+            json.EndObject();
+        }
+        json.EndArray();
+        if (result) {
+            static const char* const kEdgeKinds[] = {"Direct", "SelectTrue", "SelectFalse"};
+            json.Key("RecoveredEdges");
+            json.BeginArray();
+            for (uint32_t e = 0; e < result->edgeCount; e++) {
+                json.BeginObject();
+                json.Member("From", uint64_t(edges[e].from));
+                json.Member("To", uint64_t(edges[e].to));
+                json.Member("Kind", kEdgeKinds[static_cast<int>(edges[e].kind)]);
+                json.EndObject();
+            }
+            json.EndArray();
+        }
+        json.EndObject();
+        json.EndRecord();
+    }
 
-        if (i > 0) out << ",\n";
-        out << "    {\n";
-        out << "      \"index\": " << i << ",\n";
-        out << "      \"name\": \"" << (methodName ? methodName : "UnknownMethod") << "\",\n";
-        out << "      \"token\": " << methodDef->token << ",\n";
-        out << "      \"flags\": " << methodDef->flags << ",\n";
-        out << "      \"offset\": " << methodOffset << ",\n";
-        out << "      \"offsetHex\": \"0x" << std::hex << methodOffset << std::dec << "\"\n";
-        out << "    }";
+    if (!out.Close()) {
+        vlog << "[-] Error while writing " << outputPath << "\n";
+        return;
     }
+    vlog << "[+] Control flow written to " << outputPath << ": " << controlFlow.FunctionCount() << " functions ("
+         << unflattener.FlattenedCount() << " unflattened), " << out.BytesWritten() << " bytes\n";
+}
 
-    out << "\n  ]\n";
-    out << "}\n";
+void MetadataLoader::AnalyzeBinaryForSymbols() {
+    // Analyze the library binary to recover additional symbols
+    if (libBuffer.empty()) {
+        vlog << "[*] No library loaded for binary analysis\n";
+        return;
+    }
+    
+    vlog << "[*] Analyzing binary for additional symbols...\n";
+    
+    // Common patterns in the binary that might reveal class/method names are
+    // collected by the shared library scan
+    ScanLibrary();
+    const char* data = libBuffer.data();
+    for (const auto& symbol : libraryScan.symbols) {
+        vlog << "[+] Found potential symbol in binary: " << std::string_view(data + symbol.offset, symbol.count) << "\n";
+    }
+}
 
-    out.close();
-}
\ No newline at end of file
+void MetadataLoader::DumpStrings(const std::string& p) {}
+void MetadataLoader::DumpClasses(const std::string& p) {}
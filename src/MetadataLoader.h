@@ -1,10 +1,29 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <functional>
 #include "il2cpp_structs.h"
+#include "BufferedWriter.h"
+#include "ControlFlowGraph.h"
+#include "ElfImage.h"
+#include "MappedFile.h"
+#include "MetadataColumns.h"
+#include "MetadataTables.h"
+#include "NameClassifier.h"
+#include "PatternScanner.h"
+#include "RegistrationLocator.h"
+#include "StringArena.h"
+#include "SymbolTables.h"
+#include "TypeHierarchy.h"
+#include "TypeTable.h"
+#include "Unflattener.h"
+
+class ThreadPool;
+struct SymbolRecoveryOutput;
 
 std::string get_verbose_log();
 
@@ -15,6 +34,12 @@ struct ObfuscationProfile {
     std::function<void(class MetadataLoader*)> deobfuscate_func;
 };
 
+// Occurrence of a recovered symbol name in the library image
+struct BinaryStringHit {
+    std::string_view symbol;    // Interned name, valid for the loader's lifetime
+    uint64_t offset;            // File offset of the first byte in the library
+};
+
 struct DeobfuscationResult {
     bool success;
     std::string error_message;
@@ -24,12 +49,33 @@ struct DeobfuscationResult {
 
 class MetadataLoader {
 public:
+    // Called as long-running passes advance: task name, units done, units total
+    using ProgressCallback = std::function<void(const char* task, uint64_t done, uint64_t total)>;
+
     MetadataLoader();
     ~MetadataLoader();
 
     bool LoadFile(const std::string& filePath);
     bool LoadLibrary(const std::string& libPath);
     void Process();
+    // Worker threads used by the parallel passes; 0 = all hardware threads
+    void SetThreadCount(unsigned count);
+    void SetProgressCallback(ProgressCallback callback);
+    // When set, Process() writes one .cs file per assembly into this directory
+    // instead of a single dump.cs
+    void SetCSOutputDirectory(const std::string& outputDir);
+    // When set, Process() writes script.ndjson (one record per line) instead of
+    // script.json
+    void SetJsonLines(bool enabled);
+    // Selects which of script.json (or .ndjson) and script.il2b Process() writes
+    void SetScriptOutputs(bool json, bool binary);
+    // When set, Process() runs control flow restoration and writes the
+    // recovered graphs to this file: NDJSON, or Graphviz if it ends in .dot
+    void SetControlFlowOutput(const std::string& path);
+    // Replaces the heuristic that decides which names symbol recovery treats
+    // as obfuscated; an empty model restores it. The model is called from
+    // every worker at once during recovery, so it must be thread-safe
+    void SetNameModel(NameClassifier::Model model);
     const Il2CppGlobalMetadataHeader* getHeader() const { return header; }
 
     // Deobfuscation methods
@@ -40,71 +86,212 @@ public:
     void DumpStrings(const std::string& outputPath);
     void DumpClasses(const std::string& outputPath);
     void DumpCS(const std::string& outputPath);
-    void DumpScriptJSON(const std::string& outputPath);
-    void DumpCSLimited(const std::string& outputPath, int maxElements);
-    void DumpScriptJSONLimited(const std::string& outputPath, int maxElements);
+    void DumpCSPerAssembly(const std::string& outputDir);
+    void DumpScriptJSON(const std::string& outputPath, bool jsonLines = false);
+    // Compact binary tables, see BinaryExport.h for the layout
+    void DumpBinary(const std::string& outputPath);
+    // Control flow graph of every swept method, with the edges recovered by
+    // unflattening; see SetControlFlowOutput()
+    void DumpControlFlow(const std::string& outputPath);
 
     // Enhanced methods for deobfuscation
-    std::string GetDecryptedString(StringIndex index);
-    std::string GetRecoveredSymbol(uint32_t token);
+    std::string_view GetDecryptedString(StringIndex index);
+    std::string_view GetRecoveredSymbol(uint32_t token);
     void AnalyzeBinaryForSymbols();
+    // Extra byte signatures ("name: 48 8B ?? ...") to look for in the library
+    bool LoadSignatureFile(const std::string& path);
+    void ReportSignatureMatches();
+    // Hits from the last cross-reference pass, ordered by end offset
+    const std::vector<BinaryStringHit>& GetBinaryStringHits() const { return binaryStringHits; }
     void GenerateDeobfuscationReport();
 
+    // Locates CodeRegistration/MetadataRegistration in the library and builds
+    // the per-method address table; called by Process() when a library is
+    // loaded
+    bool ResolveMethodAddresses();
+    // Code RVA of a method, 0 if unknown (abstract, or no library)
+    uint64_t GetMethodAddress(MethodIndex index) const {
+        return index < methodAddresses.size() ? methodAddresses[index] : 0;
+    }
+
+    // Parent/child, nested and interface links between type definitions,
+    // built when the metadata is loaded
+    const TypeHierarchy& GetTypeHierarchy() const { return typeHierarchy; }
+    // Definition with this namespace and name, TypeHierarchy::kNoType if none.
+    // A linear scan, meant for finding a root such as UnityEngine.MonoBehaviour
+    // before walking the hierarchy from it.
+    TypeDefinitionIndex FindTypeDefinition(std::string_view ns, std::string_view name) const;
+
     // Public accessors for testing/debugging
     const char* GetStringFromIndexPublic(StringIndex index) { return GetStringFromIndex(index); }
+    std::string_view GetStringView(StringIndex index) const;
 
 private:
-    std::vector<char> fileBuffer;
-    std::vector<char> libBuffer;
-    const Il2CppGlobalMetadataHeader* header;
-    uint64_t libBase;
+    MappedFile fileBuffer;
+    MappedFile libBuffer;
+    ElfImage libImage;
+    // File ranges of the library to scan for code patterns or for strings;
+    // the whole file if it could not be parsed as ELF
+    std::vector<ElfImage::FileRange> LibraryRanges(bool code) const;
+    MetadataTables metadata;    // Header and records in the in-memory layout
+    const Il2CppGlobalMetadataHeader* header;   // &metadata.Header() once loaded
+    MetadataColumns columns;    // Type and method fields by column, built by LoadFile()
+    uint64_t libBase;   // Lowest load address of the library
+    CodeRegistrationInfo codeRegistration;
+    MetadataRegistrationInfo metadataRegistration;
+    std::vector<uint64_t> methodAddresses;  // RVA by MethodIndex
+    bool addressesTried;    // ResolveMethodAddresses() ran on this library
+    bool addressesFound;    // ...and found CodeRegistration
+    ControlFlowGraph controlFlow;           // Built by restoreLinearControlFlow()
+    Unflattener unflattener;                // Run by unflattenControlFlow()
+    TypeHierarchy typeHierarchy;            // Built by BuildTypeHierarchy()
+    TypeTable typeTable;                    // Built by BuildTypeTable()
+    TypeNameCache typeNames;                // C# name by TypeIndex, from typeTable
+    // typeTable's method specs grouped by MethodIndex (CSR offsets and spec
+    // indices)
+    std::vector<uint32_t> methodSpecStart;
+    std::vector<uint32_t> methodSpecs;
+
+    // Resolved location of every string, built once by BuildStringIndex()
+    struct StringEntry {
+        uint32_t offset;  // File offset, kInvalidStringOffset if unresolved
+        uint32_t length;
+    };
+    static constexpr uint32_t kInvalidStringOffset = 0xFFFFFFFF;
+    std::vector<StringEntry> stringTable;
     size_t metadataOffset;
 
     // Deobfuscation data
     std::vector<ObfuscationProfile> obfuscationProfiles;
-    std::map<StringIndex, std::string> decryptedStrings;
-    std::map<uint32_t, std::string> recoveredSymbols;
+    // Decrypted strings (by string index) and recovered names (by token) are
+    // kept in dense side tables of ids into one interning arena
+    StringArena nameArena;
+    IndexedStringTable decryptedStrings;
+    RecoveredSymbolTable recoveredSymbols;
+    NameClassifier nameClassifier;
     bool isObfuscated;
+    std::vector<BinaryStringHit> binaryStringHits;
+
+    unsigned threadCount;
+    std::unique_ptr<ThreadPool> threadPool;
+    ThreadPool& GetThreadPool();
+    ProgressCallback progressCallback;
+    void ReportProgress(const char* task, uint64_t done, uint64_t total);
+    std::string csOutputDir;
+    bool jsonLines;
+    bool writeScriptJson;
+    bool writeBinary;
+    std::string controlFlowOutput;
+
+    // C# rendering; safe to run on worker threads once deobfuscation is done
+    std::string_view LookupName(StringIndex index) const;
+    uint32_t RenderImageCS(const Il2CppImageDefinition* imageDef, TextBuffer& out);
+    // Renders all images and hands them to sink in image order; returns the
+    // number of types written
+    uint32_t RenderImagesCS(const std::function<void(ImageIndex, const TextBuffer&)>& sink);
+    // Type name qualified by its declaring types (Outer.Inner), optionally
+    // without the `N arity suffixes of generic definitions
+    void WriteTypeName(TextBuffer& out, TypeDefinitionIndex index, bool withoutArity = false);
+    static constexpr size_t kMaxNestingDepth = 16;
+    // Generic container of a type or method, nullptr if it has none or the
+    // container does not belong to it
+    const Il2CppGenericContainer* GetGenericContainer(GenericContainerIndex index, uint32_t owner, bool isMethod) const;
+    void WriteGenericParameterName(TextBuffer& out, GenericParameterIndex index) const;
+    // "<T, out U>" and " where T : class, IFoo, new()"
+    void WriteGenericParameters(TextBuffer& out, const Il2CppGenericContainer* container) const;
+    void WriteGenericConstraints(TextBuffer& out, const Il2CppGenericContainer* container);
+    // "Base<int>.Get<string>"
+    void WriteMethodSpecName(TextBuffer& out, const TypeTable::MethodSpec& spec);
+    // C# type of a parameter or return value, with ref/out/in for byref
+    // types; "?" if the type table does not know it
+    void WriteTypeReference(TextBuffer& out, TypeIndex type, bool parameter) const;
+    // "ReturnType Name(Type name, ...)", or "void Name()" without a type table
+    void WriteMethodSignature(TextBuffer& out, MethodIndex index, const Il2CppMethodDefinition* methodDef,
+                              std::string_view name) const;
 
     const char* GetStringFromIndex(StringIndex index);
+    void BuildStringIndex();
+    // genericTypes maps generic instance TypeIndex values to their definition
+    void BuildTypeHierarchy(const std::vector<std::pair<TypeIndex, TypeDefinitionIndex>>& genericTypes = {});
+    // Decodes the library's Il2CppType table and renders the type names;
+    // needs the MetadataRegistration, so runs after ResolveMethodAddresses()
+    void BuildTypeTable();
     void DetectUnityVersion();
     void ApplyStringDecryption();
     void ApplyControlFlowRestoration();
     void ApplySymbolRecovery();
+    bool FindDecryptedString(StringIndex index, std::string_view& value) const;
+    void StoreDecryptedString(StringIndex index, std::string_view value);
 
     // String decryption helper methods
-    std::string tryXORDecryption(const std::string& encrypted);
-    std::string tryCaesarDecryption(const std::string& encrypted);
-    std::string tryBase64Decryption(const std::string& encrypted);
-    std::string tryRot13Decryption(const std::string& encrypted);
-    std::string tryCustomPatternDecryption(const std::string& encrypted);
+    // Successful results are interned in nameArena; an empty view means failure
+    std::string_view tryDecryption(std::string_view str);
+    std::string_view tryXORDecryption(std::string_view encrypted);
+    std::string_view tryCaesarDecryption(std::string_view encrypted);
+    std::string_view tryBase64Decryption(std::string_view encrypted);
+    std::string_view tryRot13Decryption(std::string_view encrypted);
+    std::string_view tryCustomPatternDecryption(std::string_view encrypted);
     std::string processObfuscatedString(const std::string& input);
-    bool hasCommonStringPatterns(const std::string& str);
-    std::string base64_decode(const std::string& input);
+    bool hasCommonStringPatterns(std::string_view str);
+    void base64_decode(std::string_view input, std::string& output);
 
     // Control flow restoration methods
     void identifyDispatcherPatterns();
     void identifySwitchStatementObfuscation();
     void identifyJunkCode();
+
+    // All binary detectors share one pass over the library; ScanLibrary() runs
+    // it on first use and the detectors report from the cached results
+    struct LibraryRange {
+        uint64_t offset;
+        uint32_t count;
+    };
+    struct SignatureHit {
+        uint32_t signature;
+        uint64_t offset;
+    };
+    struct LibraryScanResults {
+        bool done = false;
+        std::vector<uint64_t> dispatchers;
+        std::vector<LibraryRange> branchClusters;   // offset of the last branch, branch count
+        std::vector<LibraryRange> nopRuns;          // run start, NOP count
+        std::vector<LibraryRange> symbols;          // "System." names: offset, length
+        std::vector<SignatureHit> signatureHits;    // matches of customSignatures
+    };
+    LibraryScanResults libraryScan;
+    PatternScanner customSignatures;
+    void ScanLibrary();
     void restoreLinearControlFlow();
+    void unflattenControlFlow();
 
-    // Symbol recovery methods
-    void recoverClassNames();
-    void recoverMethodNames();
-    void recoverFieldNames();
-    void recoverPropertyNames();
-    bool isObfuscatedName(const std::string& name);
-    std::string inferClassName(TypeDefinitionIndex index, const Il2CppTypeDefinition* typeDef);
-    std::string inferMethodName(MethodIndex index, const Il2CppMethodDefinition* methodDef);
-    std::string inferFieldName(FieldIndex index, const Il2CppFieldDefinition* fieldDef);
-    std::string inferPropertyName(PropertyIndex index, const Il2CppPropertyDefinition* propDef);
-    std::string enhanceClassName(const std::string& original, TypeDefinitionIndex index);
-    std::string enhanceMethodName(const std::string& original, MethodIndex index);
+    // Symbol recovery methods. The passes only read shared state and write
+    // their own output, so they can run concurrently; the merge applies the
+    // output to recoveredSymbols and the decrypted strings
+    void recoverClassNames(SymbolRecoveryOutput& out);
+    void recoverMethodNames(SymbolRecoveryOutput& out);
+    void recoverFieldNames(SymbolRecoveryOutput& out);
+    void recoverPropertyNames(SymbolRecoveryOutput& out);
+    void mergeRecoveredNames(const SymbolRecoveryOutput& out, uint32_t table, const char* kind);
+    // GetDecryptedString() for the passes: strings it would cache are
+    // appended to decrypted instead
+    std::string_view recoveryName(StringIndex index, std::vector<std::pair<StringIndex, std::string_view>>& decrypted);
+    bool isObfuscatedName(std::string_view name);
+    // Inferred names are interned in nameArena and stay valid with the loader
+    std::string_view MakeIndexedName(std::string_view prefix, uint32_t index);
+    std::string_view inferClassName(TypeDefinitionIndex index, const Il2CppTypeDefinition* typeDef);
+    std::string_view inferMethodName(MethodIndex index, const Il2CppMethodDefinition* methodDef);
+    std::string_view inferFieldName(FieldIndex index, const Il2CppFieldDefinition* fieldDef);
+    std::string_view inferPropertyName(PropertyIndex index, const Il2CppPropertyDefinition* propDef);
+    std::string_view enhanceClassName(std::string_view original, TypeDefinitionIndex index);
+    std::string_view enhanceMethodName(std::string_view original, MethodIndex index);
     void crossReferenceWithBinary();
 
     // New methods for proper IL2CPP metadata access
+    const Il2CppImageDefinition* GetImageDefinition(ImageIndex index);
     const Il2CppTypeDefinition* GetTypeDefinition(TypeDefinitionIndex index);
     const Il2CppMethodDefinition* GetMethodDefinition(MethodIndex index);
     const Il2CppFieldDefinition* GetFieldDefinition(FieldIndex index);
     const Il2CppPropertyDefinition* GetPropertyDefinition(PropertyIndex index);
+    const Il2CppParameterDefinition* GetParameterDefinition(ParameterIndex index) const;
+    const Il2CppGenericParameter* GetGenericParameter(GenericParameterIndex index) const;
 };
@@ -0,0 +1,345 @@
+#include "MetadataTables.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include "MappedFile.h"
+
+namespace {
+
+using V23 = MetadataLayout<MetadataLayoutVersion::V23>;
+using V24_0 = MetadataLayout<MetadataLayoutVersion::V24_0>;
+using V24_1 = MetadataLayout<MetadataLayoutVersion::V24_1>;
+using V24_2 = MetadataLayout<MetadataLayoutVersion::V24_2>;
+using V27 = MetadataLayout<MetadataLayoutVersion::V27>;
+using V29 = MetadataLayout<MetadataLayoutVersion::V29>;
+using V31 = MetadataLayout<MetadataLayoutVersion::V31>;
+
+// Conversions from on-disk records to the in-memory ones. Members are copied
+// by name, so one template serves every layout that only adds or moves
+// members; the layouts that drop one have their own overload.
+
+// v23 to v24.1: rgctx and metadata usage tables; v24.1 adds exported types
+template <typename Header>
+void ReadEarlyHeader(const Header& in, Il2CppGlobalMetadataHeader& out) {
+    std::memcpy(&out, &in.prefix, sizeof(in.prefix));
+    out.imagesOffset = in.imagesOffset;
+    out.imagesCount = in.imagesCount;
+    out.assembliesOffset = in.assembliesOffset;
+    out.assembliesCount = in.assembliesCount;
+    out.metadataUsageListsOffset = in.metadataUsageListsOffset;
+    out.metadataUsageListsCount = in.metadataUsageListsCount;
+    out.metadataUsagePairsOffset = in.metadataUsagePairsOffset;
+    out.metadataUsagePairsCount = in.metadataUsagePairsCount;
+    out.fieldRefsOffset = in.fieldRefsOffset;
+    out.fieldRefsCount = in.fieldRefsCount;
+    out.referencedAssembliesOffset = in.referencedAssembliesOffset;
+    out.referencedAssembliesCount = in.referencedAssembliesCount;
+    out.attributesInfoOffset = in.attributesInfoOffset;
+    out.attributesInfoCount = in.attributesInfoCount;
+    out.attributeTypesOffset = in.attributeTypesOffset;
+    out.attributeTypesCount = in.attributeTypesCount;
+    out.unresolvedVirtualCallParameterTypesOffset = in.unresolvedVirtualCallParameterTypesOffset;
+    out.unresolvedVirtualCallParameterTypesCount = in.unresolvedVirtualCallParameterTypesCount;
+    out.unresolvedVirtualCallParameterRangesOffset = in.unresolvedVirtualCallParameterRangesOffset;
+    out.unresolvedVirtualCallParameterRangesCount = in.unresolvedVirtualCallParameterRangesCount;
+    out.windowsRuntimeTypeNamesOffset = in.windowsRuntimeTypeNamesOffset;
+    out.windowsRuntimeTypeNamesSize = in.windowsRuntimeTypeNamesSize;
+}
+
+void ReadRecord(const V23::Header& in, Il2CppGlobalMetadataHeader& out) {
+    ReadEarlyHeader(in, out);
+    out.exportedTypeDefinitionsOffset = 0;
+    out.exportedTypeDefinitionsCount = 0;
+}
+
+void ReadRecord(const V24_1::Header& in, Il2CppGlobalMetadataHeader& out) {
+    ReadEarlyHeader(in, out);
+    out.exportedTypeDefinitionsOffset = in.exportedTypeDefinitionsOffset;
+    out.exportedTypeDefinitionsCount = in.exportedTypeDefinitionsCount;
+}
+
+// v27 and later: no metadata usage tables
+template <typename Header>
+void ReadLateHeader(const Header& in, Il2CppGlobalMetadataHeader& out) {
+    std::memcpy(&out, &in.prefix, sizeof(in.prefix));
+    out.imagesOffset = in.imagesOffset;
+    out.imagesCount = in.imagesCount;
+    out.assembliesOffset = in.assembliesOffset;
+    out.assembliesCount = in.assembliesCount;
+    out.fieldRefsOffset = in.fieldRefsOffset;
+    out.fieldRefsCount = in.fieldRefsCount;
+    out.referencedAssembliesOffset = in.referencedAssembliesOffset;
+    out.referencedAssembliesCount = in.referencedAssembliesCount;
+    out.unresolvedVirtualCallParameterTypesOffset = in.unresolvedVirtualCallParameterTypesOffset;
+    out.unresolvedVirtualCallParameterTypesCount = in.unresolvedVirtualCallParameterTypesCount;
+    out.unresolvedVirtualCallParameterRangesOffset = in.unresolvedVirtualCallParameterRangesOffset;
+    out.unresolvedVirtualCallParameterRangesCount = in.unresolvedVirtualCallParameterRangesCount;
+    out.windowsRuntimeTypeNamesOffset = in.windowsRuntimeTypeNamesOffset;
+    out.windowsRuntimeTypeNamesSize = in.windowsRuntimeTypeNamesSize;
+    out.exportedTypeDefinitionsOffset = in.exportedTypeDefinitionsOffset;
+    out.exportedTypeDefinitionsCount = in.exportedTypeDefinitionsCount;
+}
+
+void ReadRecord(const V27::Header& in, Il2CppGlobalMetadataHeader& out) {
+    ReadLateHeader(in, out);
+    out.attributesInfoOffset = in.attributesInfoOffset;
+    out.attributesInfoCount = in.attributesInfoCount;
+    out.attributeTypesOffset = in.attributeTypesOffset;
+    out.attributeTypesCount = in.attributeTypesCount;
+}
+
+void ReadRecord(const V29::Header& in, Il2CppGlobalMetadataHeader& out) {
+    ReadLateHeader(in, out);
+}
+
+void ReadRecord(const V23::ImageDefinition& in, Il2CppImageDefinition& out) {
+    out.nameIndex = in.nameIndex;
+    out.assemblyIndex = in.assemblyIndex;
+    out.typeStart = in.typeStart;
+    out.typeCount = in.typeCount;
+    out.exportedTypeStart = 0;
+    out.exportedTypeCount = 0;
+    out.entryPointIndex = in.entryPointIndex;
+    out.token = in.token;
+    out.customAttributeStart = 0;
+    out.customAttributeCount = 0;
+}
+
+void ReadRecord(const V24_0::ImageDefinition& in, Il2CppImageDefinition& out) {
+    out.nameIndex = in.nameIndex;
+    out.assemblyIndex = in.assemblyIndex;
+    out.typeStart = in.typeStart;
+    out.typeCount = in.typeCount;
+    out.exportedTypeStart = in.exportedTypeStart;
+    out.exportedTypeCount = in.exportedTypeCount;
+    out.entryPointIndex = in.entryPointIndex;
+    out.token = in.token;
+    out.customAttributeStart = 0;
+    out.customAttributeCount = 0;
+}
+
+template <typename Raw>
+void ReadTypeDefinition(const Raw& in, Il2CppTypeDefinition& out) {
+    out.nameIndex = in.nameIndex;
+    out.namespaceIndex = in.namespaceIndex;
+    out.byvalTypeIndex = in.byvalTypeIndex;
+    out.declaringTypeIndex = in.declaringTypeIndex;
+    out.parentIndex = in.parentIndex;
+    out.elementTypeIndex = in.elementTypeIndex;
+    out.genericContainerIndex = in.genericContainerIndex;
+    out.flags = in.flags;
+    out.fieldStart = in.fieldStart;
+    out.methodStart = in.methodStart;
+    out.eventStart = in.eventStart;
+    out.propertyStart = in.propertyStart;
+    out.nestedTypesStart = in.nestedTypesStart;
+    out.interfacesStart = in.interfacesStart;
+    out.vtableStart = in.vtableStart;
+    out.interfaceOffsetsStart = in.interfaceOffsetsStart;
+    out.method_count = in.method_count;
+    out.property_count = in.property_count;
+    out.field_count = in.field_count;
+    out.event_count = in.event_count;
+    out.nested_type_count = in.nested_type_count;
+    out.vtable_count = in.vtable_count;
+    out.interfaces_count = in.interfaces_count;
+    out.interface_offsets_count = in.interface_offsets_count;
+    out.bitfield = in.bitfield;
+    out.token = in.token;
+}
+
+void ReadRecord(const V24_0::TypeDefinition& in, Il2CppTypeDefinition& out) {
+    ReadTypeDefinition(in, out);
+    out.byrefTypeIndex = in.byrefTypeIndex;
+}
+
+void ReadRecord(const V24_1::TypeDefinition& in, Il2CppTypeDefinition& out) {
+    ReadTypeDefinition(in, out);
+    out.byrefTypeIndex = in.byrefTypeIndex;
+}
+
+// v27 dropped the byref TypeIndex; the runtime derives it from byval
+void ReadRecord(const V27::TypeDefinition& in, Il2CppTypeDefinition& out) {
+    ReadTypeDefinition(in, out);
+    out.byrefTypeIndex = static_cast<TypeIndex>(kMetadataInvalidPointer);
+}
+
+template <typename Raw>
+void ReadRecord(const Raw& in, Il2CppMethodDefinition& out) {
+    out.nameIndex = in.nameIndex;
+    out.declaringType = in.declaringType;
+    out.returnType = in.returnType;
+    out.parameterStart = in.parameterStart;
+    out.genericContainerIndex = in.genericContainerIndex;
+    out.token = in.token;
+    out.flags = in.flags;
+    out.iflags = in.iflags;
+    out.slot = in.slot;
+    out.parameterCount = in.parameterCount;
+}
+
+template <typename Raw>
+void ReadRecord(const Raw& in, Il2CppFieldDefinition& out) {
+    out.nameIndex = in.nameIndex;
+    out.typeIndex = in.typeIndex;
+    out.token = in.token;
+}
+
+template <typename Raw>
+void ReadRecord(const Raw& in, Il2CppPropertyDefinition& out) {
+    out.nameIndex = in.nameIndex;
+    out.get = in.get;
+    out.set = in.set;
+    out.attrs = in.attrs;
+    out.token = in.token;
+}
+
+template <typename Raw>
+void ReadRecord(const Raw& in, Il2CppParameterDefinition& out) {
+    out.nameIndex = in.nameIndex;
+    out.token = in.token;
+    out.typeIndex = in.typeIndex;
+}
+
+// Reads up to count Raw records at offset into table: in place when Raw is
+// the in-memory record, converted otherwise
+template <typename Raw, typename T>
+void ReadTable(const MappedFile& file, int32_t offset, int32_t count, MetadataTables::Table<T>& table) {
+    const size_t start = static_cast<uint32_t>(offset);
+    if (count <= 0 || start >= file.size()) return;
+    const size_t records = std::min<size_t>(static_cast<uint32_t>(count), (file.size() - start) / sizeof(Raw));
+    const char* data = file.data() + start;
+    MetadataSpan<T>& view = table;
+    if constexpr (std::is_same_v<Raw, T>) {
+        view = MetadataSpan<T>(reinterpret_cast<const T*>(data), records);
+    } else {
+        table.converted.resize(records);
+        for (size_t i = 0; i < records; i++) {
+            Raw raw;
+            std::memcpy(&raw, data + i * sizeof(Raw), sizeof(Raw));
+            ReadRecord(raw, table.converted[i]);
+        }
+        view = MetadataSpan<T>(table.converted.data(), records);
+    }
+}
+
+template <typename T>
+void ClearTable(MetadataTables::Table<T>& table) {
+    static_cast<MetadataSpan<T>&>(table) = MetadataSpan<T>();
+    table.converted.clear();
+    table.converted.shrink_to_fit();
+}
+
+} // namespace
+
+const char* MetadataLayoutName(MetadataLayoutVersion layout) {
+    switch (layout) {
+    case MetadataLayoutVersion::V23: return "v23";
+    case MetadataLayoutVersion::V24_0: return "v24.0";
+    case MetadataLayoutVersion::V24_1: return "v24.1";
+    case MetadataLayoutVersion::V24_2: return "v24.2";
+    case MetadataLayoutVersion::V27: return "v27";
+    case MetadataLayoutVersion::V29: return "v29";
+    case MetadataLayoutVersion::V31: return "v31";
+    }
+    return "unknown";
+}
+
+MetadataLayoutVersion MetadataTables::DetectLayout(const MappedFile& file) {
+    Il2CppMetadataHeaderPrefix prefix = {};
+    std::memcpy(&prefix, file.data(), std::min(file.size(), sizeof(prefix)));
+    if (prefix.version >= 31) return MetadataLayoutVersion::V31;
+    if (prefix.version >= 29) return MetadataLayoutVersion::V29;
+    if (prefix.version >= 27) return MetadataLayoutVersion::V27;
+    if (prefix.version < 24) return MetadataLayoutVersion::V23;
+    if (prefix.version > 24) return MetadataLayoutVersion::V24_2;
+
+    // The string literal table follows the header, whose rgctx range was
+    // dropped in v24.2. Anything but the older header size is read as v24.2.
+    if (static_cast<uint32_t>(prefix.stringLiteralOffset) != sizeof(V24_0::Header) ||
+        file.size() < sizeof(V24_0::Header)) {
+        return MetadataLayoutVersion::V24_2;
+    }
+    // v24.1 appended the custom attribute range to the images. Read with the
+    // v24.0 stride, every image token is 1 only if it was not there.
+    V24_0::Header header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    const size_t start = static_cast<uint32_t>(header.imagesOffset);
+    if (header.imagesCount <= 0 || start >= file.size()) return MetadataLayoutVersion::V24_0;
+    const size_t count = std::min<size_t>(static_cast<uint32_t>(header.imagesCount),
+                                          (file.size() - start) / sizeof(V24_0::ImageDefinition));
+    for (size_t i = 0; i < count; i++) {
+        V24_0::ImageDefinition image;
+        std::memcpy(&image, file.data() + start + i * sizeof(image), sizeof(image));
+        if (image.token != 1) return MetadataLayoutVersion::V24_1;
+    }
+    if (count > 1) return MetadataLayoutVersion::V24_0;
+    // A lone image has token 1 in both layouts. Its record then runs up to
+    // the nearest table after it: 32 bytes in v24.0, 40 in v24.1. Every
+    // header field after the version is an offset and count pair.
+    int32_t words[sizeof(header) / sizeof(int32_t)];
+    std::memcpy(words, &header, sizeof(words));
+    size_t next = file.size();
+    for (size_t i = 2; i + 1 < sizeof(words) / sizeof(int32_t); i += 2) {
+        const size_t offset = static_cast<uint32_t>(words[i]);
+        if (offset > start && offset < next) next = offset;
+    }
+    return next - start >= sizeof(V24_1::ImageDefinition) ? MetadataLayoutVersion::V24_1
+                                                           : MetadataLayoutVersion::V24_0;
+}
+
+bool MetadataTables::Load(const MappedFile& file) {
+    Clear();
+    layout = DetectLayout(file);
+    switch (layout) {
+    case MetadataLayoutVersion::V23: return Read<V23>(file);
+    case MetadataLayoutVersion::V24_0: return Read<V24_0>(file);
+    case MetadataLayoutVersion::V24_1: return Read<V24_1>(file);
+    case MetadataLayoutVersion::V24_2: return Read<V24_2>(file);
+    case MetadataLayoutVersion::V27: return Read<V27>(file);
+    case MetadataLayoutVersion::V29: return Read<V29>(file);
+    case MetadataLayoutVersion::V31: return Read<V31>(file);
+    }
+    return false;
+}
+
+template <typename Layout>
+bool MetadataTables::Read(const MappedFile& file) {
+    using Header = typename Layout::Header;
+    if (file.size() < sizeof(Header)) return false;
+    if constexpr (std::is_same_v<Header, Il2CppGlobalMetadataHeader>) {
+        std::memcpy(&header, file.data(), sizeof(header));
+    } else {
+        Header raw;
+        std::memcpy(&raw, file.data(), sizeof(raw));
+        ReadRecord(raw, header);
+    }
+
+    ReadTable<typename Layout::ImageDefinition>(file, header.imagesOffset, header.imagesCount, images);
+    ReadTable<typename Layout::TypeDefinition>(file, header.typeDefinitionsOffset, header.typeDefinitionsCount, types);
+    ReadTable<typename Layout::MethodDefinition>(file, header.methodsOffset, header.methodsCount, methods);
+    ReadTable<typename Layout::FieldDefinition>(file, header.fieldsOffset, header.fieldsCount, fields);
+    ReadTable<typename Layout::PropertyDefinition>(file, header.propertiesOffset, header.propertiesCount, properties);
+    ReadTable<typename Layout::ParameterDefinition>(file, header.parametersOffset, header.parametersCount, parameters);
+    return true;
+}
+
+void MetadataTables::Clear() {
+    layout = MetadataLayoutVersion::V24_2;
+    header = {};
+    ClearTable(images);
+    ClearTable(types);
+    ClearTable(methods);
+    ClearTable(fields);
+    ClearTable(properties);
+    ClearTable(parameters);
+}
+
+size_t MetadataTables::ConvertedBytes() const {
+    return images.converted.size() * sizeof(Il2CppImageDefinition) +
+           types.converted.size() * sizeof(Il2CppTypeDefinition) +
+           methods.converted.size() * sizeof(Il2CppMethodDefinition) +
+           fields.converted.size() * sizeof(Il2CppFieldDefinition) +
+           properties.converted.size() * sizeof(Il2CppPropertyDefinition) +
+           parameters.converted.size() * sizeof(Il2CppParameterDefinition);
+}
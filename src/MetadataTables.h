@@ -0,0 +1,87 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "MetadataLayout.h"
+
+class MappedFile;
+
+// A run of records checked once against its table when it is made: every
+// element of [begin(), end()) lies inside the table, so iterating or
+// indexing it needs no further checks, while Get() and Slice() stay safe for
+// indices read from the file
+template <typename T>
+class MetadataSpan {
+public:
+    MetadataSpan() = default;
+    MetadataSpan(const T* first, size_t count) : first(first), count(count) {}
+
+    const T* begin() const { return first; }
+    const T* end() const { return first + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T& operator[](size_t index) const { return first[index]; }
+
+    const T* Get(uint64_t index) const { return index < count ? first + index : nullptr; }
+    // Elements [start, start + length), cut to the part inside this span
+    MetadataSpan Slice(uint64_t start, uint64_t length) const {
+        if (start >= count) return MetadataSpan();
+        return MetadataSpan(first + start, static_cast<size_t>(std::min<uint64_t>(length, count - start)));
+    }
+    // Index of an element of this span
+    uint32_t IndexOf(const T& element) const { return static_cast<uint32_t>(&element - first); }
+
+private:
+    const T* first = nullptr;
+    size_t count = 0;
+};
+
+// The header and versioned record tables of a metadata file, in the
+// in-memory layout of il2cpp_structs.h whatever layout the file uses. Load()
+// picks the layout once from the header; it then reads every table with the
+// reader instantiated for that layout, so the copy loops run with the
+// layout's constant record sizes. Tables already stored in the in-memory
+// layout are used in place.
+class MetadataTables {
+public:
+    // Records of one table: whole records inside the file, at most the
+    // header's count
+    template <typename T>
+    struct Table : MetadataSpan<T> {
+        std::vector<T> converted;   // Backing store when not used in place
+    };
+
+    // The layout the file's version and header call for; v24 files are told
+    // apart by their header size and image records
+    static MetadataLayoutVersion DetectLayout(const MappedFile& file);
+
+    // False if the file is too small for the header of its layout
+    bool Load(const MappedFile& file);
+    void Clear();
+
+    MetadataLayoutVersion Layout() const { return layout; }
+    const Il2CppGlobalMetadataHeader& Header() const { return header; }
+    // Bytes of records that were converted rather than used in place
+    size_t ConvertedBytes() const;
+
+    const Table<Il2CppImageDefinition>& Images() const { return images; }
+    const Table<Il2CppTypeDefinition>& Types() const { return types; }
+    const Table<Il2CppMethodDefinition>& Methods() const { return methods; }
+    const Table<Il2CppFieldDefinition>& Fields() const { return fields; }
+    const Table<Il2CppPropertyDefinition>& Properties() const { return properties; }
+    const Table<Il2CppParameterDefinition>& Parameters() const { return parameters; }
+
+private:
+    template <typename Layout>
+    bool Read(const MappedFile& file);
+
+    MetadataLayoutVersion layout = MetadataLayoutVersion::V24_2;
+    Il2CppGlobalMetadataHeader header = {};
+    Table<Il2CppImageDefinition> images;
+    Table<Il2CppTypeDefinition> types;
+    Table<Il2CppMethodDefinition> methods;
+    Table<Il2CppFieldDefinition> fields;
+    Table<Il2CppPropertyDefinition> properties;
+    Table<Il2CppParameterDefinition> parameters;
+};
@@ -0,0 +1,101 @@
+#include "NameClassifier.h"
+#include <algorithm>
+
+namespace {
+
+enum : uint8_t {
+    kVowel = 1,
+    kConsonant = 2,
+    kDigit = 4,
+    kUpper = 8,
+};
+
+// Classes of every byte value, matching the C locale's isalpha, isdigit and
+// isupper; vowels are aeiou in either case
+struct CharClassTable {
+    uint8_t classes[256];
+    CharClassTable() {
+        for (int c = 0; c < 256; c++) {
+            uint8_t k = 0;
+            const int lower = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+            if (lower >= 'a' && lower <= 'z') {
+                k |= (lower == 'a' || lower == 'e' || lower == 'i' || lower == 'o' || lower == 'u') ? kVowel : kConsonant;
+            }
+            if (c >= '0' && c <= '9') k |= kDigit;
+            if (c >= 'A' && c <= 'Z') k |= kUpper;
+            classes[c] = k;
+        }
+    }
+};
+const CharClassTable kCharClass;
+
+bool HeuristicRule(const NameClassifier::Features& f) {
+    if (f.length == 0) return true;
+    // Very short names are often obfuscated
+    if (f.length <= 2 && f.letters == f.length) return true;
+    // 4+ consecutive vowels or consonants
+    if (f.vowelRun >= 4 || f.consonantRun >= 4) return true;
+    if (f.length >= 6) {
+        // Same float ratios the per-name checks used
+        const float length = static_cast<float>(f.length);
+        if (static_cast<float>(f.digits) / length > 0.3f) return true;
+        if (static_cast<float>(f.upper) / length > 0.5f && f.letters > 5) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+NameClassifier::NameClassifier() : model(HeuristicModel), heuristic(true) {}
+
+void NameClassifier::SetModel(Model replacement) {
+    heuristic = !replacement;
+    model = heuristic ? Model(HeuristicModel) : std::move(replacement);
+}
+
+void NameClassifier::Extract(std::string_view name, Features& out) {
+    uint32_t letters = 0, digits = 0, upper = 0;
+    uint32_t vowels = 0, consonants = 0, vowelRun = 0, consonantRun = 0;
+    for (unsigned char c : name) {
+        const uint8_t k = kCharClass.classes[c];
+        letters += (k & (kVowel | kConsonant)) != 0;
+        digits += (k & kDigit) != 0;
+        upper += (k & kUpper) != 0;
+        // A vowel ends a consonant run and the other way round; other
+        // characters leave both runs as they are
+        vowels = (vowels & -static_cast<uint32_t>(!(k & kConsonant))) + (k & kVowel);
+        consonants = (consonants & -static_cast<uint32_t>(!(k & kVowel))) + ((k & kConsonant) >> 1);
+        vowelRun = std::max(vowelRun, vowels);
+        consonantRun = std::max(consonantRun, consonants);
+    }
+    out.length = static_cast<uint32_t>(name.size());
+    out.letters = letters;
+    out.digits = digits;
+    out.upper = upper;
+    out.vowelRun = vowelRun;
+    out.consonantRun = consonantRun;
+}
+
+uint64_t NameClassifier::HeuristicModel(const std::string_view*, const Features* features, size_t count) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < count; i++) {
+        bits |= static_cast<uint64_t>(HeuristicRule(features[i])) << i;
+    }
+    return bits;
+}
+
+void NameClassifier::Classify(const std::string_view* names, size_t count, uint64_t* bits) const {
+    Features features[64];
+    for (size_t block = 0; block < count; block += 64) {
+        const size_t blockSize = std::min<size_t>(64, count - block);
+        for (size_t i = 0; i < blockSize; i++) Extract(names[block + i], features[i]);
+        bits[block / 64] = heuristic ? HeuristicModel(names + block, features, blockSize)
+                                     : model(names + block, features, blockSize);
+    }
+}
+
+bool NameClassifier::IsObfuscated(std::string_view name) const {
+    uint64_t bits;
+    Classify(&name, 1, &bits);
+    return bits & 1;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+// Decides which identifiers look obfuscated, a block of names at a time.
+//
+// Each name is reduced to a handful of features in one pass over its bytes,
+// driven by a 256-entry character class table (no per-byte locale calls).
+// A model then turns the features of a whole block into a bitset. The model
+// is called once per block of up to 64 names, so a replacement (an n-gram or
+// entropy model, say) costs one indirect call per block on the hot path.
+class NameClassifier {
+public:
+    // What one pass over a name collects. Letters are ASCII only; vowel and
+    // consonant runs are only broken by the other kind of letter.
+    struct Features {
+        uint32_t length;
+        uint32_t letters;
+        uint32_t digits;
+        uint32_t upper;
+        uint32_t vowelRun;        // Longest run of vowels
+        uint32_t consonantRun;    // Longest run of consonants
+    };
+
+    // Sets bit i of bits (count <= 64) for every names[i] that looks
+    // obfuscated; names are passed along for models that look past features.
+    // Symbol recovery classifies from every pool worker at once, so a model
+    // must be thread-safe and reentrant: no unguarded shared state.
+    using Model = std::function<uint64_t(const std::string_view* names, const Features* features, size_t count)>;
+
+    NameClassifier();
+
+    // An empty model restores the heuristic one
+    void SetModel(Model model);
+
+    static void Extract(std::string_view name, Features& out);
+    // The default rules: empty or one- and two-letter names, four vowels or
+    // consonants in a row, and from six characters on more than 30% digits
+    // or more than 50% upper case among more than five letters
+    static uint64_t HeuristicModel(const std::string_view* names, const Features* features, size_t count);
+
+    // Fills bits[0, (count + 63) / 64) with one bit per name, name i at bit
+    // i % 64 of word i / 64
+    void Classify(const std::string_view* names, size_t count, uint64_t* bits) const;
+    bool IsObfuscated(std::string_view name) const;
+
+private:
+    Model model;
+    bool heuristic;     // model is HeuristicModel, called directly
+};
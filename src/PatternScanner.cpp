@@ -0,0 +1,199 @@
+#include "PatternScanner.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <fstream>
+
+#if IL2CPP_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+int HexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+std::string_view Trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '\r')) text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+    return text;
+}
+
+#if IL2CPP_X86_DISPATCH
+
+// Shufti-style classifier: looks up both nibbles of 16 bytes at once and
+// returns a bit mask of the lanes that may be anchors
+IL2CPP_TARGET("ssse3")
+size_t FindAnchorSSSE3(const unsigned char* data, size_t size, size_t pos,
+                       const uint8_t* lowTable, const uint8_t* highTable, const bool* isAnchor) {
+    const __m128i low = _mm_load_si128(reinterpret_cast<const __m128i*>(lowTable));
+    const __m128i high = _mm_load_si128(reinterpret_cast<const __m128i*>(highTable));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+
+    while (pos + 16 <= size) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i lo = _mm_shuffle_epi8(low, _mm_and_si128(bytes, nibble));
+        __m128i hi = _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+        unsigned candidates = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), zero))) & 0xFFFF;
+        while (candidates) {
+            unsigned lane = static_cast<unsigned>(__builtin_ctz(candidates));
+            // The nibble tables can alias; confirm with the exact table
+            if (isAnchor[data[pos + lane]]) return pos + lane;
+            candidates &= candidates - 1;
+        }
+        pos += 16;
+    }
+    for (; pos < size; pos++) {
+        if (isAnchor[data[pos]]) return pos;
+    }
+    return size;
+}
+
+#endif
+
+} // namespace
+
+bool ByteSignature::Parse(std::string_view text, ByteSignature& out, std::string& error) {
+    out.value.clear();
+    out.mask.clear();
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+            i++;
+            continue;
+        }
+        if (i + 1 >= text.size()) {
+            error = "incomplete byte at the end of the signature";
+            return false;
+        }
+        uint8_t value = 0, mask = 0;
+        for (int n = 0; n < 2; n++) {
+            char digit = text[i + n];
+            int shift = n == 0 ? 4 : 0;
+            if (digit == '?') continue;
+            int v = HexDigit(digit);
+            if (v < 0) {
+                error = std::string("invalid character '") + digit + "' in signature";
+                return false;
+            }
+            value |= static_cast<uint8_t>(v << shift);
+            mask |= static_cast<uint8_t>(0xF << shift);
+        }
+        out.value.push_back(value);
+        out.mask.push_back(mask);
+        i += 2;
+        if (i < text.size() && text[i] != ' ' && text[i] != '\t' && text[i] != '\r' && text[i] != '\n') {
+            error = "bytes must be separated by whitespace";
+            return false;
+        }
+    }
+    if (out.value.empty()) {
+        error = "empty signature";
+        return false;
+    }
+    if (out.mask[0] == 0) {
+        error = "signature may not start with a wildcard";
+        return false;
+    }
+    return true;
+}
+
+PatternScanner::SignatureId PatternScanner::Add(ByteSignature signature) {
+    compiled = false;
+    maxLength = std::max(maxLength, signature.size());
+    signatures.push_back(std::move(signature));
+    return static_cast<SignatureId>(signatures.size() - 1);
+}
+
+PatternScanner::SignatureId PatternScanner::Add(const std::string& name, std::string_view pattern) {
+    ByteSignature signature;
+    std::string error;
+    if (!ByteSignature::Parse(pattern, signature, error)) {
+        return kInvalidSignature;
+    }
+    signature.name = name;
+    return Add(std::move(signature));
+}
+
+bool PatternScanner::LoadFile(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        std::string_view text = line;
+        size_t comment = text.find('#');
+        if (comment != std::string_view::npos) text = text.substr(0, comment);
+        text = Trim(text);
+        if (text.empty()) continue;
+
+        size_t colon = text.find(':');
+        std::string_view name = colon == std::string_view::npos ? std::string_view() : Trim(text.substr(0, colon));
+        if (name.empty()) {
+            error = path + ":" + std::to_string(lineNumber) + ": expected 'name: bytes'";
+            return false;
+        }
+        ByteSignature signature;
+        std::string parseError;
+        if (!ByteSignature::Parse(text.substr(colon + 1), signature, parseError)) {
+            error = path + ":" + std::to_string(lineNumber) + ": " + parseError;
+            return false;
+        }
+        signature.name = std::string(name);
+        Add(std::move(signature));
+    }
+    return true;
+}
+
+void PatternScanner::Compile() {
+    // Expand every anchor (which may be a nibble pattern) to the byte values
+    // it matches and bucket the signature ids by those values
+    std::vector<SignatureId> byByte[256];
+    for (SignatureId id = 0; id < signatures.size(); id++) {
+        const ByteSignature& signature = signatures[id];
+        for (int b = 0; b < 256; b++) {
+            if ((b & signature.mask[0]) == signature.value[0]) {
+                byByte[b].push_back(id);
+            }
+        }
+    }
+
+    bucketIds.clear();
+    std::fill(std::begin(lowNibbleMask), std::end(lowNibbleMask), 0);
+    std::fill(std::begin(highNibbleMask), std::end(highNibbleMask), 0);
+    for (int b = 0; b < 256; b++) {
+        bucketStart[b] = static_cast<uint32_t>(bucketIds.size());
+        bucketIds.insert(bucketIds.end(), byByte[b].begin(), byByte[b].end());
+        isAnchor[b] = !byByte[b].empty();
+        if (isAnchor[b]) {
+            // Eight classes keyed by the high nibble; nibbles h and h + 8 share
+            // a class, which only costs a false candidate now and then
+            uint8_t bit = static_cast<uint8_t>(1u << ((b >> 4) & 7));
+            lowNibbleMask[b & 15] |= bit;
+            highNibbleMask[b >> 4] |= bit;
+        }
+    }
+    bucketStart[256] = static_cast<uint32_t>(bucketIds.size());
+    compiled = true;
+}
+
+size_t PatternScanner::FindAnchor(const unsigned char* data, size_t size, size_t pos) const {
+#if IL2CPP_X86_DISPATCH
+    if (CpuHasSSSE3()) {
+        return FindAnchorSSSE3(data, size, pos, lowNibbleMask, highNibbleMask, isAnchor);
+    }
+#endif
+    for (; pos < size; pos++) {
+        if (isAnchor[data[pos]]) return pos;
+    }
+    return size;
+}
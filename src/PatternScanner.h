@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Masked byte signature in the usual hex notation, e.g.
+// "48 8B 05 ?? ?? ?? ?? 48 FF E0". "??" matches any byte; "7?" and "?F" match
+// on a single nibble. The first byte may not be a full wildcard, since it is
+// the anchor the scanner looks for.
+struct ByteSignature {
+    std::string name;
+    std::vector<uint8_t> value;
+    std::vector<uint8_t> mask;
+
+    size_t size() const { return value.size(); }
+    bool Matches(const unsigned char* data) const {
+        for (size_t i = 0; i < value.size(); i++) {
+            if ((data[i] & mask[i]) != value[i]) return false;
+        }
+        return true;
+    }
+
+    // Returns false and sets error if the text is not a valid signature
+    static bool Parse(std::string_view text, ByteSignature& out, std::string& error);
+};
+
+// Scans a buffer for any number of byte signatures in a single pass.
+//
+// Signatures are bucketed by the value of their first byte. The scan skips
+// ahead to the next byte that can start any signature (16 bytes at a time
+// with an SSSE3 nibble-table classifier where available) and only then checks
+// the signatures of that byte's bucket, so the cost is about one pass over the
+// data however many detectors are registered.
+class PatternScanner {
+public:
+    using SignatureId = uint32_t;
+    static constexpr SignatureId kInvalidSignature = 0xFFFFFFFF;
+
+    SignatureId Add(ByteSignature signature);
+    // Parses and adds; returns kInvalidSignature if the pattern is malformed
+    SignatureId Add(const std::string& name, std::string_view pattern);
+    // Reads "name: 48 8B ?? ..." lines; blank lines and '#' comments are
+    // ignored. Returns false (with a line-numbered message) on the first bad
+    // line; signatures before it are kept.
+    bool LoadFile(const std::string& path, std::string& error);
+    void Compile();
+
+    size_t Count() const { return signatures.size(); }
+    const ByteSignature& Get(SignatureId id) const { return signatures[id]; }
+    size_t MaxLength() const { return maxLength; }
+
+    // Calls onMatch(id, offset) for every match, in ascending offset order and
+    // ascending id order for matches at the same offset
+    template <typename Fn>
+    void Scan(const unsigned char* data, size_t size, Fn&& onMatch) const {
+        if (!compiled || signatures.empty()) return;
+        for (size_t pos = FindAnchor(data, size, 0); pos < size; pos = FindAnchor(data, size, pos + 1)) {
+            const size_t remaining = size - pos;
+            const uint8_t anchor = data[pos];
+            for (uint32_t i = bucketStart[anchor]; i < bucketStart[anchor + 1]; i++) {
+                const ByteSignature& signature = signatures[bucketIds[i]];
+                if (signature.size() <= remaining && signature.Matches(data + pos)) {
+                    onMatch(bucketIds[i], pos);
+                }
+            }
+        }
+    }
+
+private:
+    // Position of the first byte at or after pos that starts a signature,
+    // size if there is none
+    size_t FindAnchor(const unsigned char* data, size_t size, size_t pos) const;
+
+    std::vector<ByteSignature> signatures;
+    size_t maxLength = 0;
+    bool compiled = false;
+
+    // Signature ids by anchor byte: bucketIds[bucketStart[b] .. bucketStart[b+1])
+    uint32_t bucketStart[257] = {};
+    std::vector<SignatureId> bucketIds;
+    bool isAnchor[256] = {};
+    // Nibble tables for the vector prefilter: byte b may be an anchor if
+    // (lowNibbleMask[b & 15] & highNibbleMask[b >> 4]) != 0
+    alignas(16) uint8_t lowNibbleMask[16] = {};
+    alignas(16) uint8_t highNibbleMask[16] = {};
+};
@@ -0,0 +1,173 @@
+#include "RegistrationLocator.h"
+#include "AhoCorasick.h"
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+// Upper bound for counts read from the library; anything larger is not a
+// count but some other value that happens to sit in that word
+constexpr uint64_t kMaxPlausibleCount = 0x1000000;
+
+// Field positions, in words, within Il2CppCodeGenModule and
+// Il2CppMetadataRegistration
+constexpr uint64_t kModuleMethodPointerCount = 1;
+constexpr uint64_t kModuleMethodPointers = 2;
+constexpr uint64_t kMetadataRegistrationWords = 16;
+constexpr uint64_t kFieldOffsetsCountWord = 10;
+
+} // namespace
+
+RegistrationLocator::RegistrationLocator(const ElfImage& image, const char* data)
+    : image(image), data(data), pointerSize(image.PointerSize()) {}
+
+template <typename Fn>
+void RegistrationLocator::ForEachDataWord(Fn&& fn) const {
+    // Data ranges are file ranges and may span segments with different
+    // address deltas, so they are walked one segment at a time
+    for (const ElfImage::Segment& segment : image.GetSegments()) {
+        const uint64_t segmentEnd = segment.offset + segment.fileSize;
+        for (const ElfImage::FileRange& range : image.GetDataRanges()) {
+            uint64_t begin = std::max(range.begin, segment.offset);
+            uint64_t end = std::min(range.end, segmentEnd);
+            if (begin >= end) continue;
+            uint64_t va = segment.vaddr + (begin - segment.offset);
+            uint64_t endVa = segment.vaddr + (end - segment.offset);
+            va = (va + pointerSize - 1) & ~static_cast<uint64_t>(pointerSize - 1);
+            for (; va + pointerSize <= endVa; va += pointerSize) {
+                fn(va);
+            }
+        }
+    }
+}
+
+bool RegistrationLocator::IsMapped(uint64_t va) const {
+    uint64_t offset;
+    return va != 0 && image.VaToOffset(va, offset);
+}
+
+bool RegistrationLocator::FindCodeRegistration(const std::vector<std::string_view>& imageNames, CodeRegistrationInfo& out) const {
+    out = CodeRegistrationInfo();
+    if (!image.IsValid() || imageNames.empty()) return false;
+    const uint64_t imageCount = imageNames.size();
+
+    // 1. Every image name as a whole NUL-terminated string
+    AhoCorasick matcher;
+    std::vector<uint32_t> patternImage;
+    for (uint32_t i = 0; i < imageNames.size(); i++) {
+        if (imageNames[i].empty()) continue;
+        std::string pattern(imageNames[i]);
+        pattern.push_back('\0');
+        AhoCorasick::PatternId id = matcher.AddPattern(pattern);
+        if (id == patternImage.size()) patternImage.push_back(i);
+    }
+    matcher.Build();
+
+    std::unordered_map<uint64_t, uint32_t> nameImage;   // string VA -> image
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    for (const ElfImage::FileRange& range : image.GetDataRanges()) {
+        matcher.Scan(bytes + range.begin, range.end - range.begin, [&](AhoCorasick::PatternId id, size_t position) {
+            uint64_t offset = range.begin + position;
+            if (position != 0 && bytes[offset - 1] != 0) return;
+            uint64_t va;
+            if (image.OffsetToVa(offset, va)) nameImage.emplace(va, patternImage[id]);
+        });
+    }
+    if (nameImage.empty()) return false;
+
+    // 2. Modules: structures whose first word points at an image name
+    std::unordered_map<uint64_t, uint32_t> moduleImage; // module VA -> image
+    ForEachDataWord([&](uint64_t va) {
+        uint64_t value, count;
+        if (!ReadWord(va, value)) return;
+        auto it = nameImage.find(value);
+        if (it == nameImage.end()) return;
+        if (!ReadWord(va + kModuleMethodPointerCount * pointerSize, count) || count > kMaxPlausibleCount) return;
+        moduleImage.emplace(va, it->second);
+    });
+    if (moduleImage.empty()) return false;
+
+    // 3. The codeGenModules array: imageCount consecutive module pointers
+    std::vector<std::pair<uint64_t, uint64_t>> references;  // (where, module VA)
+    ForEachDataWord([&](uint64_t va) {
+        uint64_t value;
+        if (ReadWord(va, value) && moduleImage.count(value)) references.emplace_back(va, value);
+    });
+    std::sort(references.begin(), references.end());
+
+    size_t runStart = 0;
+    bool found = false;
+    for (size_t i = 0; i < references.size() && !found; i++) {
+        if (i > runStart && references[i].first != references[i - 1].first + pointerSize) {
+            runStart = i;
+        }
+        found = i + 1 - runStart == imageCount;
+    }
+    if (!found) return false;
+    out.codeGenModules = references[runStart].first;
+
+    out.modules.resize(imageCount);
+    for (size_t i = runStart; i < runStart + imageCount; i++) {
+        const uint64_t moduleVa = references[i].second;
+        CodeGenModuleInfo& module = out.modules[moduleImage[moduleVa]];
+        module.address = moduleVa;
+        ReadWord(moduleVa + kModuleMethodPointerCount * pointerSize, module.methodPointerCount);
+        ReadWord(moduleVa + kModuleMethodPointers * pointerSize, module.methodPointers);
+    }
+
+    // 4. The CodeRegistration field pair pointing at the array
+    ForEachDataWord([&](uint64_t va) {
+        uint64_t value, count;
+        if (out.codeGenModulesField || va < pointerSize) return;
+        if (ReadWord(va, value) && value == out.codeGenModules &&
+            ReadWord(va - pointerSize, count) && count == imageCount) {
+            out.codeGenModulesField = va - pointerSize;
+        }
+    });
+    return true;
+}
+
+bool RegistrationLocator::FindMetadataRegistration(uint64_t typeDefinitionCount, MetadataRegistrationInfo& out) const {
+    out = MetadataRegistrationInfo();
+    if (!image.IsValid() || typeDefinitionCount == 0) return false;
+
+    const uint64_t fieldOffset = kFieldOffsetsCountWord * pointerSize;
+    bool found = false;
+    ForEachDataWord([&](uint64_t va) {
+        uint64_t value;
+        if (found || va < fieldOffset) return;
+        if (!ReadWord(va, value) || value != typeDefinitionCount) return;
+
+        uint64_t words[kMetadataRegistrationWords];
+        const uint64_t base = va - fieldOffset;
+        for (uint64_t i = 0; i < kMetadataRegistrationWords; i++) {
+            if (!ReadWord(base + i * pointerSize, words[i])) return;
+        }
+        // typeDefinitionsSizesCount matches too, and the tables it sits
+        // between are real
+        if (words[12] != typeDefinitionCount) return;
+        if (!IsMapped(words[11]) || !IsMapped(words[13])) return;
+        if (words[6] == 0 || words[6] > kMaxPlausibleCount || !IsMapped(words[7])) return;
+
+        out.address = base;
+        out.genericClassesCount = words[0];
+        out.genericClasses = words[1];
+        out.genericInstsCount = words[2];
+        out.genericInsts = words[3];
+        out.genericMethodTableCount = words[4];
+        out.genericMethodTable = words[5];
+        out.typesCount = words[6];
+        out.types = words[7];
+        out.methodSpecsCount = words[8];
+        out.methodSpecs = words[9];
+        out.fieldOffsetsCount = words[10];
+        out.fieldOffsets = words[11];
+        out.typeDefinitionsSizesCount = words[12];
+        out.typeDefinitionsSizes = words[13];
+        out.metadataUsagesCount = words[14];
+        out.metadataUsages = words[15];
+        found = true;
+    });
+    return found;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "ElfImage.h"
+
+// Il2CppCodeGenModule (metadata v24.2+): the name and method pointers that
+// the runtime uses for one image. Addresses are virtual addresses.
+struct CodeGenModuleInfo {
+    uint64_t address = 0;               // 0 if the image has no module
+    uint64_t methodPointerCount = 0;
+    uint64_t methodPointers = 0;        // Indexed by method token rid - 1
+};
+
+// The part of Il2CppCodeRegistration that is the same in every version: the
+// codeGenModulesCount/codeGenModules pair at its end. The fields before it
+// differ between versions, so only the address of the pair is reported.
+struct CodeRegistrationInfo {
+    uint64_t codeGenModulesField = 0;   // VA of codeGenModulesCount, 0 if not found
+    uint64_t codeGenModules = 0;        // VA of the Il2CppCodeGenModule* array
+    std::vector<CodeGenModuleInfo> modules;  // By image index
+};
+
+// Il2CppMetadataRegistration with every count and pointer widened to 64 bits
+struct MetadataRegistrationInfo {
+    uint64_t address = 0;
+    uint64_t genericClassesCount = 0;
+    uint64_t genericClasses = 0;
+    uint64_t genericInstsCount = 0;
+    uint64_t genericInsts = 0;
+    uint64_t genericMethodTableCount = 0;
+    uint64_t genericMethodTable = 0;
+    uint64_t typesCount = 0;
+    uint64_t types = 0;
+    uint64_t methodSpecsCount = 0;
+    uint64_t methodSpecs = 0;
+    uint64_t fieldOffsetsCount = 0;
+    uint64_t fieldOffsets = 0;
+    uint64_t typeDefinitionsSizesCount = 0;
+    uint64_t typeDefinitionsSizes = 0;
+    uint64_t metadataUsagesCount = 0;
+    uint64_t metadataUsages = 0;
+};
+
+// Finds the IL2CPP registration structures in a parsed library by following
+// pointers through its data ranges, the way the runtime itself reaches them:
+//
+//  - CodeRegistration: image name strings <- Il2CppCodeGenModule::moduleName
+//    <- the codeGenModules array, a run of imageCount consecutive module
+//    pointers <- codeGenModules, preceded by codeGenModulesCount == imageCount
+//  - MetadataRegistration: fieldOffsetsCount and typeDefinitionsSizesCount
+//    two words apart, both equal to the number of type definitions
+//
+// Every step is one linear pass over the pointer-aligned words of the data
+// ranges with hashed target sets, so the cost does not depend on the number
+// of images or candidates.
+class RegistrationLocator {
+public:
+    RegistrationLocator(const ElfImage& image, const char* data);
+
+    // imageNames are the metadata image names ("mscorlib.dll", ...) in image
+    // order; out.modules is filled in the same order
+    bool FindCodeRegistration(const std::vector<std::string_view>& imageNames, CodeRegistrationInfo& out) const;
+    bool FindMetadataRegistration(uint64_t typeDefinitionCount, MetadataRegistrationInfo& out) const;
+
+private:
+    // Calls fn(va) for every pointer-aligned word in the data ranges
+    template <typename Fn> void ForEachDataWord(Fn&& fn) const;
+    bool ReadWord(uint64_t va, uint64_t& value) const { return image.ReadPointer(va, value); }
+    bool IsMapped(uint64_t va) const;
+
+    const ElfImage& image;
+    const char* data;
+    size_t pointerSize;
+};
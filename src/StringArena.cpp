@@ -0,0 +1,139 @@
+#include "StringArena.h"
+#include <cstring>
+
+StringArena::StringArena() : shards(new Shard[kShardCount]) {}
+
+StringArena::~StringArena() {}
+
+uint64_t StringArena::Hash(std::string_view value) {
+    // FNV-1a with a final avalanche so both the shard (low bits) and the
+    // table position (high bits) are well distributed
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : value) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+const char* StringArena::Store(Shard& shard, std::string_view value) {
+    uint32_t length = static_cast<uint32_t>(value.size());
+    size_t needed = sizeof(length) + value.size() + 1;
+
+    char* dst;
+    if (needed > kBlockSize / 4) {
+        // Large strings get a block of their own so they do not waste the tail
+        // of the current one
+        shard.blocks.emplace_back(new char[needed]);
+        dst = shard.blocks.back().get();
+    } else {
+        if (needed > shard.remaining) {
+            shard.blocks.emplace_back(new char[kBlockSize]);
+            shard.cursor = shard.blocks.back().get();
+            shard.remaining = kBlockSize;
+        }
+        dst = shard.cursor;
+        shard.cursor += needed;
+        shard.remaining -= needed;
+    }
+    shard.bytes += needed;
+
+    memcpy(dst, &length, sizeof(length));
+    memcpy(dst + sizeof(length), value.data(), value.size());
+    dst[sizeof(length) + value.size()] = '\0';
+    return dst;
+}
+
+void StringArena::Grow(Shard& shard) {
+    size_t newSize = shard.slots.empty() ? 256 : shard.slots.size() * 2;
+    std::vector<Slot> newSlots(newSize, Slot{0, 0});
+    size_t mask = newSize - 1;
+    for (const Slot& slot : shard.slots) {
+        if (slot.entry == 0) continue;
+        size_t pos = slot.hash & mask;
+        while (newSlots[pos].entry != 0) {
+            pos = (pos + 1) & mask;
+        }
+        newSlots[pos] = slot;
+    }
+    shard.slots.swap(newSlots);
+}
+
+StringArena::Id StringArena::Intern(std::string_view value) {
+    uint64_t hash = Hash(value);
+    unsigned shardIndex = static_cast<unsigned>(hash & (kShardCount - 1));
+    uint32_t slotHash = static_cast<uint32_t>(hash >> 32);
+    Shard& shard = shards[shardIndex];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    // Keep the load factor at or below one half
+    if ((shard.entryCount + 1) * 2 > shard.slots.size()) {
+        Grow(shard);
+    }
+
+    size_t mask = shard.slots.size() - 1;
+    size_t pos = slotHash & mask;
+    while (shard.slots[pos].entry != 0) {
+        const Slot& slot = shard.slots[pos];
+        if (slot.hash == slotHash) {
+            uint32_t local = slot.entry - 1;
+            Id id = (local << kShardBits) | shardIndex;
+            if (View(id) == value) {
+                return id;
+            }
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    uint32_t local = shard.entryCount;
+    size_t segment = local >> kSegmentBits;
+    if (segment >= kMaxSegments) {
+        return kInvalidId;
+    }
+    if (!shard.segments) {
+        shard.segments.reset(new std::unique_ptr<const char*[]>[kMaxSegments]);
+    }
+    if (!shard.segments[segment]) {
+        shard.segments[segment].reset(new const char*[kSegmentSize]);
+    }
+    shard.segments[segment][local & (kSegmentSize - 1)] = Store(shard, value);
+    shard.entryCount++;
+    shard.slots[pos] = Slot{slotHash, local + 1};
+    return (local << kShardBits) | shardIndex;
+}
+
+std::string_view StringArena::View(Id id) const {
+    if (id == kInvalidId) {
+        return std::string_view();
+    }
+    const Shard& shard = shards[id & (kShardCount - 1)];
+    uint32_t local = id >> kShardBits;
+    const char* entry = shard.segments[local >> kSegmentBits][local & (kSegmentSize - 1)];
+    uint32_t length;
+    memcpy(&length, entry, sizeof(length));
+    return std::string_view(entry + sizeof(length), length);
+}
+
+size_t StringArena::Count() const {
+    size_t count = 0;
+    for (unsigned i = 0; i < kShardCount; i++) {
+        count += shards[i].entryCount;
+    }
+    return count;
+}
+
+size_t StringArena::ByteSize() const {
+    size_t bytes = 0;
+    for (unsigned i = 0; i < kShardCount; i++) {
+        bytes += shards[i].bytes;
+    }
+    return bytes;
+}
+
+void StringArena::Clear() {
+    shards.reset(new Shard[kShardCount]);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Bump-pointer storage for generated names with a deduplicating intern table.
+//
+// Interning the same text twice yields the same id and the same characters.
+// Interned strings are NUL-terminated, never move, and are all released at once
+// when the arena is cleared or destroyed, so string_views into the arena stay
+// valid for its lifetime.
+//
+// Interning is thread-safe: strings are distributed over shards by hash, each
+// with its own lock, blocks and table. Ids handed out by Intern() can be
+// resolved with View() from any thread without locking.
+class StringArena {
+public:
+    using Id = uint32_t;
+    static constexpr Id kInvalidId = 0xFFFFFFFF;
+
+    StringArena();
+    ~StringArena();
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    Id Intern(std::string_view value);
+    std::string_view View(Id id) const;
+    std::string_view InternView(std::string_view value) { return View(Intern(value)); }
+
+    size_t Count() const;
+    size_t ByteSize() const;
+    void Clear();
+
+private:
+    static constexpr unsigned kShardBits = 3;
+    static constexpr unsigned kShardCount = 1u << kShardBits;
+    static constexpr unsigned kSegmentBits = 14;
+    static constexpr size_t kSegmentSize = size_t(1) << kSegmentBits;
+    static constexpr size_t kMaxSegments = (size_t(1) << (32 - kShardBits)) / kSegmentSize;
+    static constexpr size_t kBlockSize = 64 * 1024;
+
+    struct Slot {
+        uint32_t hash;
+        uint32_t entry;   // 1-based local entry index, 0 = empty
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        // Entry pointers (to a 4-byte length followed by the text) are kept in
+        // fixed-size segments under a fixed directory, so publishing a new entry
+        // never moves existing ones
+        std::unique_ptr<std::unique_ptr<const char*[]>[]> segments;
+        uint32_t entryCount = 0;
+        std::vector<Slot> slots;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char* cursor = nullptr;
+        size_t remaining = 0;
+        size_t bytes = 0;
+    };
+
+    static uint64_t Hash(std::string_view value);
+    const char* Store(Shard& shard, std::string_view value);
+    void Grow(Shard& shard);
+
+    std::unique_ptr<Shard[]> shards;
+};
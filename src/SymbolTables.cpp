@@ -0,0 +1,73 @@
+#include "SymbolTables.h"
+
+void IndexedStringTable::Reserve(uint32_t count) {
+    if (count <= ids.size()) return;
+    ids.resize(count, StringArena::kInvalidId);
+    present.resize((static_cast<size_t>(count) + 63) / 64, 0);
+}
+
+void IndexedStringTable::Set(uint32_t index, StringArena::Id id) {
+    if (index >= ids.size()) {
+        Reserve(index + 1);
+    }
+    uint64_t& word = present[index >> 6];
+    uint64_t bit = uint64_t(1) << (index & 63);
+    if (!(word & bit)) {
+        word |= bit;
+        presentCount++;
+    }
+    ids[index] = id;
+}
+
+void IndexedStringTable::Clear() {
+    ids.clear();
+    present.clear();
+    presentCount = 0;
+}
+
+void RecoveredSymbolTable::Reserve(uint32_t typeCount, uint32_t fieldCount, uint32_t methodCount, uint32_t propertyCount) {
+    types.Reserve(typeCount);
+    fields.Reserve(fieldCount);
+    methods.Reserve(methodCount);
+    properties.Reserve(propertyCount);
+}
+
+IndexedStringTable* RecoveredSymbolTable::TableFor(uint32_t token) {
+    return const_cast<IndexedStringTable*>(static_cast<const RecoveredSymbolTable*>(this)->TableFor(token));
+}
+
+const IndexedStringTable* RecoveredSymbolTable::TableFor(uint32_t token) const {
+    switch (token >> 24) {
+        case kTypeTable:     return &types;
+        case kFieldTable:    return &fields;
+        case kMethodTable:   return &methods;
+        case kPropertyTable: return &properties;
+        default:             return nullptr;
+    }
+}
+
+bool RecoveredSymbolTable::Set(uint32_t token, std::string_view name) {
+    IndexedStringTable* table = TableFor(token);
+    if (!table) return false;
+    table->Set(token & 0x00FFFFFF, arena.Intern(name));
+    return true;
+}
+
+bool RecoveredSymbolTable::Find(uint32_t token, std::string_view& name) const {
+    const IndexedStringTable* table = TableFor(token);
+    uint32_t index = token & 0x00FFFFFF;
+    if (!table || !table->Has(index)) return false;
+    name = arena.View(table->Get(index));
+    return true;
+}
+
+size_t RecoveredSymbolTable::Count() const {
+    return types.Count() + fields.Count() + methods.Count() + properties.Count();
+}
+
+void RecoveredSymbolTable::Clear() {
+    types.Clear();
+    fields.Clear();
+    methods.Clear();
+    properties.Clear();
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "StringArena.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+inline unsigned CountTrailingZeros64(uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+}
+
+// Dense side table for one metadata table: element index -> interned string
+// id, with a presence bitmap so that absent entries need no sentinel.
+class IndexedStringTable {
+public:
+    IndexedStringTable() : presentCount(0) {}
+
+    // Grows the table to hold at least count entries
+    void Reserve(uint32_t count);
+    void Set(uint32_t index, StringArena::Id id);
+    void Clear();
+
+    bool Has(uint32_t index) const {
+        return index < ids.size() && (present[index >> 6] >> (index & 63)) & 1;
+    }
+    StringArena::Id Get(uint32_t index) const { return ids[index]; }
+    uint32_t Size() const { return static_cast<uint32_t>(ids.size()); }
+    size_t Count() const { return presentCount; }
+
+    // Calls fn(index, id) for every present entry in index order
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (size_t word = 0; word < present.size(); word++) {
+            uint64_t bits = present[word];
+            while (bits) {
+                uint32_t index = static_cast<uint32_t>(word * 64 + CountTrailingZeros64(bits));
+                fn(index, ids[index]);
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    std::vector<StringArena::Id> ids;
+    std::vector<uint64_t> present;
+    size_t presentCount;
+};
+
+// Recovered names keyed by metadata token. Each token table the recovery
+// passes produce (0x02 types, 0x04 fields, 0x06 methods, 0x07 properties) has
+// its own dense table addressed by the token's row.
+class RecoveredSymbolTable {
+public:
+    static constexpr uint32_t kTypeTable = 0x02;
+    static constexpr uint32_t kFieldTable = 0x04;
+    static constexpr uint32_t kMethodTable = 0x06;
+    static constexpr uint32_t kPropertyTable = 0x07;
+
+    explicit RecoveredSymbolTable(StringArena& arena) : arena(arena) {}
+
+    void Reserve(uint32_t typeCount, uint32_t fieldCount, uint32_t methodCount, uint32_t propertyCount);
+    // Returns false for tokens outside the four supported tables
+    bool Set(uint32_t token, std::string_view name);
+    bool Find(uint32_t token, std::string_view& name) const;
+    size_t Count() const;
+    void Clear();
+
+    // Calls fn(token, name) for every recovered symbol in ascending token order
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        const IndexedStringTable* tables[] = {&types, &fields, &methods, &properties};
+        const uint32_t tableIds[] = {kTypeTable, kFieldTable, kMethodTable, kPropertyTable};
+        for (int t = 0; t < 4; t++) {
+            tables[t]->ForEach([&](uint32_t index, StringArena::Id id) {
+                fn((tableIds[t] << 24) | index, arena.View(id));
+            });
+        }
+    }
+
+private:
+    IndexedStringTable* TableFor(uint32_t token);
+    const IndexedStringTable* TableFor(uint32_t token) const;
+
+    StringArena& arena;
+    IndexedStringTable types;
+    IndexedStringTable fields;
+    IndexedStringTable methods;
+    IndexedStringTable properties;
+};
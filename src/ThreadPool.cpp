@@ -0,0 +1,152 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+
+// Identifies the pool and worker slot of the current thread
+thread_local const ThreadPool* tlsPool = nullptr;
+thread_local unsigned tlsWorker = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threadCount) : queuedCount(0), nextQueue(0), waiting(0), stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 1; i < threadCount; i++) {
+        threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+unsigned ThreadPool::CurrentWorker() const {
+    return tlsPool == this ? tlsWorker : 0;
+}
+
+void ThreadPool::Submit(TaskGroup& group, Task task) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+
+    // Workers keep what they spawn; the owning thread spreads tasks round-robin
+    // so that the background workers do not all start by stealing
+    unsigned target = CurrentWorker();
+    if (target == 0 && queues.size() > 1) {
+        target = nextQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<unsigned>(queues.size());
+    }
+    {
+        // Counted under the queue lock, so a thief that takes the task
+        // always decrements after this increment
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queuedCount.fetch_add(1, std::memory_order_release);
+        queues[target]->tasks.push_back({std::move(task), &group});
+    }
+    if (!threads.empty()) {
+        // Take the lock so the notification cannot slip in between a worker's
+        // queue check and its wait
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+        if (waiting > 0) helpers.notify_all();
+    }
+}
+
+bool ThreadPool::PopLocal(unsigned worker, QueuedTask& out) {
+    WorkerQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    out = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::Steal(unsigned thief, QueuedTask& out) {
+    const unsigned count = static_cast<unsigned>(queues.size());
+    for (unsigned i = 1; i < count; i++) {
+        WorkerQueue& victim = *queues[(thief + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            out = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::RunOne(unsigned worker) {
+    QueuedTask item;
+    if (!PopLocal(worker, item) && !Steal(worker, item)) {
+        return false;
+    }
+    queuedCount.fetch_sub(1, std::memory_order_relaxed);
+    item.task(worker);
+    if (item.group->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // The group is done; wake whoever waits for it
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (waiting > 0) helpers.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::WorkerLoop(unsigned worker) {
+    tlsPool = this;
+    tlsWorker = worker;
+    for (;;) {
+        if (RunOne(worker)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] {
+            return stopping || queuedCount.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping && queuedCount.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::Wait(TaskGroup& group) {
+    const unsigned worker = CurrentWorker();
+    while (!group.Done()) {
+        // Help out instead of blocking. With nothing queued, the rest of the
+        // group is running on other workers: sleep until a group finishes or
+        // new work is queued.
+        if (RunOne(worker)) continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        waiting++;
+        helpers.wait(lock, [&] { return group.Done() || queuedCount.load(std::memory_order_acquire) > 0; });
+        waiting--;
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t chunkSize,
+                             const std::function<void(size_t begin, size_t end, unsigned worker)>& fn) {
+    if (count == 0) return;
+    if (chunkSize == 0) {
+        chunkSize = std::max<size_t>(1, count / (static_cast<size_t>(GetThreadCount()) * 8));
+    }
+    if (chunkSize >= count || GetThreadCount() == 1) {
+        // Not worth queueing, but still hand out chunk-sized ranges
+        for (size_t begin = 0; begin < count; begin += chunkSize) {
+            fn(begin, std::min(count, begin + chunkSize), CurrentWorker());
+        }
+        return;
+    }
+
+    TaskGroup group;
+    for (size_t begin = 0; begin < count; begin += chunkSize) {
+        size_t end = std::min(count, begin + chunkSize);
+        Submit(group, [&fn, begin, end](unsigned worker) { fn(begin, end, worker); });
+    }
+    Wait(group);
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing thread pool.
+//
+// Every worker owns a deque: it pops its own tasks from the back and, when it
+// runs dry, steals from the front of the others. The thread that created the
+// pool counts as worker 0 and executes tasks while it waits for a group, so a
+// pool of N threads starts N - 1 background threads and a pool of one runs
+// everything inline. Waiting inside a task helps as well, which makes nested
+// ParallelFor calls safe.
+class ThreadPool {
+public:
+    using Task = std::function<void(unsigned worker)>;
+
+    // Tracks completion of a batch of submitted tasks
+    class TaskGroup {
+    public:
+        TaskGroup() : pending(0) {}
+        bool Done() const { return pending.load(std::memory_order_acquire) == 0; }
+    private:
+        friend class ThreadPool;
+        std::atomic<size_t> pending;
+    };
+
+    // threadCount == 0 uses the number of hardware threads
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of workers, including the calling thread. Worker ids passed to
+    // tasks are in [0, GetThreadCount()).
+    unsigned GetThreadCount() const { return static_cast<unsigned>(queues.size()); }
+
+    void Submit(TaskGroup& group, Task task);
+    void Wait(TaskGroup& group);
+
+    // Calls fn(begin, end, worker) for consecutive chunks of [0, count) and
+    // returns once all of them have run. chunkSize == 0 picks a size that gives
+    // every worker several chunks to balance uneven work.
+    void ParallelFor(size_t count, size_t chunkSize,
+                     const std::function<void(size_t begin, size_t end, unsigned worker)>& fn);
+
+private:
+    struct QueuedTask {
+        Task task;
+        TaskGroup* group;
+    };
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<QueuedTask> tasks;
+    };
+
+    void WorkerLoop(unsigned worker);
+    bool RunOne(unsigned worker);
+    bool PopLocal(unsigned worker, QueuedTask& out);
+    bool Steal(unsigned thief, QueuedTask& out);
+    unsigned CurrentWorker() const;
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queuedCount;
+    std::atomic<unsigned> nextQueue;
+    std::mutex sleepMutex;
+    std::condition_variable wake;       // Idle workers: a task was queued
+    std::condition_variable helpers;    // Wait(): a task was queued or a group finished
+    unsigned waiting;                   // Threads blocked in Wait(), under sleepMutex
+    bool stopping;
+};
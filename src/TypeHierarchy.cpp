@@ -0,0 +1,156 @@
+#include "TypeHierarchy.h"
+#include <algorithm>
+
+namespace {
+
+// Turns per-type counts (in start[1..typeCount]) into CSR offsets and
+// returns the total
+uint32_t PrefixSum(std::vector<uint32_t>& start) {
+    for (size_t i = 1; i < start.size(); i++) start[i] += start[i - 1];
+    return start.back();
+}
+
+// CSR lists of the types that point at each target through link: the
+// children of each parent, the nested types of each declaring type
+void BuildReverse(const std::vector<TypeDefinitionIndex>& link, std::vector<uint32_t>& start,
+                  std::vector<TypeDefinitionIndex>& list) {
+    start.assign(link.size() + 1, 0);
+    for (TypeDefinitionIndex target : link) {
+        if (target != TypeHierarchy::kNoType) start[target + 1]++;
+    }
+    list.resize(PrefixSum(start));
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (TypeDefinitionIndex type = 0; type < link.size(); type++) {
+        if (link[type] != TypeHierarchy::kNoType) list[fill[link[type]]++] = type;
+    }
+}
+
+} // namespace
+
+void TypeHierarchy::Build(const Tables& tables, const std::vector<std::pair<TypeIndex, TypeDefinitionIndex>>& extraTypes) {
+    Clear();
+    const size_t typeCount = tables.types ? tables.typeCount : 0;
+    if (typeCount == 0) return;
+
+    // TypeIndex -> definition, through each definition's own byval type
+    typeIndex.reserve(typeCount + extraTypes.size());
+    for (TypeDefinitionIndex type = 0; type < typeCount; type++) {
+        const TypeIndex byval = tables.types[type].byvalTypeIndex;
+        if (byval != static_cast<TypeIndex>(kMetadataInvalidPointer)) typeIndex.emplace_back(byval, type);
+    }
+    for (const auto& extra : extraTypes) {
+        if (extra.second < typeCount) typeIndex.push_back(extra);
+    }
+    std::stable_sort(typeIndex.begin(), typeIndex.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    typeIndex.erase(std::unique(typeIndex.begin(), typeIndex.end(),
+                                [](const auto& a, const auto& b) { return a.first == b.first; }),
+                    typeIndex.end());
+
+    // Parents
+    parents.assign(typeCount, kNoType);
+    for (TypeDefinitionIndex type = 0; type < typeCount; type++) {
+        const TypeIndex parent = tables.types[type].parentIndex;
+        if (parent == static_cast<TypeIndex>(kMetadataInvalidPointer)) continue;
+        const TypeDefinitionIndex resolved = Resolve(parent);
+        if (resolved != kNoType && resolved != type) {
+            parents[type] = resolved;
+            resolvedParents++;
+        } else {
+            unresolvedParents++;
+        }
+    }
+    BuildReverse(parents, childStart, children);
+
+    // Declaring types: from the nested types table, which lists definition
+    // indices directly, then from declaringTypeIndex for types it misses
+    declaringTypes.assign(typeCount, kNoType);
+    for (TypeDefinitionIndex type = 0; type < typeCount; type++) {
+        const Il2CppTypeDefinition& definition = tables.types[type];
+        const size_t first = definition.nestedTypesStart;
+        if (definition.nested_type_count == 0 || first >= tables.nestedTypeCount ||
+            tables.nestedTypeCount - first < definition.nested_type_count) {
+            continue;
+        }
+        for (size_t i = first; i < first + definition.nested_type_count; i++) {
+            const TypeDefinitionIndex nestedType = tables.nestedTypes[i];
+            if (nestedType < typeCount && nestedType != type && declaringTypes[nestedType] == kNoType) {
+                declaringTypes[nestedType] = type;
+            }
+        }
+    }
+    for (TypeDefinitionIndex type = 0; type < typeCount; type++) {
+        const TypeIndex declaring = tables.types[type].declaringTypeIndex;
+        if (declaringTypes[type] != kNoType || declaring == static_cast<TypeIndex>(kMetadataInvalidPointer)) continue;
+        const TypeDefinitionIndex resolved = Resolve(declaring);
+        if (resolved != type) declaringTypes[type] = resolved;
+    }
+    BuildReverse(declaringTypes, nestedStart, nested);
+
+    // Implemented interfaces, and the reverse
+    interfaceStart.assign(typeCount + 1, 0);
+    for (int pass = 0; pass < 2; pass++) {
+        for (TypeDefinitionIndex type = 0; type < typeCount; type++) {
+            const Il2CppTypeDefinition& definition = tables.types[type];
+            const size_t first = definition.interfacesStart;
+            if (definition.interfaces_count == 0 || first >= tables.interfaceCount ||
+                tables.interfaceCount - first < definition.interfaces_count) {
+                continue;
+            }
+            uint32_t written = 0;
+            for (size_t i = first; i < first + definition.interfaces_count; i++) {
+                const TypeDefinitionIndex resolved = Resolve(tables.interfaces[i]);
+                if (resolved == kNoType || resolved == type) continue;
+                if (pass == 1) interfaces[interfaceStart[type] + written] = resolved;
+                written++;
+            }
+            if (pass == 0) interfaceStart[type + 1] = written;
+        }
+        if (pass == 0) interfaces.resize(PrefixSum(interfaceStart));
+    }
+    implementerStart.assign(typeCount + 1, 0);
+    for (TypeDefinitionIndex iface : interfaces) implementerStart[iface + 1]++;
+    implementers.resize(PrefixSum(implementerStart));
+    std::vector<uint32_t> fill(implementerStart.begin(), implementerStart.end() - 1);
+    for (TypeDefinitionIndex type = 0; type < typeCount; type++) {
+        for (TypeDefinitionIndex iface : Interfaces(type)) implementers[fill[iface]++] = type;
+    }
+}
+
+void TypeHierarchy::Clear() {
+    for (std::vector<uint32_t>* list : {&parents, &declaringTypes, &childStart, &children, &nestedStart, &nested,
+                                        &interfaceStart, &interfaces, &implementerStart, &implementers}) {
+        list->clear();
+        list->shrink_to_fit();
+    }
+    typeIndex.clear();
+    typeIndex.shrink_to_fit();
+    resolvedParents = 0;
+    unresolvedParents = 0;
+}
+
+size_t TypeHierarchy::MemoryUsage() const {
+    size_t total = typeIndex.capacity() * sizeof(typeIndex[0]);
+    for (const std::vector<uint32_t>* list : {&parents, &declaringTypes, &childStart, &children, &nestedStart, &nested,
+                                              &interfaceStart, &interfaces, &implementerStart, &implementers}) {
+        total += list->capacity() * sizeof(uint32_t);
+    }
+    return total;
+}
+
+TypeDefinitionIndex TypeHierarchy::Resolve(TypeIndex type) const {
+    auto it = std::lower_bound(typeIndex.begin(), typeIndex.end(), type,
+                               [](const std::pair<TypeIndex, TypeDefinitionIndex>& entry, TypeIndex value) {
+                                   return entry.first < value;
+                               });
+    return it != typeIndex.end() && it->first == type ? it->second : kNoType;
+}
+
+bool TypeHierarchy::IsSubclassOf(TypeDefinitionIndex type, TypeDefinitionIndex base) const {
+    if (base >= parents.size()) return false;
+    for (size_t depth = 0; depth < parents.size() && type < parents.size(); depth++) {
+        type = parents[type];
+        if (type == base) return true;
+    }
+    return false;
+}
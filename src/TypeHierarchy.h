@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "il2cpp_structs.h"
+
+// Parent/child, declaring/nested and interface adjacency over the type
+// definitions, built once after load. Each relation is stored in CSR form
+// (an offsets array of typeCount + 1 entries and one flat list), so the
+// neighbours of a type are a contiguous range and every query costs
+// O(degree) instead of a scan over the type table.
+//
+// parentIndex, declaringTypeIndex and the interfaces table hold TypeIndex
+// values (indices into the runtime's Il2CppType table), not definition
+// indices. A type definition's own TypeIndex is its byvalTypeIndex, so a
+// reference to a plain class resolves through the byval indices; references
+// to generic instances (class A : B<int>) only resolve once a TypeIndex
+// resolver from the library's type table is supplied.
+class TypeHierarchy {
+public:
+    static constexpr TypeDefinitionIndex kNoType = 0xFFFFFFFF;
+
+    // A contiguous run of type definition indices
+    struct Range {
+        const TypeDefinitionIndex* first;
+        const TypeDefinitionIndex* last;
+
+        const TypeDefinitionIndex* begin() const { return first; }
+        const TypeDefinitionIndex* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+    };
+
+    // The metadata tables the hierarchy is built from; counts are element
+    // counts and out-of-range references are ignored
+    struct Tables {
+        const Il2CppTypeDefinition* types = nullptr;
+        size_t typeCount = 0;
+        const TypeDefinitionIndex* nestedTypes = nullptr;
+        size_t nestedTypeCount = 0;
+        const TypeIndex* interfaces = nullptr;
+        size_t interfaceCount = 0;
+    };
+
+    // extraTypes maps TypeIndex values that are not a definition's byval
+    // type (generic instances) to the definition they instantiate
+    void Build(const Tables& tables, const std::vector<std::pair<TypeIndex, TypeDefinitionIndex>>& extraTypes = {});
+    void Clear();
+
+    bool IsEmpty() const { return parents.empty(); }
+    size_t TypeCount() const { return parents.size(); }
+    size_t ResolvedParentCount() const { return resolvedParents; }
+    size_t UnresolvedParentCount() const { return unresolvedParents; }
+    size_t NestedLinkCount() const { return nested.size(); }
+    size_t InterfaceLinkCount() const { return interfaces.size(); }
+    size_t MemoryUsage() const;
+
+    // Definition a TypeIndex refers to, kNoType if unknown
+    TypeDefinitionIndex Resolve(TypeIndex type) const;
+
+    TypeDefinitionIndex Parent(TypeDefinitionIndex type) const { return type < parents.size() ? parents[type] : kNoType; }
+    TypeDefinitionIndex DeclaringType(TypeDefinitionIndex type) const {
+        return type < declaringTypes.size() ? declaringTypes[type] : kNoType;
+    }
+    // Direct subclasses
+    Range Children(TypeDefinitionIndex type) const { return Slice(childStart, children, type); }
+    Range NestedTypes(TypeDefinitionIndex type) const { return Slice(nestedStart, nested, type); }
+    // Interfaces a type declares that it implements (resolved ones only)
+    Range Interfaces(TypeDefinitionIndex type) const { return Slice(interfaceStart, interfaces, type); }
+    // Types that declare an interface
+    Range Implementers(TypeDefinitionIndex type) const { return Slice(implementerStart, implementers, type); }
+
+    // Whether base is a proper ancestor of type; O(depth)
+    bool IsSubclassOf(TypeDefinitionIndex type, TypeDefinitionIndex base) const;
+
+    // Calls fn(type) for every transitive subclass of base, parents before
+    // their children; O(number of subclasses)
+    template <typename Fn>
+    void ForEachSubclass(TypeDefinitionIndex base, Fn&& fn) const {
+        if (base >= parents.size()) return;
+        std::vector<TypeDefinitionIndex> stack(Children(base).begin(), Children(base).end());
+        // A malformed file can make the parent links cyclic; no type is
+        // visited more often than there are types
+        for (size_t visited = 0; !stack.empty() && visited < parents.size(); visited++) {
+            const TypeDefinitionIndex type = stack.back();
+            stack.pop_back();
+            fn(type);
+            const Range next = Children(type);
+            stack.insert(stack.end(), next.begin(), next.end());
+        }
+    }
+
+private:
+    static Range Slice(const std::vector<uint32_t>& start, const std::vector<TypeDefinitionIndex>& list,
+                       TypeDefinitionIndex type) {
+        if (start.empty() || type >= start.size() - 1) return Range{nullptr, nullptr};
+        return Range{list.data() + start[type], list.data() + start[type + 1]};
+    }
+
+    std::vector<std::pair<TypeIndex, TypeDefinitionIndex>> typeIndex;  // Sorted by TypeIndex
+    std::vector<TypeDefinitionIndex> parents;           // By type, kNoType for roots
+    std::vector<TypeDefinitionIndex> declaringTypes;
+    std::vector<uint32_t> childStart;
+    std::vector<TypeDefinitionIndex> children;
+    std::vector<uint32_t> nestedStart;
+    std::vector<TypeDefinitionIndex> nested;
+    std::vector<uint32_t> interfaceStart;
+    std::vector<TypeDefinitionIndex> interfaces;
+    std::vector<uint32_t> implementerStart;
+    std::vector<TypeDefinitionIndex> implementers;
+    size_t resolvedParents = 0;
+    size_t unresolvedParents = 0;
+};
@@ -0,0 +1,422 @@
+#include "TypeTable.h"
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include "BufferedWriter.h"
+#include "ElfImage.h"
+#include "RegistrationLocator.h"
+
+namespace {
+
+// Bounds against a corrupt registration or type graph
+constexpr uint64_t kMaxRegisteredRecords = 1u << 24;
+constexpr size_t kMaxAppendedTypes = 1u << 20;
+constexpr uint32_t kMaxTypeArguments = 64;
+// Nested instances can double a name's length at every level; longer names
+// are cut short with "..."
+constexpr size_t kMaxNameLength = 2048;
+
+// Il2CppType bitfield: attrs:16, type:8, then num_mods and the flags. From
+// v27.2 num_mods lost a bit to a trailing valuetype flag, moving byref down.
+constexpr unsigned kByrefBitOld = 30;
+constexpr unsigned kByrefBitNew = 29;
+constexpr uint32_t kValueTypeBitNew = 1u << 31;
+
+Il2CppTypeEnum TypeOf(uint32_t bits) { return static_cast<Il2CppTypeEnum>((bits >> 16) & 0xFF); }
+
+// C# keyword (or corlib name) of each primitive type, nullptr otherwise
+const char* PrimitiveName(Il2CppTypeEnum type) {
+    switch (type) {
+    case IL2CPP_TYPE_VOID: return "void";
+    case IL2CPP_TYPE_BOOLEAN: return "bool";
+    case IL2CPP_TYPE_CHAR: return "char";
+    case IL2CPP_TYPE_I1: return "sbyte";
+    case IL2CPP_TYPE_U1: return "byte";
+    case IL2CPP_TYPE_I2: return "short";
+    case IL2CPP_TYPE_U2: return "ushort";
+    case IL2CPP_TYPE_I4: return "int";
+    case IL2CPP_TYPE_U4: return "uint";
+    case IL2CPP_TYPE_I8: return "long";
+    case IL2CPP_TYPE_U8: return "ulong";
+    case IL2CPP_TYPE_R4: return "float";
+    case IL2CPP_TYPE_R8: return "double";
+    case IL2CPP_TYPE_STRING: return "string";
+    case IL2CPP_TYPE_TYPEDBYREF: return "TypedReference";
+    case IL2CPP_TYPE_I: return "IntPtr";
+    case IL2CPP_TYPE_U: return "UIntPtr";
+    case IL2CPP_TYPE_FNPTR: return "IntPtr";
+    case IL2CPP_TYPE_OBJECT: return "object";
+    default: return nullptr;
+    }
+}
+
+// Structure of an entry once its parts are canonical
+struct TypeKey {
+    uint32_t type;
+    uint32_t data;
+    uint32_t extra;
+
+    bool operator==(const TypeKey& other) const {
+        return type == other.type && data == other.data && extra == other.extra;
+    }
+};
+
+struct TypeKeyHash {
+    size_t operator()(const TypeKey& key) const {
+        uint64_t hash = (uint64_t(key.type) << 32 | key.data) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>((hash ^ (hash >> 29) ^ key.extra) * 0xBF58476D1CE4E5B9ull);
+    }
+};
+
+uint64_t HashArguments(const std::vector<TypeIndex>& arguments) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (TypeIndex argument : arguments) hash = (hash ^ argument) * 0x100000001B3ull;
+    return hash;
+}
+
+} // namespace
+
+bool TypeTable::Decode(const ElfImage& image, const MetadataRegistrationInfo& registration, int32_t metadataVersion) {
+    Clear();
+    if (!image.IsValid() || !registration.types || registration.typesCount == 0 ||
+        registration.typesCount > kMaxRegisteredRecords) {
+        return false;
+    }
+    const uint64_t pointerSize = image.PointerSize();
+    const size_t count = static_cast<size_t>(registration.typesCount);
+
+    // Address of every entry; the registration lists pointers to them
+    std::vector<uint64_t> addresses(count, 0);
+    std::unordered_map<uint64_t, TypeIndex> byAddress;
+    byAddress.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        if (!image.ReadPointer(registration.types + i * pointerSize, addresses[i]) || addresses[i] == 0) continue;
+        byAddress.emplace(addresses[i], static_cast<TypeIndex>(i));
+    }
+
+    // v27 metadata covers both bitfield layouts; only the newer one sets the
+    // valuetype flag, on every VALUETYPE entry
+    bool newLayout = metadataVersion >= 29;
+    if (metadataVersion >= 27 && !newLayout) {
+        for (size_t i = 0; i < count && !newLayout; i++) {
+            uint32_t bits;
+            newLayout = addresses[i] && image.Read32(addresses[i] + pointerSize, bits) &&
+                        TypeOf(bits) == IL2CPP_TYPE_VALUETYPE && (bits & kValueTypeBitNew);
+        }
+    }
+    const unsigned byrefBit = newLayout ? kByrefBitNew : kByrefBitOld;
+
+    entries.resize(count);
+    registeredCount = count;
+    // Index of the entry at an address, appended if the table lacks it
+    auto intern = [&](uint64_t address) -> TypeIndex {
+        if (address == 0) return kNone;
+        auto found = byAddress.find(address);
+        if (found != byAddress.end()) return found->second;
+        if (entries.size() - count >= kMaxAppendedTypes) return kNone;
+        const TypeIndex index = static_cast<TypeIndex>(entries.size());
+        byAddress.emplace(address, index);
+        addresses.push_back(address);
+        entries.emplace_back();
+        return index;
+    };
+
+    // Argument lists (Il2CppGenericInst: type_argc, type_argv) by address;
+    // generic classes point at the same records as the registration's list
+    std::unordered_map<uint64_t, uint32_t> instanceByAddress;
+    auto internInstance = [&](uint64_t address) -> uint32_t {
+        if (address == 0) return kNone;
+        auto found = instanceByAddress.find(address);
+        if (found != instanceByAddress.end()) return found->second;
+        uint32_t argc;
+        uint64_t argv;
+        if (!image.Read32(address, argc) || !image.ReadPointer(address + pointerSize, argv) || argc > kMaxTypeArguments) {
+            return kNone;
+        }
+        GenericInstance instance;
+        instance.first = static_cast<uint32_t>(arguments.size());
+        instance.count = argc;
+        for (uint32_t a = 0; a < argc; a++) {
+            uint64_t argument;
+            arguments.push_back(image.ReadPointer(argv + a * pointerSize, argument) ? intern(argument) : kNone);
+        }
+        const uint32_t id = static_cast<uint32_t>(instances.size());
+        instances.push_back(instance);
+        instanceByAddress.emplace(address, id);
+        return id;
+    };
+
+    // The registration's argument lists, indexed by the method specs. Read
+    // before the types so that the argument types they append get decoded.
+    std::vector<uint32_t> registeredInstances;
+    if (registration.genericInsts && registration.genericInstsCount <= kMaxRegisteredRecords) {
+        registeredInstances.resize(static_cast<size_t>(registration.genericInstsCount), kNone);
+        for (size_t i = 0; i < registeredInstances.size(); i++) {
+            uint64_t address;
+            if (image.ReadPointer(registration.genericInsts + i * pointerSize, address)) {
+                registeredInstances[i] = internInstance(address);
+            }
+        }
+        registeredInstanceCount = registeredInstances.size();
+    }
+
+    // Il2CppMethodSpec: methodDefinitionIndex, classIndexIndex and
+    // methodIndexIndex, each an int32 with -1 for none
+    if (registration.methodSpecs && registration.methodSpecsCount <= kMaxRegisteredRecords) {
+        auto instanceAt = [&](uint32_t index) { return index < registeredInstances.size() ? registeredInstances[index] : kNone; };
+        methodSpecs.reserve(static_cast<size_t>(registration.methodSpecsCount));
+        for (uint64_t i = 0; i < registration.methodSpecsCount; i++) {
+            uint32_t method, classIndex, methodIndex;
+            const uint64_t address = registration.methodSpecs + i * 3 * sizeof(uint32_t);
+            if (!image.Read32(address, method) || !image.Read32(address + 4, classIndex) ||
+                !image.Read32(address + 8, methodIndex)) {
+                break;
+            }
+            MethodSpec spec;
+            spec.method = method;
+            spec.classInstance = instanceAt(classIndex);
+            spec.methodInstance = instanceAt(methodIndex);
+            methodSpecs.push_back(spec);
+        }
+    }
+
+    // From v27 a generic class names its definition by type rather than by
+    // index; resolved once every entry is decoded
+    std::vector<std::pair<TypeIndex, TypeIndex>> genericTypes;
+    for (size_t i = 0; i < entries.size(); i++) {
+        uint64_t data;
+        uint32_t bits;
+        if (!addresses[i] || !image.ReadPointer(addresses[i], data) || !image.Read32(addresses[i] + pointerSize, bits)) {
+            continue;
+        }
+        Entry entry;
+        entry.attrs = static_cast<uint16_t>(bits & 0xFFFF);
+        entry.type = TypeOf(bits);
+        entry.byref = (bits >> byrefBit) & 1;
+        switch (entry.type) {
+        case IL2CPP_TYPE_CLASS:
+        case IL2CPP_TYPE_VALUETYPE:
+        case IL2CPP_TYPE_VAR:
+        case IL2CPP_TYPE_MVAR:
+            entry.data = static_cast<uint32_t>(data);
+            break;
+        case IL2CPP_TYPE_PTR:
+        case IL2CPP_TYPE_SZARRAY:
+            entry.data = intern(data);
+            break;
+        case IL2CPP_TYPE_ARRAY: {
+            // Il2CppArrayType: element type, then the rank byte
+            uint64_t element;
+            uint32_t rank;
+            if (image.ReadPointer(data, element) && image.Read32(data + pointerSize, rank)) {
+                entry.data = intern(element);
+                entry.extra = rank & 0xFF;
+            }
+            break;
+        }
+        case IL2CPP_TYPE_GENERICINST: {
+            // Il2CppGenericClass: the definition, then the class_inst of its
+            // context
+            uint64_t definition, instance;
+            if (metadataVersion >= 27) {
+                if (image.ReadPointer(data, definition)) genericTypes.emplace_back(static_cast<TypeIndex>(i), intern(definition));
+            } else {
+                uint32_t index;
+                if (image.Read32(data, index)) entry.data = index;
+            }
+            entry.extra = image.ReadPointer(data + pointerSize, instance) ? internInstance(instance) : kNone;
+            break;
+        }
+        default:
+            break;
+        }
+        entries[i] = entry;
+    }
+
+    for (const auto& generic : genericTypes) {
+        const Entry* definition = Get(generic.second);
+        if (definition && (definition->type == IL2CPP_TYPE_CLASS || definition->type == IL2CPP_TYPE_VALUETYPE)) {
+            entries[generic.first].data = definition->data;
+        }
+    }
+    Canonicalize();
+    return true;
+}
+
+void TypeTable::Canonicalize() {
+    const size_t count = entries.size();
+    canonical.assign(count, kNone);
+    auto canonicalOf = [&](TypeIndex type) { return type < count && canonical[type] != kNone ? canonical[type] : type; };
+
+    // Argument lists are compared by their canonical argument types
+    std::vector<uint32_t> instanceMap(instances.size(), kNone);
+    std::vector<GenericInstance> uniqueInstances;
+    std::vector<TypeIndex> uniqueArguments;
+    std::unordered_multimap<uint64_t, uint32_t> instanceByHash;
+    std::vector<TypeIndex> key;
+    auto canonicalInstance = [&](uint32_t raw) -> uint32_t {
+        if (raw >= instances.size()) return kNone;
+        if (instanceMap[raw] != kNone) return instanceMap[raw];
+        const GenericInstance& instance = instances[raw];
+        key.assign(arguments.begin() + instance.first, arguments.begin() + instance.first + instance.count);
+        for (TypeIndex& argument : key) argument = canonicalOf(argument);
+        const uint64_t hash = HashArguments(key);
+        auto range = instanceByHash.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            const GenericInstance& unique = uniqueInstances[it->second];
+            if (unique.count == key.size() &&
+                std::equal(key.begin(), key.end(), uniqueArguments.begin() + unique.first)) {
+                return instanceMap[raw] = it->second;
+            }
+        }
+        GenericInstance unique;
+        unique.first = static_cast<uint32_t>(uniqueArguments.size());
+        unique.count = instance.count;
+        uniqueArguments.insert(uniqueArguments.end(), key.begin(), key.end());
+        const uint32_t id = static_cast<uint32_t>(uniqueInstances.size());
+        uniqueInstances.push_back(unique);
+        instanceByHash.emplace(hash, id);
+        return instanceMap[raw] = id;
+    };
+
+    // Bottom-up, so the parts of an entry are canonical when its own key is
+    // built; entries that failed to decode are kept apart
+    std::unordered_map<TypeKey, TypeIndex, TypeKeyHash> byKey;
+    byKey.reserve(count);
+    size_t undecoded = 0;
+    ForEachBottomUp([&](TypeIndex index) {
+        Entry& entry = entries[index];
+        if (entry.type == IL2CPP_TYPE_PTR || entry.type == IL2CPP_TYPE_SZARRAY || entry.type == IL2CPP_TYPE_ARRAY) {
+            entry.data = canonicalOf(entry.data);
+        } else if (entry.type == IL2CPP_TYPE_GENERICINST) {
+            entry.extra = canonicalInstance(entry.extra);
+        }
+        if (entry.type == IL2CPP_TYPE_END) {
+            canonical[index] = index;
+            undecoded++;
+            return;
+        }
+        canonical[index] = byKey.emplace(TypeKey{entry.type, entry.data, entry.extra}, index).first->second;
+    });
+    for (MethodSpec& spec : methodSpecs) {
+        spec.classInstance = canonicalInstance(spec.classInstance);
+        spec.methodInstance = canonicalInstance(spec.methodInstance);
+    }
+
+    instances = std::move(uniqueInstances);
+    arguments = std::move(uniqueArguments);
+    canonicalCount = byKey.size() + undecoded;
+}
+
+void TypeTable::Clear() {
+    entries = std::vector<Entry>();
+    canonical = std::vector<TypeIndex>();
+    instances = std::vector<GenericInstance>();
+    arguments = std::vector<TypeIndex>();
+    methodSpecs = std::vector<MethodSpec>();
+    registeredCount = 0;
+    registeredInstanceCount = 0;
+    canonicalCount = 0;
+}
+
+size_t TypeTable::MemoryUsage() const {
+    return entries.capacity() * sizeof(Entry) + canonical.capacity() * sizeof(TypeIndex) +
+           instances.capacity() * sizeof(GenericInstance) + arguments.capacity() * sizeof(TypeIndex) +
+           methodSpecs.capacity() * sizeof(MethodSpec);
+}
+
+void TypeNameCache::Build(const TypeTable& table, const DefinitionNamer& definitionName,
+                          const ParameterNamer& parameterName) {
+    Clear();
+    const size_t count = table.Count();
+    names.assign(count, StringArena::kInvalidId);
+    instanceNames.assign(table.InstanceCount(), StringArena::kInvalidId);
+
+    std::string text, argumentText;
+    TextBuffer part;
+    auto appendType = [&](std::string& out, TypeIndex type) {
+        const std::string_view name = Name(type);
+        out.append(name.empty() ? std::string_view("?") : name);
+    };
+    auto intern = [&](std::string& name) {
+        if (name.size() > kMaxNameLength) {
+            name.resize(kMaxNameLength);
+            name.append("...");
+        }
+        return arena.Intern(name);
+    };
+    // Argument lists are rendered on first use, after their argument types
+    auto instanceName = [&](uint32_t id) -> std::string_view {
+        const TypeTable::GenericInstance* instance = table.GetInstance(id);
+        if (!instance) return "<?>";
+        if (instanceNames[id] == StringArena::kInvalidId) {
+            argumentText.assign(1, '<');
+            for (uint32_t i = 0; i < instance->count; i++) {
+                if (i) argumentText.append(", ");
+                appendType(argumentText, table.Arguments(*instance)[i]);
+            }
+            argumentText.push_back('>');
+            instanceNames[id] = intern(argumentText);
+        }
+        return arena.View(instanceNames[id]);
+    };
+
+    // Only canonical entries are rendered; their parts are canonical too
+    table.ForEachBottomUp([&](TypeIndex index) {
+        if (table.Canonical(index) != index) return;
+        const TypeTable::Entry& entry = *table.Get(index);
+        text.clear();
+        if (const char* primitive = PrimitiveName(entry.type)) {
+            text.append(primitive);
+        } else {
+            switch (entry.type) {
+            case IL2CPP_TYPE_CLASS:
+            case IL2CPP_TYPE_VALUETYPE:
+                part.Clear();
+                definitionName(part, entry.data, false);
+                text.append(part.View());
+                break;
+            case IL2CPP_TYPE_VAR:
+            case IL2CPP_TYPE_MVAR:
+                part.Clear();
+                parameterName(part, entry.data);
+                text.append(part.View());
+                break;
+            case IL2CPP_TYPE_PTR:
+                appendType(text, entry.data);
+                text.push_back('*');
+                break;
+            case IL2CPP_TYPE_SZARRAY:
+                appendType(text, entry.data);
+                text.append("[]");
+                break;
+            case IL2CPP_TYPE_ARRAY:
+                appendType(text, entry.data);
+                text.push_back('[');
+                text.append(entry.extra > 1 ? entry.extra - 1 : 0, ',');
+                text.push_back(']');
+                break;
+            case IL2CPP_TYPE_GENERICINST:
+                part.Clear();
+                definitionName(part, entry.data, true);
+                text.append(part.Size() ? part.View() : std::string_view("?"));
+                text.append(instanceName(entry.extra));
+                break;
+            default:
+                break;
+            }
+        }
+        names[index] = intern(text);
+    });
+    for (TypeIndex index = 0; index < count; index++) {
+        const TypeIndex canonical = table.Canonical(index);
+        if (canonical != index && canonical < count) names[index] = names[canonical];
+    }
+    for (uint32_t id = 0; id < instanceNames.size(); id++) instanceName(id);
+}
+
+void TypeNameCache::Clear() {
+    names = std::vector<StringArena::Id>();
+    instanceNames = std::vector<StringArena::Id>();
+    arena.Clear();
+}
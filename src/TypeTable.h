@@ -0,0 +1,174 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "il2cpp_structs.h"
+#include "StringArena.h"
+
+class ElfImage;
+class TextBuffer;
+struct MetadataRegistrationInfo;
+
+// The runtime's Il2CppType table (MetadataRegistration.types), decoded from
+// the library into flat entries. Metadata refers to types by TypeIndex, an
+// index into this table.
+//
+// Element types of pointers and arrays, generic definitions and generic
+// arguments are referenced by address rather than by index; the ones that
+// are not themselves in the table are appended after it, so every reference
+// between entries is a TypeIndex.
+//
+// Types and generic argument lists are hash-consed after decoding: every
+// structurally equal type maps to one canonical entry, and every distinct
+// argument list (<int>, <string, List<int>>) is stored once however many
+// types and method specs use it. References between entries point at
+// canonical entries.
+class TypeTable {
+public:
+    static constexpr uint32_t kNone = 0xFFFFFFFF;
+
+    struct Entry {
+        Il2CppTypeEnum type = IL2CPP_TYPE_END;
+        bool byref = false;
+        uint16_t attrs = 0;
+        // CLASS/VALUETYPE: TypeDefinitionIndex; VAR/MVAR: GenericParameterIndex;
+        // PTR/SZARRAY/ARRAY: element TypeIndex; GENERICINST: the generic
+        // TypeDefinitionIndex
+        uint32_t data = kNone;
+        // ARRAY: rank; GENERICINST: the instance id of its type arguments
+        uint32_t extra = 0;
+    };
+
+    // A distinct list of generic arguments, a range of Arguments()
+    struct GenericInstance {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    // Il2CppMethodSpec: a generic method, or a method of a generic type,
+    // with its argument lists as instance ids (kNone where not generic)
+    struct MethodSpec {
+        MethodIndex method = kNone;
+        uint32_t classInstance = kNone;
+        uint32_t methodInstance = kNone;
+    };
+
+    // Decodes the table, the generic instances and the method specs of a
+    // library whose metadata has the given version (the Il2CppType bitfield
+    // and Il2CppGenericClass changed in v27)
+    bool Decode(const ElfImage& image, const MetadataRegistrationInfo& registration, int32_t metadataVersion);
+    void Clear();
+
+    bool IsEmpty() const { return entries.empty(); }
+    // Entries, including appended ones
+    size_t Count() const { return entries.size(); }
+    // Entries of the registration's own table, which metadata indexes
+    size_t RegisteredCount() const { return registeredCount; }
+    // Distinct types and argument lists
+    size_t CanonicalCount() const { return canonicalCount; }
+    size_t InstanceCount() const { return instances.size(); }
+    // Il2CppGenericInst records in the library, before deduplication
+    size_t RegisteredInstanceCount() const { return registeredInstanceCount; }
+    size_t MemoryUsage() const;
+
+    const Entry* Get(TypeIndex index) const { return index < entries.size() ? &entries[index] : nullptr; }
+    // The entry every type structurally equal to this one maps to; byref
+    // and attributes are not part of the structure
+    TypeIndex Canonical(TypeIndex index) const { return index < canonical.size() ? canonical[index] : kNone; }
+    const GenericInstance* GetInstance(uint32_t id) const { return id < instances.size() ? &instances[id] : nullptr; }
+    const TypeIndex* Arguments(const GenericInstance& instance) const { return arguments.data() + instance.first; }
+    const std::vector<MethodSpec>& MethodSpecs() const { return methodSpecs; }
+
+    // Calls fn for every TypeIndex an entry is built from
+    template <typename Fn>
+    void ForEachPart(const Entry& entry, Fn&& fn) const {
+        if (entry.type == IL2CPP_TYPE_PTR || entry.type == IL2CPP_TYPE_SZARRAY || entry.type == IL2CPP_TYPE_ARRAY) {
+            fn(entry.data);
+        } else if (entry.type == IL2CPP_TYPE_GENERICINST) {
+            if (const GenericInstance* instance = GetInstance(entry.extra)) {
+                for (uint32_t i = 0; i < instance->count; i++) fn(Arguments(*instance)[i]);
+            }
+        }
+    }
+
+    // Calls fn(index) for every entry, after it has been called for the
+    // entry's parts. Post-order walk with an explicit stack; a part still in
+    // progress is on the current path, which only happens for a cyclic
+    // (corrupt) table, and is visited after the entry that refers to it.
+    template <typename Fn>
+    void ForEachBottomUp(Fn&& fn) const {
+        enum : uint8_t { kUnvisited, kInProgress, kDone };
+        std::vector<uint8_t> state(entries.size(), kUnvisited);
+        std::vector<TypeIndex> stack;
+        for (TypeIndex root = 0; root < entries.size(); root++) {
+            if (state[root] != kUnvisited) continue;
+            stack.push_back(root);
+            while (!stack.empty()) {
+                const TypeIndex index = stack.back();
+                if (state[index] == kUnvisited) {
+                    state[index] = kInProgress;
+                    ForEachPart(entries[index], [&](TypeIndex part) {
+                        if (part < entries.size() && state[part] == kUnvisited) stack.push_back(part);
+                    });
+                    continue;
+                }
+                stack.pop_back();
+                if (state[index] == kDone) continue;
+                state[index] = kDone;
+                fn(index);
+            }
+        }
+    }
+
+private:
+    // Maps every entry to its canonical one and every argument list to its
+    // distinct instance, then rewrites the references to canonical form
+    void Canonicalize();
+
+    std::vector<Entry> entries;
+    std::vector<TypeIndex> canonical;           // By TypeIndex
+    std::vector<GenericInstance> instances;
+    std::vector<TypeIndex> arguments;
+    std::vector<MethodSpec> methodSpecs;
+    size_t registeredCount = 0;
+    size_t registeredInstanceCount = 0;
+    size_t canonicalCount = 0;
+};
+
+// C# names of the entries of a TypeTable (int, string[], List<int>,
+// Dictionary<string, Foo.Bar>), rendered once per canonical type after
+// deobfuscation. Composite names are built from the already rendered names
+// of their parts, so shared generic arguments are rendered once however
+// often they are used, and the argument list of each generic instance
+// (<int, string>) is rendered once for all the types and method specs that
+// share it.
+class TypeNameCache {
+public:
+    // Writes the name of a type definition, qualified by its declaring
+    // types; without the `N arity suffixes of generic definitions when
+    // withoutArity is set
+    using DefinitionNamer = std::function<void(TextBuffer& out, TypeDefinitionIndex index, bool withoutArity)>;
+    // Writes the name of a generic parameter
+    using ParameterNamer = std::function<void(TextBuffer& out, GenericParameterIndex index)>;
+
+    void Build(const TypeTable& table, const DefinitionNamer& definitionName, const ParameterNamer& parameterName);
+    void Clear();
+
+    bool IsEmpty() const { return names.empty(); }
+    // Name of a type without ref/out; empty if unknown. Thread-safe.
+    std::string_view Name(TypeIndex index) const {
+        return index < names.size() ? arena.View(names[index]) : std::string_view();
+    }
+    // "<int, string>" for an instance id of the table
+    std::string_view InstanceName(uint32_t id) const {
+        return id < instanceNames.size() ? arena.View(instanceNames[id]) : std::string_view();
+    }
+    size_t UniqueNameCount() const { return arena.Count(); }
+
+private:
+    StringArena arena;
+    std::vector<StringArena::Id> names;             // By TypeIndex
+    std::vector<StringArena::Id> instanceNames;     // By instance id
+};
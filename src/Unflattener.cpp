@@ -0,0 +1,1263 @@
+#include "Unflattener.h"
+#include "BufferedWriter.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+
+using StateLocation = Unflattener::StateLocation;
+
+// A function is reported as flattened when at least this many blocks compare
+// the state and at least this many edges could be replayed through them
+constexpr uint32_t kMinStateCompares = 3;
+constexpr uint32_t kMinRecoveredEdges = 3;
+constexpr size_t kMaxLocations = 64;
+constexpr size_t kRegisterCount = 32;
+constexpr size_t kSlotCount = 16;
+constexpr uint32_t kNoLocation = 0xFFFFFFFF;
+
+// Per-block facts from the symbolic pass
+constexpr uint8_t kBlockPure = 1;           // No calls or unmodeled instructions
+constexpr uint8_t kBlockTransfer = 2;       // Pure, only copies, then an unconditional jump
+constexpr uint8_t kBlockInheritsFlags = 4;  // Branches on flags set by a predecessor
+
+// x86-64 and AArch64 register numbers used as stack slot bases
+constexpr uint8_t kRsp = 4, kRbp = 5;
+constexpr uint8_t kFp = 29, kSp = 31;
+
+struct Operand {
+    enum Kind : uint8_t { None, Reg, Imm, Slot, Other };   // Slot: [sp/fp + offset]; Other: any other memory
+    Kind kind = None;
+    uint8_t reg = 0;
+    int32_t offset = 0;
+    uint64_t imm = 0;
+};
+
+Operand RegOperand(uint8_t reg) {
+    Operand operand;
+    operand.kind = Operand::Reg;
+    operand.reg = reg;
+    return operand;
+}
+
+Operand ImmOperand(uint64_t imm) {
+    Operand operand;
+    operand.kind = Operand::Imm;
+    operand.imm = imm;
+    return operand;
+}
+
+Operand MemoryOperand(uint8_t base, int32_t offset, bool stack) {
+    Operand operand;
+    operand.kind = stack ? Operand::Slot : Operand::Other;
+    operand.reg = base;
+    operand.offset = offset;
+    return operand;
+}
+
+enum class ArithOp : uint8_t { Add, Sub, And, Or, Xor };
+
+// What an instruction does to the registers, stack slots and flags, as far
+// as the state variable is concerned
+enum class OpKind : uint8_t {
+    None,
+    Clobber,        // dst gets an unknown value, and the flags too if setsFlags
+    ClobberAll,     // Not modeled: forget all registers and the flags
+    Call,           // Forget the caller-saved registers and the flags
+    Move,           // dst = src
+    MoveKeep,       // dst = (dst & ~src2.imm) | src.imm (movk)
+    Arith,          // dst = src op src2; flags from it if setsFlags
+    Select,         // dst = cond ? src : src2 (+ 1 if increment); forgets the flags if setsFlags
+    CondBranch,     // Branch on cond
+    ZeroBranch,     // Branch on src (or one bit of it) being zero or not
+};
+
+struct Operation {
+    OpKind kind = OpKind::None;
+    ArithOp arith = ArithOp::Add;
+    uint8_t width = 8;          // Operand size in bytes: 4 or 8
+    uint8_t cond = 0;
+    uint8_t bit = 0xFF;         // ZeroBranch: tested bit, 0xFF for the whole register
+    bool setsFlags = false;
+    bool increment = false;
+    bool ifZero = false;        // ZeroBranch: taken when zero
+    Operand dst, src, src2;
+};
+
+int64_t SignExtend(uint64_t value, unsigned bits) {
+    const uint64_t sign = uint64_t(1) << (bits - 1);
+    return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+uint64_t ReadLE(const unsigned char* p, unsigned bytes) {
+    uint64_t value = 0;
+    for (unsigned i = 0; i < bytes; i++) value |= uint64_t(p[i]) << (8 * i);
+    return value;
+}
+
+uint64_t WidthMask(uint8_t width) {
+    return width == 4 ? 0xFFFFFFFFull : ~uint64_t(0);
+}
+
+// ---------------------------------------------------------------------------
+// x86-64
+
+// Parses ModRM, SIB and displacement into the r/m operand; reg gets the
+// ModRM reg field. Both include the REX extension bits.
+bool ParseModRM(const unsigned char* p, const unsigned char* end, uint8_t rex, uint8_t& reg, Operand& rm) {
+    if (p >= end) return false;
+    const uint8_t mod = p[0] >> 6, low = p[0] & 7;
+    reg = static_cast<uint8_t>(((p[0] >> 3) & 7) | ((rex & 4) << 1));
+    p++;
+    if (mod == 3) {
+        rm = RegOperand(static_cast<uint8_t>(low | ((rex & 1) << 3)));
+        return true;
+    }
+    uint8_t base = static_cast<uint8_t>(low | ((rex & 1) << 3));
+    bool indexed = false, absolute = false;
+    if (low == 4) {
+        if (p >= end) return false;
+        const uint8_t sib = *p++;
+        indexed = (((sib >> 3) & 7) | ((rex & 2) << 2)) != 4;
+        base = static_cast<uint8_t>((sib & 7) | ((rex & 1) << 3));
+        absolute = (sib & 7) == 5 && mod == 0;
+    } else if (low == 5 && mod == 0) {
+        absolute = true;    // rip-relative
+    }
+    int32_t offset = 0;
+    if (mod == 1) {
+        if (p >= end) return false;
+        offset = static_cast<int8_t>(*p);
+    } else if (mod == 2 || absolute) {
+        if (end - p < 4) return false;
+        offset = static_cast<int32_t>(ReadLE(p, 4));
+    }
+    rm = MemoryOperand(base, offset, !indexed && !absolute && (base == kRsp || base == kRbp));
+    return true;
+}
+
+// Byte registers 4-7 are ah..bh without a REX prefix; writing one changes
+// the full register it belongs to
+Operand ByteOperand(Operand operand, uint8_t rex) {
+    if (operand.kind == Operand::Reg && !rex && operand.reg >= 4 && operand.reg < 8) operand.reg -= 4;
+    return operand;
+}
+
+void ParseX86_64(const unsigned char* code, size_t length, Operation& op) {
+    op = Operation();
+    const unsigned char* p = code;
+    const unsigned char* end = code + length;
+    bool operandSize16 = false, otherPrefix = false;
+    for (; p < end; p++) {
+        if (*p == 0x66) operandSize16 = true;
+        else if (*p == 0x67 || *p == 0xF0 || *p == 0xF2 || *p == 0xF3 || *p == 0x2E || *p == 0x36 ||
+                 *p == 0x3E || *p == 0x26 || *p == 0x64 || *p == 0x65) otherPrefix = true;
+        else break;
+    }
+    uint8_t rex = 0;
+    if (p < end && (*p & 0xF0) == 0x40) rex = *p++;
+    if (p >= end) {
+        op.kind = OpKind::ClobberAll;
+        return;
+    }
+    const uint8_t opcode = *p++;
+    op.width = (rex & 8) ? 8 : 4;
+
+    // Control flow, nops and push/pop first: they do not care about prefixes
+    if (opcode >= 0x70 && opcode <= 0x7F) {
+        op.kind = OpKind::CondBranch;
+        op.cond = opcode & 0xF;
+        return;
+    }
+    if (opcode == 0x0F && p < end && (*p & 0xF0) == 0x80) {
+        op.kind = OpKind::CondBranch;
+        op.cond = *p & 0xF;
+        return;
+    }
+    if (opcode == 0x0F && p < end && (*p == 0x1E || *p == 0x1F)) return;   // endbr64, nopw
+    if ((opcode == 0x90 && !(rex & 1)) || opcode == 0xE9 || opcode == 0xEB || opcode == 0xC3 ||
+        opcode == 0xC2 || opcode == 0xCC || (opcode >= 0x50 && opcode <= 0x57)) {
+        return;
+    }
+    if (opcode == 0xE8) {
+        op.kind = OpKind::Call;
+        return;
+    }
+    if (opcode >= 0x58 && opcode <= 0x5F) {
+        op.kind = OpKind::Clobber;
+        op.dst = RegOperand(static_cast<uint8_t>((opcode & 7) | ((rex & 1) << 3)));
+        return;
+    }
+    // 16-bit, string and segment forms are not modeled
+    if (operandSize16 || otherPrefix) {
+        op.kind = OpKind::ClobberAll;
+        return;
+    }
+
+    uint8_t reg;
+    Operand rm;
+    auto imm32 = [&]() { return static_cast<uint64_t>(SignExtend(ReadLE(end - 4, 4), 32)); };
+    auto imm8 = [&]() { return static_cast<uint64_t>(SignExtend(end[-1], 8)); };
+    auto arith = [&](ArithOp arithOp, Operand dst, Operand src, Operand src2) {
+        op.kind = OpKind::Arith;
+        op.arith = arithOp;
+        op.setsFlags = true;
+        op.dst = dst;
+        op.src = src;
+        op.src2 = src2;
+    };
+    auto clobber = [&](Operand dst, bool flags) {
+        op.kind = OpKind::Clobber;
+        op.dst = dst;
+        op.setsFlags = flags;
+    };
+
+    switch (opcode) {
+    case 0x89:  // mov r/m, r
+    case 0x8B:  // mov r, r/m
+        if (!ParseModRM(p, end, rex, reg, rm)) break;
+        op.kind = OpKind::Move;
+        op.dst = opcode == 0x89 ? rm : RegOperand(reg);
+        op.src = opcode == 0x89 ? RegOperand(reg) : rm;
+        return;
+    case 0xC7:  // mov r/m, imm32
+        if (!ParseModRM(p, end, rex, reg, rm) || reg != 0) break;
+        op.kind = OpKind::Move;
+        op.dst = rm;
+        op.src = ImmOperand(imm32());
+        return;
+    case 0x88: case 0x8A: case 0xC6:    // Byte moves
+        if (!ParseModRM(p, end, rex, reg, rm)) break;
+        clobber(opcode == 0x8A ? ByteOperand(RegOperand(reg), rex) : ByteOperand(rm, rex), false);
+        return;
+    case 0x8D: case 0x63:   // lea, movsxd
+        if (!ParseModRM(p, end, rex, reg, rm)) break;
+        clobber(RegOperand(reg), false);
+        return;
+    case 0x85:  // test r/m, r
+        if (!ParseModRM(p, end, rex, reg, rm)) break;
+        arith(ArithOp::And, Operand(), rm, RegOperand(reg));
+        return;
+    case 0xA9: arith(ArithOp::And, Operand(), RegOperand(0), ImmOperand(imm32())); return;
+    case 0x3D: arith(ArithOp::Sub, Operand(), RegOperand(0), ImmOperand(imm32())); return;
+    case 0x05: arith(ArithOp::Add, RegOperand(0), RegOperand(0), ImmOperand(imm32())); return;
+    case 0x0D: arith(ArithOp::Or, RegOperand(0), RegOperand(0), ImmOperand(imm32())); return;
+    case 0x25: arith(ArithOp::And, RegOperand(0), RegOperand(0), ImmOperand(imm32())); return;
+    case 0x2D: arith(ArithOp::Sub, RegOperand(0), RegOperand(0), ImmOperand(imm32())); return;
+    case 0x35: arith(ArithOp::Xor, RegOperand(0), RegOperand(0), ImmOperand(imm32())); return;
+    case 0x81: case 0x83: {     // Group 1: op r/m, imm
+        if (!ParseModRM(p, end, rex, reg, rm)) break;
+        const Operand imm = ImmOperand(opcode == 0x81 ? imm32() : imm8());
+        switch (reg & 7) {
+        case 0: arith(ArithOp::Add, rm, rm, imm); return;
+        case 1: arith(ArithOp::Or, rm, rm, imm); return;
+        case 4: arith(ArithOp::And, rm, rm, imm); return;
+        case 5: arith(ArithOp::Sub, rm, rm, imm); return;
+        case 6: arith(ArithOp::Xor, rm, rm, imm); return;
+        case 7: arith(ArithOp::Sub, Operand(), rm, imm); return;
+        default: clobber(rm, true); return;    // adc, sbb
+        }
+    }
+    case 0xF7:
+        if (!ParseModRM(p, end, rex, reg, rm)) break;
+        if ((reg & 7) == 0) {
+            arith(ArithOp::And, Operand(), rm, ImmOperand(imm32()));
+        } else if ((reg & 7) == 2 || (reg & 7) == 3) {
+            clobber(rm, (reg & 7) == 3);    // not, neg
+        } else {
+            break;  // mul/div write rax and rdx
+        }
+        return;
+    case 0xFF:
+        if (!ParseModRM(p, end, rex, reg, rm)) break;
+        switch (reg & 7) {
+        case 0: case 1: clobber(rm, true); return;     // inc, dec
+        case 2: case 3: op.kind = OpKind::Call; return;
+        case 4: case 5: case 6: return;                 // jmp, push
+        default: break;
+        }
+        break;
+    case 0xC1: case 0xD1: case 0xD3:    // Shifts
+    case 0x69: case 0x6B:               // imul r, r/m, imm
+        if (!ParseModRM(p, end, rex, reg, rm)) break;
+        clobber(opcode == 0x69 || opcode == 0x6B ? RegOperand(reg) : rm, true);
+        return;
+    case 0x0F: {
+        if (p >= end) break;
+        const uint8_t second = *p++;
+        if (!ParseModRM(p, end, rex, reg, rm)) break;
+        if (second >= 0x40 && second <= 0x4F) {     // cmovcc r, r/m
+            op.kind = OpKind::Select;
+            op.cond = second & 0xF;
+            op.dst = RegOperand(reg);
+            op.src = rm;
+            op.src2 = RegOperand(reg);
+            return;
+        }
+        if (second >= 0x90 && second <= 0x9F) {     // setcc r/m8
+            clobber(ByteOperand(rm, rex), false);
+            return;
+        }
+        if (second == 0xB6 || second == 0xB7 || second == 0xBE || second == 0xBF || second == 0xAF) {
+            clobber(RegOperand(reg), second == 0xAF);   // movzx, movsx, imul
+            return;
+        }
+        break;
+    }
+    default:
+        if (opcode < 0x40 && (opcode & 7) < 4) {
+            // The ALU block: op r/m, r and op r, r/m
+            if (!ParseModRM(p, end, rex, reg, rm)) break;
+            const uint8_t group = opcode >> 3;  // add, or, adc, sbb, and, sub, xor, cmp
+            const bool toReg = (opcode & 2) != 0;
+            const Operand regOperand = RegOperand(reg);
+            if (!(opcode & 1)) {
+                clobber(group == 7 ? Operand() : ByteOperand(toReg ? regOperand : rm, rex), true);
+                return;
+            }
+            if (group == 3 && rm.kind == Operand::Reg && rm.reg == reg) {
+                // sbb r, r: all ones if the carry is set, zero otherwise
+                op.kind = OpKind::Select;
+                op.cond = 0x2;
+                op.setsFlags = true;
+                op.dst = regOperand;
+                op.src = ImmOperand(~0ull);
+                op.src2 = ImmOperand(0);
+                return;
+            }
+            if (group == 2 || group == 3) {
+                clobber(toReg ? regOperand : rm, true);
+                return;
+            }
+            if ((group == 5 || group == 6) && rm.kind == Operand::Reg && rm.reg == reg) {
+                // xor r, r / sub r, r: zero, with the flags of a zero result
+                arith(ArithOp::And, regOperand, ImmOperand(0), ImmOperand(0));
+                return;
+            }
+            static const ArithOp kGroupOps[8] = {ArithOp::Add, ArithOp::Or, ArithOp::Add, ArithOp::Sub,
+                                                 ArithOp::And, ArithOp::Sub, ArithOp::Xor, ArithOp::Sub};
+            arith(kGroupOps[group], group == 7 ? Operand() : (toReg ? regOperand : rm),
+                  toReg ? regOperand : rm, toReg ? rm : regOperand);
+            return;
+        }
+        if (opcode >= 0xB8 && opcode <= 0xBF) {     // mov r, imm32/imm64
+            const unsigned size = (rex & 8) ? 8 : 4;
+            if (static_cast<size_t>(end - p) < size) break;
+            op.kind = OpKind::Move;
+            op.dst = RegOperand(static_cast<uint8_t>((opcode & 7) | ((rex & 1) << 3)));
+            op.src = ImmOperand(ReadLE(p, size));
+            return;
+        }
+        if (opcode >= 0xB0 && opcode <= 0xB7) {     // mov r8, imm8
+            clobber(ByteOperand(RegOperand(static_cast<uint8_t>((opcode & 7) | ((rex & 1) << 3))), rex), false);
+            return;
+        }
+        break;
+    }
+    op = Operation();
+    op.kind = OpKind::ClobberAll;
+}
+
+// ---------------------------------------------------------------------------
+// AArch64
+
+// Immediate of the logical (immediate) class; false for reserved encodings
+bool DecodeBitMask(uint32_t insn, uint8_t width, uint64_t& out) {
+    const uint32_t n = (insn >> 22) & 1, immr = (insn >> 16) & 0x3F, imms = (insn >> 10) & 0x3F;
+    const uint32_t combined = (n << 6) | (~imms & 0x3F);
+    if (combined == 0 || (width == 4 && n)) return false;
+    unsigned length = 6;
+    while (!(combined & (1u << length))) length--;
+    if (length == 0) return false;
+    const unsigned size = 1u << length;
+    const uint32_t levels = size - 1;
+    const uint32_t s = imms & levels, r = immr & levels;
+    if (s == levels) return false;
+    const uint64_t sizeMask = size == 64 ? ~uint64_t(0) : (uint64_t(1) << size) - 1;
+    uint64_t element = (uint64_t(1) << (s + 1)) - 1;
+    if (r) element = ((element >> r) | (element << (size - r))) & sizeMask;
+    uint64_t result = 0;
+    for (unsigned i = 0; i < 64; i += size) result |= element << i;
+    out = result & WidthMask(width);
+    return true;
+}
+
+// Register 31 reads as zero in most data-processing forms, and is the stack
+// pointer (not tracked) in the others
+Operand ZeroRegister(uint8_t reg) { return reg == 31 ? ImmOperand(0) : RegOperand(reg); }
+Operand ZeroDestination(uint8_t reg) { return reg == 31 ? Operand() : RegOperand(reg); }
+Operand StackRegister(uint8_t reg) { return reg == 31 ? MemoryOperand(kSp, 0, false) : RegOperand(reg); }
+
+// Appends the operations of one instruction (two for ldp/stp)
+void ParseArm64(uint32_t insn, std::vector<Operation>& out) {
+    Operation op;
+    const uint8_t rd = insn & 31, rn = (insn >> 5) & 31, rm = (insn >> 16) & 31;
+    op.width = (insn & 0x80000000) ? 8 : 4;
+    auto emit = [&]() { out.push_back(op); };
+    auto clobber = [&](Operand dst, bool flags) {
+        op.kind = OpKind::Clobber;
+        op.dst = dst;
+        op.setsFlags = flags;
+        emit();
+    };
+
+    if ((insn & 0xFFFFF01F) == 0xD503201F) return emit();   // Hints: nop, bti, pac*
+    if ((insn & 0x7C000000) == 0x14000000) {                // B / BL
+        if (insn & 0x80000000) op.kind = OpKind::Call;
+        return emit();
+    }
+    if ((insn & 0xFF000010) == 0x54000000) {                // B.cond
+        op.kind = OpKind::CondBranch;
+        op.cond = insn & 0xF;
+        return emit();
+    }
+    if ((insn & 0x7C000000) == 0x34000000) {                // CBZ/CBNZ, TBZ/TBNZ
+        op.kind = OpKind::ZeroBranch;
+        op.src = ZeroRegister(rd);
+        op.ifZero = !(insn & 0x01000000);
+        if (insn & 0x02000000) {
+            op.bit = static_cast<uint8_t>(((insn >> 26) & 0x20) | ((insn >> 19) & 0x1F));
+            op.width = 8;
+        }
+        return emit();
+    }
+    if ((insn & 0xFE000000) == 0xD6000000) {                // Branch to register
+        if (((insn >> 21) & 7) == 1) op.kind = OpKind::Call;
+        return emit();
+    }
+    if ((insn & 0x1F800000) == 0x12800000) {                // MOVN / MOVZ / MOVK
+        const uint32_t opc = (insn >> 29) & 3, shift = ((insn >> 21) & 3) * 16;
+        const uint64_t imm = uint64_t((insn >> 5) & 0xFFFF) << shift;
+        if (opc == 1 || (op.width == 4 && shift >= 32)) return clobber(ZeroDestination(rd), false);
+        op.dst = ZeroDestination(rd);
+        if (opc == 3) {
+            op.kind = OpKind::MoveKeep;
+            op.src = ImmOperand(imm);
+            op.src2 = ImmOperand(uint64_t(0xFFFF) << shift);
+        } else {
+            op.kind = OpKind::Move;
+            op.src = ImmOperand(opc == 0 ? ~imm : imm);
+        }
+        return emit();
+    }
+    static const ArithOp kLogicalOps[4] = {ArithOp::And, ArithOp::Or, ArithOp::Xor, ArithOp::And};
+    if ((insn & 0x1F800000) == 0x12000000) {                // Logical (immediate)
+        const uint32_t opc = (insn >> 29) & 3;
+        uint64_t imm;
+        if (!DecodeBitMask(insn, op.width, imm)) return clobber(ZeroDestination(rd), opc == 3);
+        op.src2 = ImmOperand(imm);
+        if (opc == 1 && rn == 31) {
+            op.kind = OpKind::Move;
+            op.dst = ZeroDestination(rd);
+            op.src = op.src2;
+            return emit();
+        }
+        op.kind = OpKind::Arith;
+        op.arith = kLogicalOps[opc];
+        op.setsFlags = opc == 3;
+        op.dst = ZeroDestination(rd);   // Only ANDS reads 31 as zr, but sp is not tracked either way
+        op.src = ZeroRegister(rn);
+        return emit();
+    }
+    if ((insn & 0x1F000000) == 0x0A000000) {                // Logical (shifted register)
+        const uint32_t opc = (insn >> 29) & 3;
+        if ((insn & 0x00200000) || ((insn >> 10) & 0x3F)) return clobber(ZeroDestination(rd), opc == 3);
+        if (opc == 1 && rn == 31) {     // mov
+            op.kind = OpKind::Move;
+            op.dst = ZeroDestination(rd);
+            op.src = ZeroRegister(rm);
+            return emit();
+        }
+        op.kind = OpKind::Arith;
+        op.arith = kLogicalOps[opc];
+        op.setsFlags = opc == 3;
+        op.dst = ZeroDestination(rd);
+        op.src = ZeroRegister(rn);
+        op.src2 = ZeroRegister(rm);
+        return emit();
+    }
+    if ((insn & 0x1F000000) == 0x11000000) {                // Add/subtract (immediate)
+        const bool setsFlags = (insn & 0x20000000) != 0;
+        uint64_t imm = (insn >> 10) & 0xFFF;
+        if (insn & 0x00400000) imm <<= 12;
+        op.kind = OpKind::Arith;
+        op.arith = (insn & 0x40000000) ? ArithOp::Sub : ArithOp::Add;
+        op.setsFlags = setsFlags;
+        op.dst = ZeroDestination(rd);
+        op.src = StackRegister(rn);
+        op.src2 = ImmOperand(imm);
+        return emit();
+    }
+    if ((insn & 0x1F200000) == 0x0B000000) {                // Add/subtract (shifted register)
+        const bool setsFlags = (insn & 0x20000000) != 0;
+        if ((insn >> 10) & 0x3F) return clobber(ZeroDestination(rd), setsFlags);
+        op.kind = OpKind::Arith;
+        op.arith = (insn & 0x40000000) ? ArithOp::Sub : ArithOp::Add;
+        op.setsFlags = setsFlags;
+        op.dst = ZeroDestination(rd);
+        op.src = ZeroRegister(rn);
+        op.src2 = ZeroRegister(rm);
+        return emit();
+    }
+    if ((insn & 0x1FE00000) == 0x1A800000) {                // Conditional select
+        const uint32_t op2 = (insn >> 10) & 3;
+        if ((insn & 0x60000000) || op2 > 1) return clobber(ZeroDestination(rd), false);
+        op.kind = OpKind::Select;
+        op.cond = (insn >> 12) & 0xF;
+        op.increment = op2 == 1;
+        op.dst = ZeroDestination(rd);
+        op.src = ZeroRegister(rn);
+        op.src2 = ZeroRegister(rm);
+        return emit();
+    }
+    const bool stackBase = rn == kSp || rn == kFp;
+    if ((insn & 0x3B000000) == 0x39000000 || (insn & 0x3B200C00) == 0x38000000) {
+        // LDR/STR (unsigned offset) and LDUR/STUR of w and x registers
+        const uint32_t size = insn >> 30, opc = (insn >> 22) & 3;
+        if (!(insn & 0x04000000) && size >= 2 && opc <= 1) {
+            const int32_t offset = (insn & 0x01000000) ? static_cast<int32_t>(((insn >> 10) & 0xFFF) << size)
+                                                       : static_cast<int32_t>(SignExtend((insn >> 12) & 0x1FF, 9));
+            const Operand memory = MemoryOperand(rn, offset, stackBase);
+            op.kind = OpKind::Move;
+            op.width = size == 3 ? 8 : 4;
+            op.dst = opc == 0 ? memory : ZeroDestination(rd);
+            op.src = opc == 0 ? ZeroRegister(rd) : memory;
+            return emit();
+        }
+    }
+    if ((insn & 0x3FC00000) == 0x29000000 || (insn & 0x3FC00000) == 0x29400000) {
+        // LDP/STP (signed offset) of w and x registers
+        const uint32_t opc = insn >> 30;
+        if (opc == 0 || opc == 2) {
+            const bool load = (insn & 0x00400000) != 0;
+            const uint8_t size = opc == 2 ? 8 : 4;
+            const int32_t offset = static_cast<int32_t>(SignExtend((insn >> 15) & 0x7F, 7) * size);
+            const uint8_t registers[2] = {rd, static_cast<uint8_t>((insn >> 10) & 31)};
+            for (int i = 0; i < 2; i++) {
+                const Operand memory = MemoryOperand(rn, offset + i * size, stackBase);
+                op.kind = OpKind::Move;
+                op.width = size;
+                op.dst = load ? ZeroDestination(registers[i]) : memory;
+                op.src = load ? memory : ZeroRegister(registers[i]);
+                emit();
+            }
+            return;
+        }
+    }
+    if ((insn & 0x0A000000) == 0x08000000) {
+        // Other loads and stores: loads write Rt, and Rt2 for pairs
+        if (insn & 0x00400000) {
+            clobber(ZeroDestination(rd), false);
+            if (((insn >> 27) & 7) == 5) {
+                op = Operation();
+                clobber(ZeroDestination((insn >> 10) & 31), false);
+            }
+            return;
+        }
+        return emit();
+    }
+    // Anything else writes Rd at most; flags are forgotten for safety
+    clobber(ZeroDestination(rd), true);
+}
+
+// ---------------------------------------------------------------------------
+// Evaluation
+
+struct Value {
+    enum Kind : uint8_t { Unknown, Const, Origin };
+    Kind kind = Unknown;
+    uint64_t value = 0;
+    StateLocation origin = {};  // Origin: the value this location had on block entry
+};
+
+Value ConstValue(uint64_t value) {
+    Value result;
+    result.kind = Value::Const;
+    result.value = value;
+    return result;
+}
+
+Value OriginValue(const StateLocation& location) {
+    Value result;
+    result.kind = Value::Origin;
+    result.origin = location;
+    return result;
+}
+
+StateLocation RegisterLocation(uint8_t reg) {
+    return StateLocation{StateLocation::Register, reg, 0};
+}
+
+struct Flags {
+    bool valid = false;
+    ArithOp op = ArithOp::Sub;
+    uint8_t width = 8;
+    Value lhs, rhs;
+    StateLocation lhsAt{}, rhsAt{}; // Where the operands were read from, if a register or slot
+};
+
+// 1 if cond holds, 0 if not, -1 if the flags are not known
+int EvaluateCondition(ElfImage::Machine machine, uint8_t cond, const Flags& flags) {
+    if (!flags.valid || flags.lhs.kind != Value::Const || flags.rhs.kind != Value::Const) return -1;
+    const uint64_t mask = WidthMask(flags.width);
+    const uint64_t sign = flags.width == 4 ? 0x80000000ull : 0x8000000000000000ull;
+    const uint64_t a = flags.lhs.value & mask, b = flags.rhs.value & mask;
+    uint64_t r = 0;
+    bool carry = false, overflow = false;   // Carry in the AArch64 sense: set when a subtraction does not borrow
+    switch (flags.op) {
+    case ArithOp::Sub:
+        r = (a - b) & mask;
+        carry = a >= b;
+        overflow = ((a ^ b) & (a ^ r) & sign) != 0;
+        break;
+    case ArithOp::Add:
+        r = (a + b) & mask;
+        carry = r < a;
+        overflow = (~(a ^ b) & (a ^ r) & sign) != 0;
+        break;
+    case ArithOp::And: r = a & b; break;
+    case ArithOp::Or: r = a | b; break;
+    case ArithOp::Xor: r = a ^ b; break;
+    }
+    const bool zero = r == 0, negative = (r & sign) != 0;
+
+    if (machine == ElfImage::Machine::X86_64) {
+        const bool cf = flags.op == ArithOp::Sub ? !carry : carry;
+        switch (cond) {
+        case 0x0: return overflow;
+        case 0x1: return !overflow;
+        case 0x2: return cf;
+        case 0x3: return !cf;
+        case 0x4: return zero;
+        case 0x5: return !zero;
+        case 0x6: return cf || zero;
+        case 0x7: return !cf && !zero;
+        case 0x8: return negative;
+        case 0x9: return !negative;
+        case 0xC: return negative != overflow;
+        case 0xD: return negative == overflow;
+        case 0xE: return zero || negative != overflow;
+        case 0xF: return !zero && negative == overflow;
+        default: return -1;     // Parity
+        }
+    }
+
+    bool result;
+    switch (cond >> 1) {
+    case 0: result = zero; break;
+    case 1: result = carry; break;
+    case 2: result = negative; break;
+    case 3: result = overflow; break;
+    case 4: result = carry && !zero; break;
+    case 5: result = negative == overflow; break;
+    case 6: result = !zero && negative == overflow; break;
+    default: return 1;          // AL, NV
+    }
+    return (cond & 1) ? !result : result;
+}
+
+// Registers, stack slots and flags over one path. In symbolic mode every
+// location starts out holding its own entry value (Origin), which is how
+// compares and copies of the state are recognized; in concrete mode
+// everything starts unknown and only constants propagate.
+class Evaluator {
+public:
+    Evaluator(ElfImage::Machine machine, bool symbolic) : machine(machine), symbolic(symbolic) { Reset(); }
+
+    void Reset() {
+        for (size_t r = 0; r < kRegisterCount; r++) {
+            regs[r] = symbolic ? OriginValue(RegisterLocation(static_cast<uint8_t>(r))) : Value();
+        }
+        slotCount = 0;
+        flags = Flags();
+        undecidedSelect = false;
+    }
+
+    Value Read(const Operand& operand) const {
+        switch (operand.kind) {
+        case Operand::Reg: return regs[operand.reg];
+        case Operand::Imm: return ConstValue(operand.imm);
+        case Operand::Slot: {
+            const StateLocation location = SlotLocation(operand);
+            for (size_t i = 0; i < slotCount; i++) {
+                if (slots[i].location == location) return slots[i].value;
+            }
+            return symbolic ? OriginValue(location) : Value();
+        }
+        default: return Value();
+        }
+    }
+
+    void Execute(const Operation& op) {
+        switch (op.kind) {
+        case OpKind::None:
+        case OpKind::CondBranch:
+        case OpKind::ZeroBranch:
+            break;
+        case OpKind::Clobber:
+            Write(op.dst, Value(), op.width);
+            if (op.setsFlags) flags.valid = false;
+            break;
+        case OpKind::ClobberAll:
+            for (Value& value : regs) value = Value();
+            flags.valid = false;
+            break;
+        case OpKind::Call:
+            ClobberCallerSaved();
+            flags.valid = false;
+            break;
+        case OpKind::Move:
+            Write(op.dst, Read(op.src), op.width);
+            break;
+        case OpKind::MoveKeep: {
+            Value value = Read(op.dst);
+            if (value.kind == Value::Const) value.value = (value.value & ~op.src2.imm) | op.src.imm;
+            else value = Value();
+            Write(op.dst, value, op.width);
+            break;
+        }
+        case OpKind::Arith: {
+            const Value a = Read(op.src), b = Read(op.src2);
+            Value result;
+            if (a.kind == Value::Const && b.kind == Value::Const) {
+                switch (op.arith) {
+                case ArithOp::Add: result = ConstValue(a.value + b.value); break;
+                case ArithOp::Sub: result = ConstValue(a.value - b.value); break;
+                case ArithOp::And: result = ConstValue(a.value & b.value); break;
+                case ArithOp::Or: result = ConstValue(a.value | b.value); break;
+                case ArithOp::Xor: result = ConstValue(a.value ^ b.value); break;
+                }
+            }
+            if (op.setsFlags) {
+                flags.valid = true;
+                flags.op = op.arith;
+                flags.width = op.width;
+                flags.lhs = a;
+                flags.rhs = b;
+                flags.lhsAt = OperandLocation(op.src);
+                flags.rhsAt = OperandLocation(op.src2);
+            }
+            Write(op.dst, result, op.width);
+            break;
+        }
+        case OpKind::Select: {
+            int taken = EvaluateCondition(machine, op.cond, flags);
+            if (taken < 0) {
+                undecidedSelect = true;
+                if (forceSelect < 0) {
+                    Write(op.dst, Value(), op.width);
+                    break;
+                }
+                taken = forceSelect;
+            }
+            Value value = Read(taken ? op.src : op.src2);
+            if (!taken && op.increment) {
+                if (value.kind == Value::Const) value.value++;
+                else value = Value();
+            }
+            Write(op.dst, value, op.width);
+            if (op.setsFlags) flags.valid = false;
+            break;
+        }
+        }
+    }
+
+    // Whether the branch that ends a block is taken: 1, 0, or -1 if unknown
+    int BranchTaken(const Operation& op) const {
+        if (op.kind == OpKind::CondBranch) return EvaluateCondition(machine, op.cond, flags);
+        if (op.kind != OpKind::ZeroBranch) return -1;
+        const Value value = Read(op.src);
+        if (value.kind != Value::Const) return -1;
+        const uint64_t tested = op.bit == 0xFF ? value.value & WidthMask(op.width) : (value.value >> op.bit) & 1;
+        return (tested == 0) == op.ifZero;
+    }
+
+    // The location a block-ending branch compares against a constant, if
+    // any: the one whose entry value was compared, or else, if byOperand,
+    // the register or slot the compare read
+    StateLocation ComparedLocation(const Operation& op, bool byOperand) const {
+        auto pick = [&](const Value& value, const StateLocation& at) {
+            if (value.kind == Value::Origin) return value.origin;
+            return byOperand ? at : StateLocation{};
+        };
+        if (op.kind == OpKind::ZeroBranch && op.bit == 0xFF) return pick(Read(op.src), OperandLocation(op.src));
+        if (op.kind != OpKind::CondBranch || !flags.valid || (flags.op != ArithOp::Sub && flags.op != ArithOp::Add)) {
+            return StateLocation{};
+        }
+        if (flags.rhs.kind == Value::Const) return pick(flags.lhs, flags.lhsAt);
+        if (flags.lhs.kind == Value::Const) return pick(flags.rhs, flags.rhsAt);
+        return StateLocation{};
+    }
+
+    // Calls fn(holder, origin) for every location that holds a copy of
+    // another location's entry value
+    template <typename Fn>
+    void ForEachCopy(Fn&& fn) const {
+        for (size_t r = 0; r < kRegisterCount; r++) {
+            const StateLocation holder = RegisterLocation(static_cast<uint8_t>(r));
+            if (regs[r].kind == Value::Origin && !(regs[r].origin == holder)) fn(holder, regs[r].origin);
+        }
+        for (size_t i = 0; i < slotCount; i++) {
+            if (slots[i].value.kind == Value::Origin && !(slots[i].value.origin == slots[i].location)) {
+                fn(slots[i].location, slots[i].value.origin);
+            }
+        }
+    }
+
+    int forceSelect = -1;           // Outcome for selects on unknown flags; -1 leaves the result unknown
+    bool undecidedSelect = false;   // A select on unknown flags was executed
+
+private:
+    static StateLocation SlotLocation(const Operand& operand) {
+        return StateLocation{StateLocation::Memory, operand.reg, operand.offset};
+    }
+
+    static StateLocation OperandLocation(const Operand& operand) {
+        if (operand.kind == Operand::Reg) return RegisterLocation(operand.reg);
+        if (operand.kind == Operand::Slot) return SlotLocation(operand);
+        return StateLocation{};
+    }
+
+    void Write(const Operand& dst, Value value, uint8_t width) {
+        if (value.kind == Value::Const) value.value &= WidthMask(width);
+        if (dst.kind == Operand::Reg) {
+            regs[dst.reg] = value;
+        } else if (dst.kind == Operand::Slot) {
+            const StateLocation location = SlotLocation(dst);
+            for (size_t i = 0; i < slotCount; i++) {
+                if (slots[i].location == location) {
+                    slots[i].value = value;
+                    return;
+                }
+            }
+            if (slotCount < kSlotCount) slots[slotCount++] = {location, value};
+        }
+    }
+
+    void ClobberCallerSaved() {
+        if (machine == ElfImage::Machine::X86_64) {
+            for (uint8_t r : {0, 1, 2, 6, 7, 8, 9, 10, 11}) regs[r] = Value();
+        } else {
+            for (uint8_t r = 0; r <= 18; r++) regs[r] = Value();
+            regs[30] = Value();
+        }
+    }
+
+    struct Slot {
+        StateLocation location;
+        Value value;
+    };
+
+    ElfImage::Machine machine;
+    bool symbolic;
+    Value regs[kRegisterCount];
+    Slot slots[kSlotCount];
+    size_t slotCount = 0;
+    Flags flags;
+};
+
+// ---------------------------------------------------------------------------
+// Per-function analysis
+
+// Output of one ParallelFor chunk, concatenated in order afterwards
+struct UnflattenChunk {
+    std::vector<Unflattener::Result> results;   // firstEdge/firstDispatcherBlock relative to this chunk
+    std::vector<Unflattener::Edge> edges;
+    std::vector<uint32_t> dispatcherBlocks;
+    size_t unresolvedCount = 0;
+};
+
+// Reused per worker so that analyzing a function does not allocate once the
+// buffers have grown
+struct UnflattenScratch {
+    std::vector<Operation> ops;
+    std::vector<uint32_t> blockOps;         // First operation of each block, plus the end
+    std::vector<uint32_t> comparedLocation; // Per block, into locations, kNoLocation if none
+    std::vector<uint32_t> exitCompare;      // Same, for every block: what its flags compare on exit
+    std::vector<uint8_t> blockFlags;        // kBlock* per block
+    std::vector<uint8_t> inDispatcher;
+    std::vector<uint32_t> predecessorStart; // CSR predecessor lists
+    std::vector<uint32_t> predecessors;
+    std::vector<uint32_t> predecessorFill;
+    std::vector<uint32_t> worklist;
+    std::vector<uint32_t> familyCompares;   // Compare count by union-find root
+    std::vector<uint8_t> isTarget;
+    struct LocationEntry {
+        StateLocation location;
+        uint32_t compares;
+        uint32_t parent;    // Union-find over copies: parent is closer to the original
+    };
+    std::vector<LocationEntry> locations;
+};
+
+uint32_t FindLocation(UnflattenScratch& scratch, const StateLocation& location, bool add) {
+    for (uint32_t i = 0; i < scratch.locations.size(); i++) {
+        if (scratch.locations[i].location == location) return i;
+    }
+    if (!add || scratch.locations.size() >= kMaxLocations) return kNoLocation;
+    scratch.locations.push_back({location, 0, static_cast<uint32_t>(scratch.locations.size())});
+    return static_cast<uint32_t>(scratch.locations.size() - 1);
+}
+
+uint32_t FindRoot(UnflattenScratch& scratch, uint32_t index) {
+    while (scratch.locations[index].parent != index) {
+        scratch.locations[index].parent = scratch.locations[scratch.locations[index].parent].parent;
+        index = scratch.locations[index].parent;
+    }
+    return index;
+}
+
+// Decodes every block of the function into scratch.ops; false if the code is
+// not mapped
+bool DecodeFunction(const ControlFlowGraph& graph, const ControlFlowGraph::Function& function,
+                    const ControlFlowGraph::Block* blocks, UnflattenScratch& scratch) {
+    const unsigned char* code = graph.GetCode(function);
+    if (!code) return false;
+    const ElfImage::Machine machine = graph.GetMachine();
+    const InstructionDecoder decoder(machine);
+    scratch.ops.clear();
+    scratch.blockOps.clear();
+    for (uint32_t b = 0; b < function.blockCount; b++) {
+        scratch.blockOps.push_back(static_cast<uint32_t>(scratch.ops.size()));
+        const unsigned char* blockCode = code + blocks[b].offset;
+        for (uint32_t pos = 0; pos < blocks[b].size;) {
+            Instruction ins;
+            if (!decoder.Decode(blockCode + pos, blocks[b].size - pos, function.address + blocks[b].offset + pos, ins)) {
+                Operation op;
+                op.kind = OpKind::ClobberAll;
+                scratch.ops.push_back(op);
+                pos += decoder.MinLength();
+                continue;
+            }
+            if (machine == ElfImage::Machine::ARM64) {
+                ParseArm64(static_cast<uint32_t>(ReadLE(blockCode + pos, 4)), scratch.ops);
+            } else {
+                Operation op;
+                ParseX86_64(blockCode + pos, ins.length, op);
+                scratch.ops.push_back(op);
+            }
+            pos += ins.length;
+        }
+    }
+    scratch.blockOps.push_back(static_cast<uint32_t>(scratch.ops.size()));
+    return true;
+}
+
+// Follows one edge into the dispatcher: runs the source block, then the
+// dispatcher blocks the evaluated compares lead through. Returns the first
+// block outside the dispatcher, or kNoBlock if a compare could not be decided.
+uint32_t Replay(const ControlFlowGraph::Block* blocks, const UnflattenScratch& scratch, Evaluator& evaluator,
+                uint32_t from, uint32_t into, int forceSelect) {
+    evaluator.Reset();
+    evaluator.forceSelect = forceSelect;
+    for (uint32_t i = scratch.blockOps[from]; i < scratch.blockOps[from + 1]; i++) evaluator.Execute(scratch.ops[i]);
+
+    uint32_t current = into;
+    for (uint32_t steps = 0; scratch.inDispatcher[current]; steps++) {
+        if (steps == Unflattener::kMaxDispatchSteps) return ControlFlowGraph::kNoBlock;
+        const uint32_t first = scratch.blockOps[current], last = scratch.blockOps[current + 1];
+        for (uint32_t i = first; i < last; i++) evaluator.Execute(scratch.ops[i]);
+
+        const ControlFlowGraph::Block& block = blocks[current];
+        uint32_t next;
+        switch (block.terminator) {
+        case InstructionFlow::ConditionalJump: {
+            const int taken = last > first ? evaluator.BranchTaken(scratch.ops[last - 1]) : -1;
+            if (taken < 0) return ControlFlowGraph::kNoBlock;
+            next = block.successors[taken ? 0 : 1];
+            break;
+        }
+        case InstructionFlow::Jump: next = block.successors[0]; break;
+        case InstructionFlow::Sequential: next = block.successors[1]; break;
+        default: return ControlFlowGraph::kNoBlock;
+        }
+        if (next == ControlFlowGraph::kNoBlock) return next;
+        current = next;
+    }
+    return current;
+}
+
+void AnalyzeFunction(const ControlFlowGraph& graph, uint32_t index, UnflattenScratch& scratch, UnflattenChunk& out) {
+    const ControlFlowGraph::Function& function = graph.GetFunction(index);
+    const ControlFlowGraph::Block* blocks = graph.GetBlocks(function);
+    const uint32_t blockCount = function.blockCount;
+
+    // Cheap rejection before decoding: a dispatcher needs several compares
+    uint32_t conditional = 0;
+    for (uint32_t b = 0; b < blockCount; b++) {
+        if (blocks[b].terminator == InstructionFlow::ConditionalJump) conditional++;
+    }
+    if (conditional < kMinStateCompares || !DecodeFunction(graph, function, blocks, scratch)) return;
+
+    // Predecessor lists, in CSR form
+    scratch.predecessorStart.assign(blockCount + 1, 0);
+    for (uint32_t b = 0; b < blockCount; b++) {
+        for (uint32_t successor : blocks[b].successors) {
+            if (successor != ControlFlowGraph::kNoBlock) scratch.predecessorStart[successor + 1]++;
+        }
+    }
+    for (uint32_t b = 0; b < blockCount; b++) scratch.predecessorStart[b + 1] += scratch.predecessorStart[b];
+    scratch.predecessors.resize(scratch.predecessorStart[blockCount]);
+    scratch.predecessorFill.assign(scratch.predecessorStart.begin(), scratch.predecessorStart.end() - 1);
+    for (uint32_t b = 0; b < blockCount; b++) {
+        for (uint32_t successor : blocks[b].successors) {
+            if (successor != ControlFlowGraph::kNoBlock) scratch.predecessors[scratch.predecessorFill[successor]++] = b;
+        }
+    }
+
+    // 1. Per block, symbolically: which location the closing branch compares
+    //    against a constant, and which locations are copied into others.
+    //    Only blocks without calls or unmodeled instructions take part. A
+    //    block that is just a branch on flags set before it (the second jcc
+    //    of a compare tree) inherits what its predecessors compared last,
+    //    even where that was a register the case code had just written.
+    scratch.locations.clear();
+    scratch.comparedLocation.assign(blockCount, kNoLocation);
+    scratch.exitCompare.assign(blockCount, kNoLocation);
+    scratch.blockFlags.assign(blockCount, 0);
+    Evaluator symbolic(graph.GetMachine(), true);
+    for (uint32_t b = 0; b < blockCount; b++) {
+        const uint32_t first = scratch.blockOps[b], last = scratch.blockOps[b + 1];
+        symbolic.Reset();
+        bool pure = true, copiesOnly = true, writesFlags = false;
+        for (uint32_t i = first; i < last; i++) {
+            const Operation& op = scratch.ops[i];
+            switch (op.kind) {
+            case OpKind::None: case OpKind::CondBranch: case OpKind::ZeroBranch: break;
+            case OpKind::Arith: copiesOnly = false; break;
+            case OpKind::Move: copiesOnly &= op.src.kind == Operand::Reg || op.src.kind == Operand::Slot; break;
+            case OpKind::MoveKeep: copiesOnly = false; break;
+            default: pure = copiesOnly = false; break;
+            }
+            writesFlags |= op.setsFlags || op.kind == OpKind::ClobberAll || op.kind == OpKind::Call;
+            symbolic.Execute(op);
+        }
+        const InstructionFlow terminator = blocks[b].terminator;
+        uint8_t& flags = scratch.blockFlags[b];
+        if (pure) flags |= kBlockPure;
+        if (pure && copiesOnly && (terminator == InstructionFlow::Jump || terminator == InstructionFlow::Sequential)) {
+            flags |= kBlockTransfer;
+        }
+        if (terminator != InstructionFlow::ConditionalJump || last == first) continue;
+        if (!writesFlags && scratch.ops[last - 1].kind == OpKind::CondBranch) {
+            flags |= kBlockInheritsFlags;
+            continue;
+        }
+        const StateLocation byValue = symbolic.ComparedLocation(scratch.ops[last - 1], false);
+        const StateLocation byOperand = symbolic.ComparedLocation(scratch.ops[last - 1], true);
+        if (pure && byValue.kind != StateLocation::None) scratch.comparedLocation[b] = FindLocation(scratch, byValue, true);
+        if (byOperand.kind != StateLocation::None) scratch.exitCompare[b] = FindLocation(scratch, byOperand, true);
+    }
+
+    // Inherited compares, until chains of them settle. A block is looked at
+    // again only when one of its predecessors got a compare.
+    scratch.worklist.clear();
+    for (uint32_t b = blockCount; b-- > 0;) {
+        if (scratch.blockFlags[b] & kBlockInheritsFlags) scratch.worklist.push_back(b);
+    }
+    while (!scratch.worklist.empty()) {
+        const uint32_t b = scratch.worklist.back();
+        scratch.worklist.pop_back();
+        if (scratch.exitCompare[b] != kNoLocation) continue;
+        uint32_t inherited = kNoLocation;
+        for (uint32_t i = scratch.predecessorStart[b]; i < scratch.predecessorStart[b + 1]; i++) {
+            const uint32_t location = scratch.exitCompare[scratch.predecessors[i]];
+            if (location == kNoLocation || (inherited != kNoLocation && location != inherited)) {
+                inherited = kNoLocation;
+                break;
+            }
+            inherited = location;
+        }
+        if (inherited == kNoLocation) continue;
+        scratch.exitCompare[b] = inherited;
+        if (scratch.blockFlags[b] & kBlockPure) scratch.comparedLocation[b] = inherited;
+        for (uint32_t successor : blocks[b].successors) {
+            if (successor != ControlFlowGraph::kNoBlock && (scratch.blockFlags[successor] & kBlockInheritsFlags)) {
+                scratch.worklist.push_back(successor);
+            }
+        }
+    }
+
+    // Copies only count where the state can be: in compare and transfer
+    // blocks, not in case code that reuses the same registers
+    for (uint32_t b = 0; b < blockCount; b++) {
+        const uint32_t compared = scratch.comparedLocation[b];
+        if (compared != kNoLocation) scratch.locations[compared].compares++;
+        else if (!(scratch.blockFlags[b] & kBlockTransfer)) continue;
+        symbolic.Reset();
+        for (uint32_t i = scratch.blockOps[b]; i < scratch.blockOps[b + 1]; i++) symbolic.Execute(scratch.ops[i]);
+        symbolic.ForEachCopy([&](const StateLocation& holder, const StateLocation& origin) {
+            const uint32_t h = FindLocation(scratch, holder, true), o = FindLocation(scratch, origin, true);
+            if (h == kNoLocation || o == kNoLocation) return;
+            const uint32_t holderRoot = FindRoot(scratch, h), originRoot = FindRoot(scratch, o);
+            if (holderRoot != originRoot) scratch.locations[holderRoot].parent = originRoot;
+        });
+    }
+
+    // 2. The state: the family of copies compared most often, named after
+    //    its most compared member
+    std::vector<uint32_t>& familyCompares = scratch.familyCompares;
+    familyCompares.assign(scratch.locations.size(), 0);
+    uint32_t stateRoot = kNoLocation, best = 0;
+    for (uint32_t i = 0; i < scratch.locations.size(); i++) {
+        const uint32_t root = FindRoot(scratch, i);
+        familyCompares[root] += scratch.locations[i].compares;
+        if (familyCompares[root] > best) {
+            best = familyCompares[root];
+            stateRoot = root;
+        }
+    }
+    if (best < kMinStateCompares) return;
+    uint32_t stateName = stateRoot;
+    for (uint32_t i = 0; i < scratch.locations.size(); i++) {
+        if (FindRoot(scratch, i) == stateRoot && scratch.locations[i].compares > scratch.locations[stateName].compares) {
+            stateName = i;
+        }
+    }
+
+    // 3. The dispatcher: blocks that compare the state, plus the copy-and-jump
+    //    blocks (the loop latch) that lead into them
+    scratch.inDispatcher.assign(blockCount, 0);
+    scratch.worklist.clear();
+    for (uint32_t b = 0; b < blockCount; b++) {
+        const uint32_t location = scratch.comparedLocation[b];
+        if (location != kNoLocation && FindRoot(scratch, location) == stateRoot) {
+            scratch.inDispatcher[b] = 1;
+            scratch.worklist.push_back(b);
+        }
+    }
+    while (!scratch.worklist.empty()) {
+        const uint32_t block = scratch.worklist.back();
+        scratch.worklist.pop_back();
+        for (uint32_t i = scratch.predecessorStart[block]; i < scratch.predecessorStart[block + 1]; i++) {
+            const uint32_t predecessor = scratch.predecessors[i];
+            if (scratch.inDispatcher[predecessor] || !(scratch.blockFlags[predecessor] & kBlockTransfer)) continue;
+            scratch.inDispatcher[predecessor] = 1;
+            scratch.worklist.push_back(predecessor);
+        }
+    }
+
+    // 4. Replay every edge into the dispatcher from outside it
+    const size_t firstEdge = out.edges.size();
+    uint32_t unresolved = 0;
+    Evaluator concrete(graph.GetMachine(), false);
+    for (uint32_t b = 0; b < blockCount; b++) {
+        if (scratch.inDispatcher[b]) continue;
+        for (uint8_t slot = 0; slot < 2; slot++) {
+            const uint32_t successor = blocks[b].successors[slot];
+            if (successor == ControlFlowGraph::kNoBlock || !scratch.inDispatcher[successor]) continue;
+            const uint32_t whenTrue = Replay(blocks, scratch, concrete, b, successor, 1);
+            if (!concrete.undecidedSelect) {
+                if (whenTrue == ControlFlowGraph::kNoBlock) unresolved++;
+                else out.edges.push_back({b, whenTrue, slot, Unflattener::EdgeKind::Direct});
+                continue;
+            }
+            const uint32_t whenFalse = Replay(blocks, scratch, concrete, b, successor, 0);
+            if (whenTrue == whenFalse) {
+                if (whenTrue == ControlFlowGraph::kNoBlock) unresolved++;
+                else out.edges.push_back({b, whenTrue, slot, Unflattener::EdgeKind::Direct});
+                continue;
+            }
+            if (whenTrue != ControlFlowGraph::kNoBlock) out.edges.push_back({b, whenTrue, slot, Unflattener::EdgeKind::SelectTrue});
+            else unresolved++;
+            if (whenFalse != ControlFlowGraph::kNoBlock) out.edges.push_back({b, whenFalse, slot, Unflattener::EdgeKind::SelectFalse});
+            else unresolved++;
+        }
+    }
+
+    // A real dispatcher sends the replayed edges to several different cases
+    const size_t recovered = out.edges.size() - firstEdge;
+    scratch.isTarget.assign(blockCount, 0);
+    uint32_t distinctTargets = 0;
+    for (size_t e = firstEdge; e < out.edges.size(); e++) {
+        if (!scratch.isTarget[out.edges[e].to]) {
+            scratch.isTarget[out.edges[e].to] = 1;
+            distinctTargets++;
+        }
+    }
+    if (recovered < kMinRecoveredEdges || distinctTargets < 2 || recovered <= unresolved) {
+        out.edges.resize(firstEdge);
+        return;
+    }
+
+    Unflattener::Result result = {};
+    result.function = index;
+    result.state = scratch.locations[stateName].location;
+    result.firstDispatcherBlock = static_cast<uint32_t>(out.dispatcherBlocks.size());
+    for (uint32_t b = 0; b < blockCount; b++) {
+        if (scratch.inDispatcher[b]) out.dispatcherBlocks.push_back(b);
+    }
+    result.dispatcherBlockCount = static_cast<uint32_t>(out.dispatcherBlocks.size() - result.firstDispatcherBlock);
+    result.firstEdge = static_cast<uint32_t>(firstEdge);
+    result.edgeCount = static_cast<uint32_t>(recovered);
+    result.unresolvedCount = unresolved;
+    out.results.push_back(result);
+    out.unresolvedCount += unresolved;
+}
+
+} // namespace
+
+void Unflattener::Run(const ControlFlowGraph& graph, ThreadPool& pool) {
+    Clear();
+    if (!InstructionDecoder::IsSupported(graph.GetMachine())) return;
+
+    constexpr size_t kFunctionsPerChunk = 256;
+    const size_t functionCount = graph.FunctionCount();
+    std::vector<UnflattenChunk> chunks((functionCount + kFunctionsPerChunk - 1) / kFunctionsPerChunk);
+    std::vector<UnflattenScratch> scratch(pool.GetThreadCount());
+    pool.ParallelFor(chunks.size(), 1, [&](size_t first, size_t last, unsigned worker) {
+        for (size_t c = first; c < last; c++) {
+            const size_t end = std::min(functionCount, (c + 1) * kFunctionsPerChunk);
+            for (size_t f = c * kFunctionsPerChunk; f < end; f++) {
+                AnalyzeFunction(graph, static_cast<uint32_t>(f), scratch[worker], chunks[c]);
+            }
+        }
+    });
+
+    // Concatenate in function order
+    for (UnflattenChunk& chunk : chunks) {
+        const uint32_t edgeBase = static_cast<uint32_t>(edges.size());
+        const uint32_t blockBase = static_cast<uint32_t>(dispatcherBlocks.size());
+        for (Result result : chunk.results) {
+            result.firstEdge += edgeBase;
+            result.firstDispatcherBlock += blockBase;
+            results.push_back(result);
+        }
+        edges.insert(edges.end(), chunk.edges.begin(), chunk.edges.end());
+        dispatcherBlocks.insert(dispatcherBlocks.end(), chunk.dispatcherBlocks.begin(), chunk.dispatcherBlocks.end());
+        unresolvedCount += chunk.unresolvedCount;
+        chunk = UnflattenChunk();
+    }
+}
+
+void Unflattener::Clear() {
+    results.clear();
+    edges.clear();
+    dispatcherBlocks.clear();
+    unresolvedCount = 0;
+}
+
+const Unflattener::Result* Unflattener::Find(size_t function) const {
+    auto it = std::lower_bound(results.begin(), results.end(), function,
+                               [](const Result& result, size_t value) { return result.function < value; });
+    return it != results.end() && it->function == function ? &*it : nullptr;
+}
+
+std::string Unflattener::DescribeLocation(ElfImage::Machine machine, const StateLocation& location) {
+    static const char* const kX86Names[16] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+                                              "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+    auto registerName = [&](uint8_t reg) -> std::string {
+        if (machine == ElfImage::Machine::X86_64) return reg < 16 ? kX86Names[reg] : "?";
+        return reg == kSp ? "sp" : "x" + std::to_string(reg);
+    };
+    if (location.kind == StateLocation::Register) return registerName(location.reg);
+    if (location.kind != StateLocation::Memory) return "";
+
+    char digits[16];
+    const uint64_t magnitude = location.offset < 0 ? 0 - static_cast<uint64_t>(static_cast<int64_t>(location.offset))
+                                                   : static_cast<uint64_t>(location.offset);
+    std::string text = "[" + registerName(location.reg) + (location.offset < 0 ? "-0x" : "+0x");
+    text.append(digits, FormatHex(digits, magnitude) - digits);
+    text.push_back(']');
+    return text;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ControlFlowGraph.h"
+
+class ThreadPool;
+
+// Recovers the original edges of functions whose control flow was flattened
+// into a dispatcher loop: a state variable, a tree of compares on it, and
+// case blocks that store the next state and jump back.
+//
+// In each function the blocks that only compare one location (a register or
+// a stack slot, followed through copies) against constants are taken as the
+// dispatcher. Every edge into it from the rest of the function is then
+// replayed: the source block and the compare tree are evaluated over a small
+// constant-propagation state, and the block the tree leads to is the edge the
+// obfuscator removed. A case that picks its next state with cmov/csel gets
+// one edge per outcome.
+//
+// Per-function work is bounded: instructions are decoded once into reused
+// per-worker buffers and each replay visits at most kMaxDispatchSteps
+// dispatcher blocks. Functions are processed in parallel.
+class Unflattener {
+public:
+    static constexpr uint32_t kMaxDispatchSteps = 64;
+
+    // Where the state variable lives
+    struct StateLocation {
+        enum Kind : uint8_t { None, Register, Memory };
+        Kind kind;
+        uint8_t reg;        // Register, or the base of [reg + offset]
+        int32_t offset;     // Memory only
+
+        bool operator==(const StateLocation& other) const {
+            return kind == other.kind && reg == other.reg && offset == other.offset;
+        }
+    };
+
+    enum class EdgeKind : uint8_t {
+        Direct,
+        SelectTrue,         // Taken when the case's cmov/csel condition holds
+        SelectFalse,
+    };
+
+    // A recovered edge; it replaces successor slot `slot` of `from`, which
+    // led into the dispatcher
+    struct Edge {
+        uint32_t from;      // Block index within the function
+        uint32_t to;
+        uint8_t slot;
+        EdgeKind kind;
+    };
+
+    struct Result {
+        uint32_t function;              // Index into the ControlFlowGraph
+        StateLocation state;
+        uint32_t firstDispatcherBlock;  // Into the shared dispatcher block list
+        uint32_t dispatcherBlockCount;
+        uint32_t firstEdge;             // Into the shared edge list
+        uint32_t edgeCount;
+        uint32_t unresolvedCount;       // Edges into the dispatcher that could not be replayed
+    };
+
+    // Analyzes every function of graph; only flattened ones get a Result
+    void Run(const ControlFlowGraph& graph, ThreadPool& pool);
+    void Clear();
+
+    size_t FlattenedCount() const { return results.size(); }
+    size_t EdgeCount() const { return edges.size(); }
+    size_t UnresolvedCount() const { return unresolvedCount; }
+
+    const std::vector<Result>& GetResults() const { return results; }
+    // Result for a function index, nullptr if it is not flattened
+    const Result* Find(size_t function) const;
+    const Edge* GetEdges(const Result& result) const { return edges.data() + result.firstEdge; }
+    // Sorted block indices
+    const uint32_t* GetDispatcherBlocks(const Result& result) const {
+        return dispatcherBlocks.data() + result.firstDispatcherBlock;
+    }
+
+    // "rbx", "[rbp-0x14]", "x8", "[sp+0xc]"
+    static std::string DescribeLocation(ElfImage::Machine machine, const StateLocation& location);
+
+private:
+    std::vector<Result> results;        // Sorted by function
+    std::vector<Edge> edges;
+    std::vector<uint32_t> dispatcherBlocks;
+    size_t unresolvedCount = 0;
+};
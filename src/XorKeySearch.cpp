@@ -0,0 +1,212 @@
+#include "XorKeySearch.h"
+#include "CpuFeatures.h"
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if IL2CPP_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// Every kernel fills printable[key] and letters[key] for keys 1..255.
+//
+// The vector kernels XOR a whole block with the broadcast key, classify all lanes
+// with range compares and accumulate the lane masks into per-lane byte counters.
+// The last partial block is zero-padded: a zero byte decodes to NUL, which counts
+// as printable and never as a letter, so the padding is simply subtracted from
+// the printable total afterwards.
+
+namespace {
+
+struct ByteClassTable {
+    uint8_t printable[256];
+    uint8_t letter[256];
+    ByteClassTable() {
+        for (int c = 0; c < 256; c++) {
+            printable[c] = (c == 0 || (c >= 0x20 && c <= 0x7E)) ? 1 : 0;
+            letter[c] = ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) ? 1 : 0;
+        }
+    }
+};
+const ByteClassTable kByteClass;
+
+[[maybe_unused]] void ScoreKeysScalar(const unsigned char* data, size_t length, uint32_t* printable, uint32_t* letters) {
+    for (int key = 1; key < 256; key++) {
+        uint32_t p = 0, l = 0;
+        for (size_t i = 0; i < length; i++) {
+            unsigned char x = data[i] ? static_cast<unsigned char>(data[i] ^ key) : 0;
+            p += kByteClass.printable[x];
+            l += kByteClass.letter[x];
+        }
+        printable[key] = p;
+        letters[key] = l;
+    }
+}
+
+#if defined(__SSE2__)
+
+inline uint32_t SumBytes(__m128i counters) {
+    __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+    return static_cast<uint32_t>(_mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4));
+}
+
+void ScoreKeysSSE2(const unsigned char* data, size_t length, uint32_t* printable, uint32_t* letters) {
+    const size_t fullBlocks = length / 16;
+    const size_t tail = length % 16;
+    alignas(16) unsigned char lastBlock[16] = {0};
+    if (tail) {
+        memcpy(lastBlock, data + fullBlocks * 16, tail);
+    }
+    const size_t blocks = fullBlocks + (tail ? 1 : 0);
+    const uint32_t padding = tail ? static_cast<uint32_t>(16 - tail) : 0;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i printBase = _mm_set1_epi8(0x20);
+    const __m128i printLimit = _mm_set1_epi8(static_cast<char>(0x5F - 0x80));   // 0x20..0x7E
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i letterBase = _mm_set1_epi8('a');
+    const __m128i letterLimit = _mm_set1_epi8(static_cast<char>(26 - 0x80));
+
+    for (int key = 1; key < 256; key++) {
+        const __m128i k = _mm_set1_epi8(static_cast<char>(key));
+        __m128i printAcc = zero, letterAcc = zero;
+        uint32_t p = 0, l = 0;
+        size_t pending = 0;
+
+        for (size_t b = 0; b < blocks; b++) {
+            const unsigned char* src = (b < fullBlocks) ? data + b * 16 : lastBlock;
+            __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            __m128i x = _mm_andnot_si128(_mm_cmpeq_epi8(c, zero), _mm_xor_si128(c, k));
+
+            __m128i isPrint = _mm_cmplt_epi8(_mm_xor_si128(_mm_sub_epi8(x, printBase), bias), printLimit);
+            isPrint = _mm_or_si128(isPrint, _mm_cmpeq_epi8(x, zero));
+            __m128i isLetter = _mm_cmplt_epi8(
+                _mm_xor_si128(_mm_sub_epi8(_mm_or_si128(x, caseBit), letterBase), bias), letterLimit);
+
+            // Masks are 0xFF (-1) per matching lane
+            printAcc = _mm_sub_epi8(printAcc, isPrint);
+            letterAcc = _mm_sub_epi8(letterAcc, isLetter);
+            if (++pending == 255) {
+                p += SumBytes(printAcc);
+                l += SumBytes(letterAcc);
+                printAcc = letterAcc = zero;
+                pending = 0;
+            }
+        }
+        printable[key] = p + SumBytes(printAcc) - padding;
+        letters[key] = l + SumBytes(letterAcc);
+    }
+}
+
+#endif
+
+#if IL2CPP_X86_DISPATCH
+
+IL2CPP_TARGET("avx2") inline uint32_t SumBytesAVX2(__m256i counters) {
+    __m256i sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+    __m128i folded = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), folded);
+    return static_cast<uint32_t>(lanes[0] + lanes[1]);
+}
+
+IL2CPP_TARGET("avx2")
+void ScoreKeysAVX2(const unsigned char* data, size_t length, uint32_t* printable, uint32_t* letters) {
+    const size_t fullBlocks = length / 32;
+    const size_t tail = length % 32;
+    alignas(32) unsigned char lastBlock[32] = {0};
+    if (tail) {
+        memcpy(lastBlock, data + fullBlocks * 32, tail);
+    }
+    const size_t blocks = fullBlocks + (tail ? 1 : 0);
+    const uint32_t padding = tail ? static_cast<uint32_t>(32 - tail) : 0;
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i bias = _mm256_set1_epi8(static_cast<char>(0x80));
+    const __m256i printBase = _mm256_set1_epi8(0x20);
+    const __m256i printLimit = _mm256_set1_epi8(static_cast<char>(0x5F - 0x80));
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i letterBase = _mm256_set1_epi8('a');
+    const __m256i letterLimit = _mm256_set1_epi8(static_cast<char>(26 - 0x80));
+
+    for (int key = 1; key < 256; key++) {
+        const __m256i k = _mm256_set1_epi8(static_cast<char>(key));
+        __m256i printAcc = zero, letterAcc = zero;
+        uint32_t p = 0, l = 0;
+        size_t pending = 0;
+
+        for (size_t b = 0; b < blocks; b++) {
+            const unsigned char* src = (b < fullBlocks) ? data + b * 32 : lastBlock;
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+            __m256i x = _mm256_andnot_si256(_mm256_cmpeq_epi8(c, zero), _mm256_xor_si256(c, k));
+
+            // AVX2 only has a signed greater-than, so compare limit > biased value
+            __m256i isPrint = _mm256_cmpgt_epi8(printLimit,
+                _mm256_xor_si256(_mm256_sub_epi8(x, printBase), bias));
+            isPrint = _mm256_or_si256(isPrint, _mm256_cmpeq_epi8(x, zero));
+            __m256i isLetter = _mm256_cmpgt_epi8(letterLimit,
+                _mm256_xor_si256(_mm256_sub_epi8(_mm256_or_si256(x, caseBit), letterBase), bias));
+
+            printAcc = _mm256_sub_epi8(printAcc, isPrint);
+            letterAcc = _mm256_sub_epi8(letterAcc, isLetter);
+            if (++pending == 255) {
+                p += SumBytesAVX2(printAcc);
+                l += SumBytesAVX2(letterAcc);
+                printAcc = letterAcc = zero;
+                pending = 0;
+            }
+        }
+        printable[key] = p + SumBytesAVX2(printAcc) - padding;
+        letters[key] = l + SumBytesAVX2(letterAcc);
+    }
+}
+
+#endif
+
+void ScoreKeys(const unsigned char* data, size_t length, uint32_t* printable, uint32_t* letters) {
+#if IL2CPP_X86_DISPATCH
+    if (length >= 32 && CpuHasAVX2()) {
+        ScoreKeysAVX2(data, length, printable, letters);
+        return;
+    }
+#endif
+#if defined(__SSE2__)
+    ScoreKeysSSE2(data, length, printable, letters);
+#else
+    ScoreKeysScalar(data, length, printable, letters);
+#endif
+}
+
+} // namespace
+
+XorKeyScore FindBestXorKey(const unsigned char* data, size_t length) {
+    XorKeyScore best = {0, 0, 0};
+    if (length == 0) return best;
+
+    uint32_t printable[256];
+    uint32_t letters[256];
+    ScoreKeys(data, length, printable, letters);
+
+    // Same acceptance threshold the per-key loop used
+    const uint64_t threshold = static_cast<uint64_t>(length * 0.8);
+    uint64_t bestScore = 0;
+    for (int key = 1; key < 256; key++) {
+        if (printable[key] <= threshold) continue;
+        uint64_t score = static_cast<uint64_t>(printable[key]) + letters[key];
+        if (best.key == 0 || score > bestScore) {
+            best.key = static_cast<uint8_t>(key);
+            best.printable = printable[key];
+            best.letters = letters[key];
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+void XorDecode(const unsigned char* data, size_t length, uint8_t key, char* out) {
+    for (size_t i = 0; i < length; i++) {
+        out[i] = static_cast<char>(data[i] ? data[i] ^ key : 0);
+    }
+}
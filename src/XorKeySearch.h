@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Result of scoring every single-byte XOR key against one encrypted string
+struct XorKeyScore {
+    uint8_t key;          // Best key, 0 if no key decodes to mostly printable text
+    uint32_t printable;   // Printable bytes after decoding (NUL counts as printable)
+    uint32_t letters;     // ASCII letters after decoding
+};
+
+// Tests keys 1..255 against data without materializing any candidate. NUL bytes
+// are left untouched, as the decryption routines do. A key qualifies when more
+// than 80% of the decoded bytes are printable; among those the one with the
+// highest printable + letter count wins (lowest key on ties).
+XorKeyScore FindBestXorKey(const unsigned char* data, size_t length);
+
+// Decodes data with key into out (length bytes), leaving NUL bytes as they are
+void XorDecode(const unsigned char* data, size_t length, uint8_t key, char* out);
@@ -28,6 +28,47 @@ typedef uint32_t ImageIndex;
 
 const int32_t kMetadataInvalidPointer = 0xFFFFFFFF;
 
+// Kind of an Il2CppType, the runtime's Il2CppTypeEnum
+enum Il2CppTypeEnum : uint8_t {
+    IL2CPP_TYPE_END = 0x00,
+    IL2CPP_TYPE_VOID = 0x01,
+    IL2CPP_TYPE_BOOLEAN = 0x02,
+    IL2CPP_TYPE_CHAR = 0x03,
+    IL2CPP_TYPE_I1 = 0x04,
+    IL2CPP_TYPE_U1 = 0x05,
+    IL2CPP_TYPE_I2 = 0x06,
+    IL2CPP_TYPE_U2 = 0x07,
+    IL2CPP_TYPE_I4 = 0x08,
+    IL2CPP_TYPE_U4 = 0x09,
+    IL2CPP_TYPE_I8 = 0x0a,
+    IL2CPP_TYPE_U8 = 0x0b,
+    IL2CPP_TYPE_R4 = 0x0c,
+    IL2CPP_TYPE_R8 = 0x0d,
+    IL2CPP_TYPE_STRING = 0x0e,
+    IL2CPP_TYPE_PTR = 0x0f,
+    IL2CPP_TYPE_BYREF = 0x10,
+    IL2CPP_TYPE_VALUETYPE = 0x11,
+    IL2CPP_TYPE_CLASS = 0x12,
+    IL2CPP_TYPE_VAR = 0x13,
+    IL2CPP_TYPE_ARRAY = 0x14,
+    IL2CPP_TYPE_GENERICINST = 0x15,
+    IL2CPP_TYPE_TYPEDBYREF = 0x16,
+    IL2CPP_TYPE_I = 0x18,
+    IL2CPP_TYPE_U = 0x19,
+    IL2CPP_TYPE_FNPTR = 0x1b,
+    IL2CPP_TYPE_OBJECT = 0x1c,
+    IL2CPP_TYPE_SZARRAY = 0x1d,
+    IL2CPP_TYPE_MVAR = 0x1e,
+    IL2CPP_TYPE_ENUM = 0x55,
+};
+
+// Parameter attributes, carried in the attrs of a parameter's Il2CppType
+const uint16_t kParamAttributeIn = 0x0001;
+const uint16_t kParamAttributeOut = 0x0002;
+
+// The header and records below are the in-memory form the loader works
+// with, which is how v24.2-v24.5 files store them; MetadataLayout.h has the
+// layouts of the other versions.
 struct Il2CppGlobalMetadataHeader {
     int32_t sanity;
     int32_t version;
@@ -159,9 +200,34 @@ struct Il2CppParameterDefinition {
     TypeIndex typeIndex;
 };
 
+// Generic parameters of a type (is_method = 0) or method (is_method = 1)
+struct Il2CppGenericContainer {
+    uint32_t ownerIndex;    // TypeDefinitionIndex or MethodIndex
+    int32_t type_argc;
+    int32_t is_method;
+    GenericParameterIndex genericParameterStart;
+};
+
+struct Il2CppGenericParameter {
+    GenericContainerIndex ownerIndex;
+    StringIndex nameIndex;
+    int16_t constraintsStart;   // Into the constraints table of TypeIndex values
+    int16_t constraintsCount;
+    uint16_t num;
+    uint16_t flags;
+};
+
+// Generic parameter flags
+const uint16_t kGenericParameterCovariant = 0x0001;
+const uint16_t kGenericParameterContravariant = 0x0002;
+const uint16_t kGenericParameterReferenceTypeConstraint = 0x0004;
+const uint16_t kGenericParameterValueTypeConstraint = 0x0008;
+const uint16_t kGenericParameterDefaultConstructorConstraint = 0x0010;
+
+// Fields are owned through their type's fieldStart range; the record has no
+// declaring type
 struct Il2CppFieldDefinition {
     StringIndex nameIndex;
-    TypeDefinitionIndex declaringType;
     TypeIndex typeIndex;
     uint32_t token;
 };
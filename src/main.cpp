@@ -1,21 +1,114 @@
 #include <iostream>
 #include <fstream>
+#include <cctype>
 #include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
 #include "MetadataLoader.h"
 
+static void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options] <path_to_global-metadata.dat> [path_to_libil2cpp.so]" << std::endl;
+    std::cerr << "       Use '-' to read the metadata from stdin." << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --threads N        Worker threads for parallel passes, up to 1024 (default: all cores)" << std::endl;
+    std::cerr << "  --cs-dir DIR       Write one .cs file per assembly into DIR instead of dump.cs" << std::endl;
+    std::cerr << "  --ndjson           Write script.ndjson (one record per line) instead of script.json" << std::endl;
+    std::cerr << "  --binary           Also write the compact binary tables to script.il2b" << std::endl;
+    std::cerr << "  --no-json          Skip script.json (use with --binary)" << std::endl;
+    std::cerr << "  --signatures FILE  Extra byte signatures to look for in the library" << std::endl;
+    std::cerr << "  --cfg FILE         Unflatten control flow and write the graphs to FILE (.dot for Graphviz)" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <path_to_global-metadata.dat>" << std::endl;
+    std::vector<std::string> positional;
+    unsigned threads = 0;
+    std::string csDir;
+    bool jsonLines = false;
+    bool writeJson = true;
+    bool writeBinary = false;
+    std::vector<std::string> signatureFiles;
+    std::string cfgPath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            // 1..1024 threads, or 0 for all cores
+            const char* value = argv[++i];
+            char* end = nullptr;
+            unsigned long count = std::strtoul(value, &end, 10);
+            if (!std::isdigit(static_cast<unsigned char>(value[0])) || *end != '\0' || count > 1024) {
+                std::cerr << "Invalid thread count: " << value << std::endl;
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            threads = static_cast<unsigned>(count);
+        } else if (arg == "--cs-dir") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            csDir = argv[++i];
+        } else if (arg == "--ndjson") {
+            jsonLines = true;
+        } else if (arg == "--signatures") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            signatureFiles.push_back(argv[++i]);
+        } else if (arg == "--cfg") {
+            if (i + 1 >= argc) {
+                PrintUsage(argv[0]);
+                return 1;
+            }
+            cfgPath = argv[++i];
+        } else if (arg == "--binary") {
+            writeBinary = true;
+        } else if (arg == "--no-json") {
+            writeJson = false;
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.empty()) {
+        PrintUsage(argv[0]);
         return 1;
     }
 
-    std::string metadataPath = argv[1];
+    std::string metadataPath = positional[0];
     MetadataLoader loader;
+    loader.SetThreadCount(threads);
+    loader.SetCSOutputDirectory(csDir);
+    loader.SetJsonLines(jsonLines);
+    loader.SetScriptOutputs(writeJson, writeBinary);
+    loader.SetControlFlowOutput(cfgPath);
+    for (const auto& path : signatureFiles) {
+        if (!loader.LoadSignatureFile(path)) {
+            std::cerr << "Warning: Failed to load signatures from " << path << std::endl;
+        }
+    }
+    loader.SetProgressCallback([](const char* task, uint64_t done, uint64_t total) {
+        // Redraw a single status line on stderr, at most once per percent
+        static uint64_t lastPercent = ~uint64_t(0);
+        uint64_t percent = total ? done * 100 / total : 100;
+        if (percent == lastPercent && done != total) return;
+        lastPercent = done == total ? ~uint64_t(0) : percent;
+        std::cerr << "\r[*] " << task << ": " << done << "/" << total << " (" << percent << "%)";
+        if (done == total) std::cerr << std::endl;
+    });
 
     std::cout << "Target: " << metadataPath << std::endl;
 
-    if (argc >= 3) {
-        std::string libPath = argv[2];
+    if (positional.size() >= 2) {
+        std::string libPath = positional[1];
         std::cout << "Library: " << libPath << std::endl;
         if (!loader.LoadLibrary(libPath)) {
             std::cerr << "Warning: Failed to load library." << std::endl;